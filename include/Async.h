@@ -0,0 +1,245 @@
+#pragma once
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Single-threaded event loop. Any thread may post a job; jobs run in order on the thread that
+ * calls run(). Coroutines that touch OrderManager are only ever resumed from here, so the manager
+ * keeps its single-threaded contract while I/O and input happen elsewhere.
+ */
+class EventLoop {
+public:
+    void post(std::function<void()> job);
+    /** Runs jobs until stop() is called. */
+    void run();
+    void stop();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> jobs_;
+    bool stopped_{false};
+};
+
+/** Fixed set of threads running submitted jobs FIFO; used for blocking file I/O. */
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t threads = 2);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(std::function<void()> job);
+
+private:
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<std::function<void()>> jobs_;
+    std::vector<std::thread> threads_;
+    bool stopping_{false};
+};
+
+/**
+ * Lazily started coroutine. co_await on a Task runs it and resumes the awaiter when it finishes
+ * (symmetric transfer, so chains of awaits do not grow the stack); spawn() starts a Task that
+ * owns itself and frees its frame on completion.
+ */
+template <typename T = void>
+class Task;
+
+namespace detail {
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;
+    bool detached{false};
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept {
+            TaskPromiseBase& p = h.promise();
+            if (p.continuation) return p.continuation;
+            if (p.detached) h.destroy();
+            return std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { std::terminate(); }
+};
+}
+
+template <typename T>
+class Task {
+public:
+    struct promise_type : detail::TaskPromiseBase {
+        std::optional<T> value;
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_value(T v) { value = std::move(v); }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task(const Task&) = delete;
+    ~Task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    T await_resume() { return std::move(*handle_.promise().value); }
+
+private:
+    template <typename U>
+    friend void spawn(Task<U> task);
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <>
+class Task<void> {
+public:
+    struct promise_type : detail::TaskPromiseBase {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_void() {}
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task(const Task&) = delete;
+    ~Task() { if (handle_) handle_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+    void await_resume() {}
+
+private:
+    template <typename U>
+    friend void spawn(Task<U> task);
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/** Starts task on the current thread; its frame is freed when it completes. */
+template <typename T>
+void spawn(Task<T> task) {
+    auto h = std::exchange(task.handle_, {});
+    h.promise().detached = true;
+    h.resume();
+}
+
+/**
+ * Awaitable that runs job on the worker pool and resumes the awaiting coroutine on the event
+ * loop with job's result. job must not touch loop-owned state.
+ */
+class Offload {
+public:
+    Offload(WorkerPool& pool, EventLoop& loop, std::function<bool()> job)
+        : pool_(pool), loop_(loop), job_(std::move(job)) {}
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> h) {
+        pool_.submit([this, h] {
+            result_ = job_();
+            loop_.post([h] { h.resume(); });
+        });
+    }
+    bool await_resume() const noexcept { return result_; }
+
+private:
+    WorkerPool& pool_;
+    EventLoop& loop_;
+    std::function<bool()> job_;
+    bool result_{false};
+};
+
+/**
+ * FIFO lock for coroutines on the event loop (not thread-safe). Holders of the lock run one at
+ * a time, in request order, without blocking the loop.
+ */
+class AsyncMutex {
+public:
+    struct Acquire {
+        AsyncMutex& mutex;
+        bool await_ready() noexcept {
+            if (mutex.locked_) return false;
+            mutex.locked_ = true;
+            return true;
+        }
+        void await_suspend(std::coroutine_handle<> h) { mutex.waiters_.push_back(h); }
+        void await_resume() noexcept {}
+    };
+
+    explicit AsyncMutex(EventLoop& loop) : loop_(loop) {}
+    Acquire lock() { return Acquire{*this}; }
+    /** Hands the lock to the next waiter (resumed through the loop) or frees it. */
+    void unlock();
+    bool locked() const { return locked_; }
+
+private:
+    EventLoop& loop_;
+    std::deque<std::coroutine_handle<>> waiters_;
+    bool locked_{false};
+};
+
+/**
+ * A line-oriented command source (stdin, a feed file or FIFO). A reader thread pulls lines and
+ * posts them to the loop; a session coroutine awaits them with nextLine(), including follow-up
+ * prompts of multi-line commands, so sources interleave only between reads. nextLine() yields
+ * nullopt at end of input.
+ */
+class CommandSource {
+public:
+    struct NextLine {
+        CommandSource& source;
+        bool await_ready() const noexcept { return !source.lines_.empty() || source.closed_; }
+        void await_suspend(std::coroutine_handle<> h) { source.waiting_ = h; }
+        std::optional<std::string> await_resume();
+    };
+
+    CommandSource(EventLoop& loop, std::string name);
+    ~CommandSource();
+    CommandSource(const CommandSource&) = delete;
+    CommandSource& operator=(const CommandSource&) = delete;
+
+    /** Starts the reader thread on in (stdin); in must outlive the process's use of the source. */
+    void start(std::istream& in);
+    /** Starts the reader thread on a file or FIFO it owns; false if path cannot be opened. */
+    bool open(const std::string& path);
+    NextLine nextLine() { return NextLine{*this}; }
+    const std::string& name() const { return name_; }
+
+private:
+    /** Shared with the reader thread so a reader outliving the source stops posting. */
+    struct ReaderLink {
+        std::mutex mutex;
+        CommandSource* source{nullptr};
+    };
+
+    EventLoop& loop_;
+    std::string name_;
+    std::shared_ptr<ReaderLink> link_;
+    std::thread reader_;
+    std::deque<std::string> lines_;
+    bool closed_{false};
+    std::coroutine_handle<> waiting_;
+
+    void startReader(std::istream& in, std::shared_ptr<std::istream> owned);
+    /** Loop-thread side of the reader: queue the line (or close) and wake the waiting session. */
+    void deliver(std::optional<std::string> line);
+};
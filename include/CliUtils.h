@@ -3,15 +3,34 @@
 #include <string>
 #include <vector>
 
+#include "Async.h"
 #include "OrderManager.h"
+#include "TableRenderer.h"
 
 void clearScreen();
-std::string readLine();
-bool readPositiveInt(const std::string& prompt, int& out);
-bool gatherOrderInput(OrderManager& manager, std::string& customer, bool& vip, int& estimate, std::vector<OrderItem>& items);
+/** Prompt helpers await their answers from the command source that issued the command. */
+Task<std::string> readLine(CommandSource& in);
+Task<bool> readPositiveInt(CommandSource& in, std::string prompt, int& out);
+Task<bool> gatherOrderInput(CommandSource& in, OrderManager& manager, std::string& customer, bool& vip, int& estimate, std::vector<OrderItem>& items);
 bool parseId(const std::string& token, int& out);
+/**
+ * Parses a time: HH:MM (today, local), -<N>m / -<N>h (relative to now) or epoch seconds. now is
+ * the manager's clock in epoch seconds, so relative times follow a simulated clock too.
+ */
+bool parseTimeToken(const std::string& token, long long now, long long& out);
+/** Parses a positive duration [+]<N>s, <N>m or <N>h into seconds. */
+bool parseDuration(const std::string& token, long long& seconds);
+/**
+ * Parses listing options (--limit N, --newest, --after <id>, --since/--until <time>, --served);
+ * the first plain token lands in positional.
+ */
+bool parseListOptions(OrderManager& manager, const std::vector<std::string>& args, ListQuery& query, std::string& positional);
 void printHelp();
 void printOrder(const Order& o);
-void printOrdersTable(const std::vector<Order>& orders);
+/** Prints the orders table through renderer, reusing buffer for the text (both owned by the caller). */
+void printOrdersTable(TableRenderer& renderer, std::string& buffer, const std::vector<Order>& orders);
 void printMenuTable(const std::vector<MenuItem>& items);
+void printWorkflow(const WorkflowEngine& workflow);
+/** Drains ring and prints one line per event, then the ring's overflow counter. */
+void printEvents(const WorkflowEngine& workflow, OrderEventRing& ring);
 void sortOrders(std::vector<Order>& orders, const std::string& metric);
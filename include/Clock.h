@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+/**
+ * Source of the wall-clock time OrderManager stamps orders with. Swapping it lets tests and
+ * simulations run a service at any speed, with reproducible timestamps. Every implementation
+ * here has nanosecond resolution and may be read from several threads (ShardedManager shares
+ * one clock across its branches).
+ */
+class ServiceClock {
+public:
+    using time_point = std::chrono::system_clock::time_point;
+    virtual ~ServiceClock() = default;
+    virtual time_point now() = 0;
+};
+
+/** The system clock. It can step backwards when the host clock is adjusted. */
+class RealClock : public ServiceClock {
+public:
+    time_point now() override { return std::chrono::system_clock::now(); }
+    /** Shared default for managers that are not given a clock. */
+    static RealClock& instance();
+};
+
+/**
+ * Wall time that never goes backwards: the system time at construction plus steady-clock time
+ * elapsed since, multiplied by rate. A rate above 1 is time-warp mode: at rate 60, one real minute
+ * runs an hour of service.
+ */
+class MonotonicClock : public ServiceClock {
+public:
+    explicit MonotonicClock(double rate = 1.0);
+    time_point now() override;
+    double rate() const { return rate_; }
+
+private:
+    time_point wallStart_;
+    std::chrono::steady_clock::time_point steadyStart_;
+    double rate_;
+};
+
+/**
+ * Simulated time that moves only when told to: advance, advanceTo, or the optional tick added
+ * after every read, which gives each stamp a distinct time. The same sequence of calls always
+ * produces the same stamps, so simulated services replay exactly, VIP order included.
+ */
+class VirtualClock : public ServiceClock {
+public:
+    explicit VirtualClock(time_point start, std::chrono::nanoseconds tick = std::chrono::nanoseconds(0));
+    time_point now() override;
+    /** Current time without consuming a tick. */
+    time_point peek() const;
+    void advance(std::chrono::nanoseconds by);
+    /** Moves to at; earlier times are ignored, so the clock never runs backwards. */
+    void advanceTo(time_point at);
+
+private:
+    std::atomic<long long> nanos_;
+    long long tick_;
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Customer-name search over order ids. Names are lowercased into a trie stored in one node
+ * array (first-child/next-sibling links, siblings kept in character order), so a prefix query
+ * walks the prefix and collects the ids below it in name order. Orders with the same name are
+ * chained through a per-id link array, which keeps inserts free of per-node allocations.
+ *
+ * Fuzzy queries ("jon smth" -> "John Smith") use trigram posting lists scored by Jaccard
+ * similarity. Postings are doubly linked entries in one pooled array, and an id's postings are one
+ * contiguous run, so rename and remove unlink exactly the old name's entries in O(trigrams). Freed
+ * runs are reused by length and list heads live in a flat open-addressed table, so re-indexing
+ * allocates nothing once the pool has grown.
+ */
+class CustomerIndex {
+public:
+    CustomerIndex();
+
+    void add(int id, const std::string& name);
+    /** Re-indexes id under a new name; no-op when only the case changed. */
+    void rename(int id, const std::string& oldName, const std::string& newName);
+    void remove(int id);
+    void clear();
+
+    /** Ids whose name starts with prefix (case-insensitive), in name order; at most limit (0 = all). */
+    std::vector<int> prefix(const std::string& prefix, size_t limit = 0) const;
+    /**
+     * Ids whose name has at least minScore trigram similarity with query, best first. Reuses
+     * per-index scratch, so concurrent calls on one index need the caller's lock.
+     */
+    std::vector<int> fuzzy(const std::string& query, size_t limit = 20, double minScore = 0.3) const;
+
+private:
+    struct TrieNode {
+        int parent{-1};
+        int firstChild{-1};
+        int nextSibling{-1};
+        int firstId{0};
+        char ch{0};
+    };
+
+    /** One id's entry in one trigram's posting list. */
+    struct Posting {
+        int id{0};
+        int next{-1};
+        /** Previous entry, or -2 - (gram table slot) for the first entry of a list. */
+        int prev{-1};
+    };
+    static constexpr std::uint32_t kNoGram = UINT32_MAX;
+    struct GramSlot {
+        std::uint32_t gram{kNoGram};
+        int head{-1};
+    };
+
+    std::vector<TrieNode> nodes_;
+    std::vector<Posting> postings_;
+    /** First posting of a free run, by run length; free runs of one length chain through next. */
+    std::vector<int> freeRuns_;
+    /** Trigram -> list head, linear probing over a power-of-two table at most half full. */
+    std::vector<GramSlot> grams_;
+    size_t gramsUsed_{0};
+    int gramBits_{0};
+    /** Per id: next id with the same name (0 ends the chain) and the id's trie node (-1 if none). */
+    std::vector<int> nextSameName_;
+    std::vector<int> nodeById_;
+    /** Per id: first posting of its run (-1 if none) and the run's length (its trigram count). */
+    std::vector<int> runById_;
+    std::vector<int> gramsById_;
+    /** Reused buffers so indexing does not allocate per call. */
+    std::string keyScratch_;
+    std::string oldKeyScratch_;
+    std::vector<std::uint32_t> gramScratch_;
+    /** fuzzy's posting hits per id (all zero between calls) and the ids it touched. */
+    mutable std::vector<std::uint32_t> hitScratch_;
+    mutable std::vector<int> touchedScratch_;
+
+    static void normalize(const std::string& name, std::string& key);
+    static void trigramsOf(const std::string& key, std::vector<std::uint32_t>& out);
+    int child(int node, char c) const;
+    int walk(const std::string& key) const;
+    int walkOrCreate(const std::string& key);
+    void unlink(int id);
+    int findGram(std::uint32_t gram) const;
+    int gramSlot(std::uint32_t gram);
+    int allocRun(size_t length);
+    void addPostings(int id, const std::string& key);
+    void dropPostings(int id);
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fenwick (binary indexed) tree of long long sums over positions 0..size()-1. Point updates and
+ * prefix sums are O(log n); append() grows the tree by one position in O(log n) without a rebuild.
+ */
+class FenwickTree {
+public:
+    /** Adds a position holding value; returns its index. */
+    size_t append(long long value);
+    void add(size_t index, long long delta);
+    /** Sum of positions [0, end). */
+    long long prefix(size_t end) const;
+    size_t size() const { return tree_.size(); }
+    void clear() { tree_.clear(); }
+
+private:
+    /** 1-based: tree_[k - 1] covers positions (k - lowbit(k), k]. */
+    std::vector<long long> tree_;
+};
+
+/**
+ * Running backlog of queued prep minutes per scheduling lane, mirroring nextForKitchen: every
+ * queued VIP order goes before every normal one, VIPs run in heap order (placement time, which
+ * follows order id) and normal orders in FIFO order. The VIP lane is a Fenwick tree indexed by
+ * order id; the normal lane one indexed by enqueue sequence. Enqueue, dequeue, cancel and estimate
+ * changes are point updates, and the minutes ahead of any queued order is one prefix sum, so an
+ * ETA is O(log n) with no re-simulation of the queues.
+ */
+class EtaEngine {
+public:
+    /** Starts tracking id as waiting in the VIP or normal lane. */
+    void enqueue(int id, bool vip, int minutes);
+    /** Applies an edit: new estimate, or a lane change (moving to the back of the normal lane). */
+    void update(int id, bool vip, int minutes);
+    /** Stops tracking id (dequeued for the kitchen, cancelled, ...). */
+    void remove(int id);
+    bool isQueued(int id) const;
+    /** Queued minutes scheduled before id, or -1 if id is not queued. */
+    long long minutesAhead(int id) const;
+    long long backlogMinutes() const { return vipTotal_ + normalTotal_; }
+    void clear();
+
+private:
+    enum Lane : std::uint8_t { None, Vip, Normal };
+    struct Slot {
+        Lane lane{None};
+        size_t position{0};
+        int minutes{0};
+    };
+
+    FenwickTree vip_;
+    FenwickTree normal_;
+    long long vipTotal_{0};
+    long long normalTotal_{0};
+    size_t normalCount_{0};
+    std::vector<Slot> slots_;
+};
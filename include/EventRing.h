@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Order lifecycle event published by OrderManager. Plain fixed-size data so it can be copied
+ * through a ring slot without allocating.
+ */
+enum class OrderEventType : std::uint8_t {
+    Created,
+    Edited,
+    Transitioned,
+    Cancelled
+};
+
+struct OrderEvent {
+    OrderEventType type{OrderEventType::Created};
+    int orderId{0};
+    /** Workflow stage ids (see WorkflowEngine); both equal the current stage for non-transitions. */
+    int fromStage{0};
+    int toStage{0};
+    /** steady_clock nanoseconds at publish time, for consumer-side latency measurement. */
+    long long publishedNanos{0};
+};
+
+namespace OrderEventStrings {
+    std::string toString(OrderEventType type);
+}
+
+/**
+ * Bounded lock-free single-producer/single-consumer ring. Capacity is rounded up to a power of two
+ * so slots are picked with a mask. The producer never blocks: tryPush on a full ring drops the
+ * value and counts it, which is the backpressure signal consumers read through dropped().
+ * Head and tail live on separate cache lines, and each side keeps a cached copy of the other's
+ * index so it only touches the shared line when its cached view says full/empty.
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    /** Producer side: appends value, or drops it and returns false when the ring is full. */
+    bool tryPush(const T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        published_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /** Consumer side: removes the oldest value into out; false if the ring is empty. */
+    bool tryPop(T& out) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) return false;
+        }
+        out = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Consumer side: calls fn(value) for everything currently queued; returns how many. */
+    template <typename Func>
+    size_t drain(Func fn) {
+        size_t count = 0;
+        T value;
+        while (tryPop(value)) {
+            fn(value);
+            ++count;
+        }
+        return count;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+    /** Approximate when read concurrently with the other side. */
+    size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+    /** Values accepted and values dropped because the ring was full. */
+    std::uint64_t published() const { return published_.load(std::memory_order_relaxed); }
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_{0};
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cachedTail_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cachedHead_{0};
+    std::atomic<std::uint64_t> published_{0};
+    std::atomic<std::uint64_t> dropped_{0};
+};
+
+using OrderEventRing = SpscRing<OrderEvent>;
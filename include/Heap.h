@@ -1,13 +1,16 @@
 #pragma once
 #include <vector>
 #include <cstddef>
+#include <utility>
 
 /**
- * Entry for VIP heap. Lower placedAtSeconds means higher priority (earlier arrival wins among VIPs).
+ * Entry for VIP heap. Lower placedAtNanos means higher priority (earlier arrival wins among VIPs);
+ * equal times go to the lower order id.
  */
 struct VipEntry {
     int orderId{0};
-    long long placedAtSeconds{0};
+    /** Placed time in nanoseconds since the epoch, so VIPs placed within one second still rank. */
+    long long placedAtNanos{0};
 };
 
 /**
@@ -19,6 +22,11 @@ public:
 
     /** Adds a VIP entry into the heap. */
     void push(const VipEntry& entry);
+    /**
+     * Adds a batch of entries. Large batches are appended and the whole heap is rebuilt bottom-up
+     * in O(n) instead of paying O(log n) per push.
+     */
+    void pushMany(const std::vector<VipEntry>& entries);
     /** Pops the highest priority entry; returns false if empty. */
     bool pop(VipEntry& out);
     bool empty() const { return data_.empty(); }
@@ -33,3 +41,72 @@ private:
     void heapifyDown(size_t idx);
     static bool higherPriority(const VipEntry& a, const VipEntry& b);
 };
+
+/**
+ * Bounded heap that keeps the `capacity` elements that come first under `before`.
+ * The last kept element sits at the root, so each offer costs O(log capacity).
+ */
+template <typename T, typename Before>
+class TopK {
+public:
+    TopK(size_t capacity, Before before) : capacity_(capacity), before_(before) {
+        data_.reserve(capacity);
+    }
+
+    /** Considers one candidate; returns false if it was rejected. */
+    bool offer(const T& value) {
+        if (capacity_ == 0) return false;
+        if (data_.size() < capacity_) {
+            data_.push_back(value);
+            siftUp(data_.size() - 1);
+            return true;
+        }
+        if (!before_(value, data_[0])) return false;
+        data_[0] = value;
+        siftDown(0);
+        return true;
+    }
+
+    size_t size() const { return data_.size(); }
+
+    /** Empties the heap and returns the kept elements in `before` order. */
+    std::vector<T> drainSorted() {
+        std::vector<T> out(data_.size());
+        for (size_t i = out.size(); i > 0; --i) {
+            out[i - 1] = data_[0];
+            data_[0] = data_.back();
+            data_.pop_back();
+            if (!data_.empty()) siftDown(0);
+        }
+        return out;
+    }
+
+private:
+    size_t capacity_;
+    Before before_;
+    std::vector<T> data_;
+
+    // Max-heap under `before`: a parent never comes before its children.
+    void siftUp(size_t idx) {
+        while (idx > 0) {
+            size_t parent = (idx - 1) / 2;
+            if (!before_(data_[parent], data_[idx])) break;
+            std::swap(data_[idx], data_[parent]);
+            idx = parent;
+        }
+    }
+
+    void siftDown(size_t idx) {
+        size_t n = data_.size();
+        while (true) {
+            size_t left = idx * 2 + 1;
+            size_t right = left + 1;
+            size_t last = idx;
+            if (left < n && before_(data_[last], data_[left])) last = left;
+            if (right < n && before_(data_[last], data_[right])) last = right;
+            if (last == idx) break;
+            std::swap(data_[idx], data_[last]);
+            idx = last;
+        }
+    }
+};
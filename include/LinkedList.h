@@ -3,7 +3,8 @@
 #include <functional>
 
 /**
- * Doubly linked list to store active orders. Provides O(1) removal by node pointer.
+ * Doubly linked list of orders. Provides O(1) removal by node pointer. OrderManager keeps its
+ * orders in the flat OrderRegistry instead, which scans much faster.
  */
 struct OrderNode {
     Order data;
@@ -15,9 +16,16 @@ class OrderList {
 public:
     OrderList();
     ~OrderList();
+    /** The list owns its nodes; a copy would free them twice. */
+    OrderList(const OrderList&) = delete;
+    OrderList& operator=(const OrderList&) = delete;
 
     /** Appends an order and returns the created node. */
     OrderNode* pushBack(const Order& order);
+    /** Appends an order by moving its payload into the new node. */
+    OrderNode* pushBack(Order&& order);
+    /** Appends a default order and returns its node so the caller can fill it in place. */
+    OrderNode* emplaceBack();
     /** Finds a node by id using linear search. */
     OrderNode* findById(int id) const;
     /** Removes the given node pointer. */
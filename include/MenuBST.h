@@ -21,6 +21,14 @@ class MenuBST {
 public:
     MenuBST() = default;
     ~MenuBST();
+    /** The tree owns its nodes: it moves but does not copy. */
+    MenuBST(const MenuBST&) = delete;
+    MenuBST& operator=(const MenuBST&) = delete;
+    MenuBST(MenuBST&& other) noexcept;
+    MenuBST& operator=(MenuBST&& other) noexcept;
+
+    /** Frees every node. */
+    void clear();
 
     /** Inserts item if name is unique. */
     bool insert(const MenuItem& item);
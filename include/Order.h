@@ -33,6 +33,8 @@ struct Order {
     bool isVip{false};
     std::vector<OrderItem> items;
     OrderStatus status{OrderStatus::Placed};
+    /** Custom workflow stage id (see WorkflowEngine); -1 means the standard stage for status. */
+    int stage{-1};
     int estimatedPrepMinutes{0};
 
     std::chrono::system_clock::time_point placedAt{};
@@ -45,6 +47,8 @@ struct Order {
  * Helpers for converting order status to and from strings for persistence.
  */
 namespace OrderStatusStrings {
+    /** Same text as toString without building a string, for hot formatting paths. */
+    const char* name(OrderStatus status);
     std::string toString(OrderStatus status);
     bool fromString(const std::string& text, OrderStatus& out);
 }
@@ -55,4 +59,6 @@ namespace OrderStatusStrings {
 namespace TimeUtils {
     long long toSeconds(const std::chrono::system_clock::time_point& tp);
     std::chrono::system_clock::time_point fromSeconds(long long seconds);
+    long long toNanos(const std::chrono::system_clock::time_point& tp);
+    std::chrono::system_clock::time_point fromNanos(long long nanos);
 }
@@ -0,0 +1,107 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "CustomerIndex.h"
+#include "Order.h"
+
+/**
+ * Byte-level LZ77 codec for archive blocks (LZ4-style sequences: a token with literal and match
+ * lengths, the literals, then a 16-bit back offset). Greedy matching through a hash of the next
+ * four bytes; no entropy stage, so decoding is a copy loop.
+ */
+namespace BlockCodec {
+    void compress(const std::string& in, std::string& out);
+    /** Decodes exactly rawSize bytes; false on malformed input instead of reading out of bounds. */
+    bool decompress(const char* data, size_t size, size_t rawSize, std::string& out);
+}
+
+/**
+ * Index entry of one archive block: where it is, and the id and time ranges it covers, so
+ * lookups and range reports only decompress the blocks that can match.
+ */
+struct ArchiveBlockInfo {
+    uint64_t offset{0};
+    uint32_t size{0};
+    uint32_t rawSize{0};
+    uint32_t count{0};
+    /** FNV-1a over the compressed bytes. */
+    uint32_t checksum{0};
+    int32_t minId{0};
+    int32_t maxId{0};
+    int64_t minPlaced{0};
+    int64_t maxPlaced{0};
+    /** Served-time range of the block's served orders; minServed > maxServed when it has none. */
+    int64_t minServed{0};
+    int64_t maxServed{0};
+};
+
+/**
+ * Append-only archive of finished orders. Orders are packed by id into blocks of kBlockOrders,
+ * each encoded column by column: zigzag varint deltas for ids and placed times, the other
+ * timestamps as offsets from placed time, and customer and item names through a per-block
+ * dictionary. Each block is then compressed with BlockCodec. Times keep whole seconds, as in
+ * saved state files.
+ *
+ * File: a 32-byte header pointing at the block index, the blocks, then the index. An append
+ * writes its blocks and a fresh index after the old one and only then repoints the header, so a
+ * crash mid-append leaves the previous archive intact (the old index becomes dead space).
+ * The index stays in memory; blocks are read with pread, so const reads are safe from any thread.
+ * Customer names are indexed in memory too (one full decode at open), for name search.
+ */
+class OrderArchive {
+public:
+    static constexpr size_t kBlockOrders = 4096;
+
+    OrderArchive() = default;
+    ~OrderArchive();
+    OrderArchive(const OrderArchive&) = delete;
+    OrderArchive& operator=(const OrderArchive&) = delete;
+
+    /** Opens path, creating an empty archive if it does not exist. */
+    bool open(const std::string& path, std::string* error = nullptr);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    /** Appends orders (sorted by id here) as new blocks and makes them durable before returning. */
+    bool append(std::vector<Order>& orders, std::string* error = nullptr);
+
+    /** Finds an archived order by id; only blocks whose id range holds id are decompressed. */
+    bool find(int id, Order& out) const;
+    /**
+     * Calls fn for archived orders placed (byServed: served) in [from, to) epoch seconds, block
+     * by block in archive order, not sorted; 0 leaves that side open. Returns the number of
+     * blocks decompressed.
+     */
+    size_t forEachInRange(long long from, long long to, bool byServed, const std::function<void(const Order&)>& fn) const;
+    /** Every archived order, block by block. */
+    void forEach(const std::function<void(const Order&)>& fn) const;
+    /**
+     * Archived orders whose customer name starts with prefix (case-insensitive), in name order.
+     * With allowFuzzy, falls back to the closest names when none does and sets *fuzzy.
+     */
+    std::vector<Order> findByCustomer(const std::string& prefix, size_t limit, bool allowFuzzy, bool* fuzzy = nullptr) const;
+
+    const std::vector<ArchiveBlockInfo>& blocks() const { return blocks_; }
+    uint64_t orderCount() const { return orderCount_; }
+    uint64_t fileBytes() const { return fileBytes_; }
+
+    /** Encodes orders (sorted by id) into one uncompressed block and fills info's ranges. */
+    static void encodeBlock(const Order* orders, size_t count, std::string& out, ArchiveBlockInfo& info);
+    /** Appends the block's orders to out; a non-zero onlyId decodes just that order, if present. */
+    static bool decodeBlock(const std::string& raw, std::vector<Order>& out, int onlyId = 0);
+
+private:
+    struct Header;
+
+    int fd_{-1};
+    std::vector<ArchiveBlockInfo> blocks_;
+    uint64_t orderCount_{0};
+    uint64_t fileBytes_{0};
+    CustomerIndex customers_;
+
+    /** Reads, verifies and decodes block i (see decodeBlock for onlyId). */
+    bool readBlock(size_t i, std::vector<Order>& out, int onlyId = 0) const;
+};
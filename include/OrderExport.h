@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "Order.h"
+#include "OrderSnapshot.h"
+
+class OrderArchive;
+
+/**
+ * Streams orders into files for spreadsheets and BI tools without building a list of them.
+ * Archived orders are read block by block, then live orders straight from an OrderSnapshot, in
+ * chunks of chunkRows rows. A batch of `threads` chunks is encoded in parallel, each into its own
+ * buffer, and written in order with one call per chunk, so memory stays at about
+ * threads x chunkRows rows however large the export is. The file is replaced atomically.
+ *
+ * CSV (RFC 4180, UTF-8, header row): id, customer, vip, status, stage, estimate_minutes,
+ * placed_at, started_at, ready_at, served_at (ISO 8601 UTC, empty when unset), items
+ * ("2x Margherita; 1x Tea"), archived.
+ *
+ * Columnar (little-endian): "ORDCOL01", one row group per chunk, then a footer listing the row
+ * groups (offset, rows), the group count and total rows, the footer length and the magic again.
+ * A row group is its row count followed by the columns of ColumnarColumn, each prefixed with its
+ * byte length. Numbers are fixed-width arrays; strings are rows + 1 uint32 offsets then the bytes.
+ * Items are flattened: item_count per order, then one entry per item in the item_* columns.
+ */
+namespace OrderExport {
+    enum class Format { Csv, Columnar };
+
+    /** Columns of a columnar row group, in file order. Times are int64 epoch seconds, 0 = unset. */
+    enum ColumnarColumn {
+        ColId,           // int32
+        ColCustomer,     // string
+        ColVip,          // uint8
+        ColStatus,       // uint8, OrderStatus
+        ColStage,        // string, workflow stage name
+        ColEstimate,     // int32 minutes
+        ColPlaced,
+        ColStarted,
+        ColReady,
+        ColServed,
+        ColItemCount,    // uint32 per order
+        ColItemId,       // int32 per item
+        ColItemName,     // string per item
+        ColItemQuantity, // int32 per item
+        ColArchived,     // uint8
+        ColumnarColumnCount
+    };
+
+    struct Options {
+        Format format{Format::Csv};
+        size_t chunkRows{8192};
+        /** Chunks encoded at once; 1 encodes on the calling thread, 0 uses every core. */
+        unsigned threads{1};
+    };
+
+    struct Stats {
+        uint64_t rows{0};
+        uint64_t archivedRows{0};
+        uint64_t chunks{0};
+        uint64_t bytes{0};
+        /** Largest amount of encoded data held at once (one batch of chunks). */
+        uint64_t peakBufferBytes{0};
+    };
+
+    /** Writes archive's orders (when archive is non-null), then the snapshot's, to path. Any thread. */
+    bool write(const OrderSnapshot& snapshot, const OrderArchive* archive, const std::string& path, const Options& options,
+               Stats* stats = nullptr, std::string* error = nullptr);
+
+    /** One order read back from a columnar file; order.stage stays -1 and the name is in stage. */
+    struct ColumnarRow {
+        Order order;
+        std::string stage;
+        bool archived{false};
+    };
+    /** Reads a columnar export one row group at a time. */
+    bool readColumnar(const std::string& path, const std::function<void(const ColumnarRow&)>& fn, std::string* error = nullptr);
+}
@@ -1,12 +1,57 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <unordered_set>
+#include <chrono>
+#include <memory>
 #include "Order.h"
-#include "LinkedList.h"
+#include "OrderRegistry.h"
 #include "Queue.h"
 #include "Heap.h"
 #include "MenuBST.h"
-#include "WorkflowGraph.h"
+#include "WorkflowEngine.h"
+#include "TimeIndex.h"
+#include "CustomerIndex.h"
+#include "EventRing.h"
+#include "PrepEstimator.h"
+#include "EtaEngine.h"
+#include "OrderSnapshot.h"
+#include "Clock.h"
+
+class ReplicationLog;
+class TicketJournal;
+struct TicketRecord;
+struct KitchenState;
+
+/**
+ * Input for bulk creation; createOrders moves the name and items out of it.
+ */
+struct NewOrder {
+    std::string customerName;
+    bool isVip{false};
+    std::vector<OrderItem> items;
+    int estimatedPrepMinutes{0};
+};
+
+/**
+ * Filter and ordering for paged listings.
+ */
+struct ListQuery {
+    /** Bit (1 << status) per accepted OrderStatus; 0 accepts every status. */
+    unsigned statusMask{0};
+    /** Order by served time instead of placed time. */
+    bool byServed{false};
+    bool newestFirst{false};
+    /** Maximum rows to return; 0 means no limit. */
+    size_t limit{0};
+    /** Cursor: when non-zero, only rows sorting after this order id are returned. */
+    int afterId{0};
+    /** Time window [since, until) in epoch seconds on the sort column; 0 leaves that side open. */
+    long long since{0};
+    long long until{0};
+
+    static unsigned maskOf(OrderStatus status) { return 1u << static_cast<unsigned>(status); }
+};
 
 /**
  * Coordinates all order operations and scheduling structures.
@@ -14,11 +59,29 @@
 class OrderManager {
 public:
     OrderManager();
+    // Workflow hooks point back at this manager.
+    OrderManager(const OrderManager&) = delete;
+    OrderManager& operator=(const OrderManager&) = delete;
 
-    /** Creates a new order and enqueues it. */
-    OrderNode* createOrder(const std::string& customerName, bool isVip, const std::vector<OrderItem>& items, int estimatedPrepMinutes);
+    /**
+     * Creates a new order and enqueues it; returns its id. Registry slots move as orders are
+     * added, so look the order up by id (getOrder) rather than keeping a pointer to it.
+     */
+    int createOrder(const std::string& customerName, bool isVip, const std::vector<OrderItem>& items, int estimatedPrepMinutes);
+    /** Same as above, but the name and items are moved into the registry without copies. */
+    int createOrder(std::string&& customerName, bool isVip, std::vector<OrderItem>&& items, int estimatedPrepMinutes);
+    /**
+     * Creates and enqueues a batch of orders with one clock read. Queue and heap capacity are
+     * reserved once, and VIP entries go into the heap in a single O(n) rebuild when the batch is large.
+     * Returns the number created.
+     */
+    size_t createOrders(std::vector<NewOrder>&& batch);
+    /** Applies one target status to many orders, O(ids.size()); unknown and repeated ids are skipped. Returns how many moved. */
+    size_t transitionMany(const std::vector<int>& ids, OrderStatus to);
     /** Edits an order if it is not served/cancelled. */
     bool editOrder(int id, const std::string& customerName, bool isVip, const std::vector<OrderItem>& items, int estimatedPrepMinutes);
+    /** Moving overload of editOrder. */
+    bool editOrder(int id, std::string&& customerName, bool isVip, std::vector<OrderItem>&& items, int estimatedPrepMinutes);
     /** Cancels an order if still active. */
     bool cancelOrder(int id);
 
@@ -28,14 +91,82 @@ public:
     bool readyOrder(int id);
     /** Marks an order as SERVED. */
     bool serveOrder(int id);
+    /** Moves an order into any workflow stage reachable by one legal edge. */
+    bool advanceOrder(int id, int stage);
 
-    /** Returns the next order id for the kitchen; applies VIP priority. */
+    /** Returns the next order id for the kitchen; applies VIP priority. False if no waiting order can move to PREPPING. */
     bool nextForKitchen(int& orderId);
+    /**
+     * Replays a kitchen pull logged by a primary: moves exactly order id to PREPPING, whatever this
+     * manager's own queue would pick, then drops queue and heap heads that no longer wait. False
+     * if id is not waiting or cannot move.
+     */
+    bool applyKitchenPull(int id);
 
-    /** Finds an order by id. */
+    /** Current time for stamping orders; inside a batch every order shares one clock read. */
+    std::chrono::system_clock::time_point now() const;
+    /**
+     * Replaces the clock behind now(); nullptr restores the system clock. The clock is not owned
+     * and must outlive the manager. Swap it before the first order: stamps are not rewritten.
+     */
+    void setClock(ServiceClock* clock) { clock_ = clock ? clock : &RealClock::instance(); }
+    ServiceClock& clock() const { return *clock_; }
+    /** Runs fn with now() pinned to at; a standby replays the primary's mutations this way. */
+    template <typename Fn>
+    auto runAt(std::chrono::system_clock::time_point at, Fn fn) -> decltype(fn()) {
+        struct Restore {
+            OrderManager& self;
+            std::chrono::system_clock::time_point now;
+            bool inBatch;
+            ~Restore() {
+                self.batchNow_ = now;
+                self.inBatch_ = inBatch;
+            }
+        } restore{*this, batchNow_, inBatch_};
+        batchNow_ = at;
+        inBatch_ = true;
+        return fn();
+    }
+
+    /** Finds an order by id (O(1) through the id index). */
     Order* getOrder(int id);
+    const Order* getOrder(int id) const;
+    /** Orders placed in [from, to) epoch seconds, oldest first; O(log n + k). limit 0 = all. */
+    std::vector<Order> placedBetween(long long from, long long to, size_t limit = 0) const;
+    /** Served orders with servedAt in [from, to), oldest first; O(log n + k). */
+    std::vector<Order> servedBetween(long long from, long long to, size_t limit = 0) const;
+    /**
+     * Orders whose customer name starts with prefix (case-insensitive), in name order. When no
+     * name has that prefix, falls back to trigram fuzzy matching, best match first, and sets
+     * *fuzzy. limit 0 returns every prefix match.
+     */
+    std::vector<Order> findByCustomer(const std::string& prefix, size_t limit = 0, bool* fuzzy = nullptr) const;
     /** Lists orders filtered by status. */
     std::vector<Order> listByStatus(OrderStatus status) const;
+    /**
+     * Returns one page of orders matching query, already sorted. With a limit only the page
+     * is copied (bounded top-K heap). nextAfterId receives the cursor for the following page, or 0.
+     */
+    std::vector<Order> listPage(const ListQuery& query, int* nextAfterId = nullptr) const;
+    /**
+     * Ids in query's --since/--until window, in listing order, read from the time index in
+     * O(log n + k); empty when the query has no window. Snapshots carry no time index, so resolve
+     * these on the manager's thread together with the snapshot.
+     */
+    std::vector<int> windowIds(const ListQuery& query) const;
+    /**
+     * Same listing over a snapshot; any thread. window, from windowIds when the snapshot was
+     * taken, limits the work to that slice; without it every order is scanned.
+     */
+    static std::vector<Order> listPage(const OrderSnapshot& snapshot, const ListQuery& query, int* nextAfterId = nullptr,
+                                       const std::vector<int>* window = nullptr);
+
+    /**
+     * Consistent read view for reports and saves running off the manager's thread (see
+     * OrderSnapshot). Costs O(orders changed since the previous snapshot + pages), never a copy
+     * of every order. Call from the manager's thread; the snapshot itself can go anywhere.
+     */
+    OrderSnapshot snapshot() const;
 
     size_t activeCount() const { return active_.size(); }
     int nextIdValue() const { return nextId_; }
@@ -45,8 +176,53 @@ public:
     /** Clears all internal structures to allow a fresh load from disk. */
     void reset();
 
-    /** Shortest valid status path using workflow graph; empty if unreachable. */
-    std::vector<OrderStatus> shortestPath(OrderStatus from, OrderStatus to) const;
+    /** Dirty tracking for incremental saves: orders and menu changed since the last save/load. */
+    bool isOrderDirty(int id) const { return dirtyOrders_.count(id) != 0; }
+    size_t dirtyOrderCount() const { return dirtyOrders_.size(); }
+    const std::unordered_set<int>& dirtyOrders() const { return dirtyOrders_; }
+    bool menuDirty() const { return menuDirty_; }
+    void clearDirty();
+    /** Segment store directory the clean state matches; empty when unknown. */
+    const std::string& segmentStore() const { return segmentStore_; }
+    void setSegmentStore(const std::string& dir) { segmentStore_ = dir; }
+
+    /** Shortest valid stage path using the workflow engine; empty if unreachable. */
+    WorkflowEngine::Path shortestPath(int fromStage, int toStage) const;
+
+    /**
+     * Replaces the workflow with the standard lifecycle plus a site config (see WorkflowEngine).
+     * Hooks registered through workflow() must be added again afterwards.
+     */
+    bool loadWorkflow(const std::string& path, std::string& error);
+    const WorkflowEngine& workflow() const { return workflow_; }
+    WorkflowEngine& workflow() { return workflow_; }
+
+    /**
+     * Prep minutes for items from the learned model (see PrepEstimator), scaled for the current
+     * kitchen load; falls back to menu defaults per item and returns 0 if no item is known.
+     */
+    int estimatePrepMinutes(const std::vector<OrderItem>& items) const;
+    /** Feeds a finished order's started -> ready time to the model (called by the ready hook). */
+    void recordPrepTime(const Order& order, int load);
+    /** Orders currently in prep (base status PREPPING). */
+    int kitchenLoad() const { return preppingCount_; }
+    const PrepEstimator& prepEstimator() const { return estimator_; }
+
+    /**
+     * Projected ready time: for waiting orders now + (queued minutes ahead / stations) + own
+     * estimate, O(log n) through EtaEngine; started orders use startedAt + estimate and finished
+     * ones their readyAt. Orders already in prep are not counted as backlog. False if cancelled
+     * or unknown.
+     */
+    bool projectedReadyAt(int id, std::chrono::system_clock::time_point& out) const;
+    /** Number of orders the kitchen prepares in parallel, for ETAs (default 1). */
+    void setKitchenStations(int stations) { kitchenStations_ = stations > 0 ? stations : 1; }
+    long long backlogMinutes() const { return eta_.backlogMinutes(); }
+    /**
+     * Refills the normal queue (in queueIds order), the VIP heap and the ETA lanes from waiting
+     * orders after a load.
+     */
+    void rebuildSchedules(const std::vector<int>& queueIds);
 
     /** Menu operations using BST. */
     int addMenuItem(const std::string& name, int defaultPrepMinutes, int itemId = 0);
@@ -54,25 +230,105 @@ public:
     MenuItem* findMenuItem(const std::string& name);
     std::vector<MenuItem> listMenuItems() const;
 
+    /**
+     * Lifecycle event stream. Each subscriber gets its own SPSC ring that the manager (the single
+     * producer) publishes created/edited/transitioned/cancelled events into; a full ring drops the
+     * event and counts it instead of blocking. The ring is owned by the manager and stays valid
+     * until unsubscribe. Subscribe and unsubscribe from the producer thread.
+     */
+    OrderEventRing* subscribe(size_t capacity = 1024);
+    void unsubscribe(OrderEventRing* ring);
+
+    /**
+     * Mirrors every successful public mutation (create, edit, stage change, kitchen pull, menu
+     * change) into log for a standby; nullptr detaches. Loads are not logged record by record:
+     * whoever loads sends the standby a full state instead (ReplicationLog::fullState).
+     */
+    void setReplicationLog(ReplicationLog* log) { replication_ = log; }
+    /** Appends every transition (and VIP change) to journal; nullptr detaches. See TicketJournal::attach. */
+    void setTicketJournal(TicketJournal* journal) { journal_ = journal; }
+    /**
+     * Crash recovery on top of the last save: applies the journal's latest record per order
+     * (orders missing from the save come back as placeholders without items), then rebuilds
+     * queue, VIP heap and ETAs from the journal's queue order. Returns the live orders the
+     * journal does not know about (0 unless it overflowed or was rebased since the save).
+     */
+    size_t recoverKitchen(const KitchenState& state);
+
+    /**
+     * Moves served and cancelled orders that finished before `before` (epoch seconds; served
+     * orders by served time, cancelled ones by placed time) out of the registry and every index
+     * into out, for the archive. The next segmented save rewrites every segment.
+     */
+    size_t takeFinished(long long before, std::vector<Order>& out);
+    /** Adds an already-built order (from disk) to the registry and all indexes without marking it dirty. */
+    Order* restoreOrder(Order&& order);
+    /** Records a newly served order in the served-time index (called by the serve hook). */
+    void indexServed(const Order& order);
+
     // Expose internal snapshots for persistence
     std::vector<Order> snapshotAll() const;
     IntQueue& normalQueue() { return normalQueue_; }
     const IntQueue& normalQueue() const { return normalQueue_; }
     VipHeap& vipHeap() { return vipHeap_; }
     const VipHeap& vipHeap() const { return vipHeap_; }
-    OrderList& registry() { return active_; }
-    const OrderList& registry() const { return active_; }
+    OrderRegistry& registry() { return active_; }
+    const OrderRegistry& registry() const { return active_; }
+    /** Live orders by placed time (epoch seconds). */
+    const TimeIndex& placedIndex() const { return placedIndex_; }
     const MenuBST& menu() const { return menu_; }
     MenuBST& menu() { return menu_; }
 
 private:
-    OrderList active_;
+    OrderRegistry active_;
+    /** Registry handle by order id; invalid for ids not (or no longer) live. */
+    std::vector<OrderHandle> byId_;
+    TimeIndex placedIndex_;
+    TimeIndex servedIndex_;
+    CustomerIndex customers_;
+    PrepEstimator estimator_;
+    /** Menu default prep minutes by item id (0 = no such item), for the estimator. */
+    std::vector<int> menuDefaults_;
+    int preppingCount_{0};
+    EtaEngine eta_;
+    int kitchenStations_{1};
     IntQueue normalQueue_;
     VipHeap vipHeap_;
-    WorkflowGraph workflow_;
+    WorkflowEngine workflow_;
     MenuBST menu_;
     int nextId_{1};
     int nextMenuId_{1};
+    std::unordered_set<int> dirtyOrders_;
+    /** Copy-on-write versions behind snapshot(); mutable since publishing them changes no state. */
+    mutable OrderVersions versions_;
+    bool menuDirty_{false};
+    std::string segmentStore_;
+    ServiceClock* clock_{&RealClock::instance()};
+    std::chrono::system_clock::time_point batchNow_{};
+    bool inBatch_{false};
+    std::vector<std::unique_ptr<OrderEventRing>> subscribers_;
+    ReplicationLog* replication_{nullptr};
+    TicketJournal* journal_{nullptr};
 
+    /** The live order with id, or nullptr (O(1): id -> handle -> dense slot). */
+    Order* findOrder(int id);
+    const Order* findOrder(int id) const;
+    /** Records a change to id for incremental saves and the next snapshot. */
+    void markChanged(int id);
+    void indexOrder(const Order& order, OrderHandle handle);
+    /** Calls fn(id) for query's time window in listing order until it returns false. */
+    template <typename Func>
+    void forEachInWindow(const ListQuery& query, Func fn) const;
+    Order* placeOrder(std::string&& customerName, bool isVip, std::vector<OrderItem>&& items, int estimatedPrepMinutes,
+                      std::chrono::system_clock::time_point placedAt, std::vector<VipEntry>* deferredVips);
     bool transition(Order& order, OrderStatus to);
+    bool transitionStage(Order& order, int to);
+    /** transitionStage/transition for the public stage-change calls: logs the change for replication. */
+    bool changeStage(Order& order, int to);
+    bool changeStatus(Order& order, OrderStatus to);
+    bool pullForKitchen(int& orderId);
+    /** Puts order into a recovered ticket's stage without workflow checks or hooks. */
+    void applyTicket(Order& order, const TicketRecord& ticket);
+    void registerBuiltinHooks();
+    void publish(OrderEventType type, int orderId, int fromStage, int toStage);
 };
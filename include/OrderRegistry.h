@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Order.h"
+
+/**
+ * Stable reference to an order in an OrderRegistry. The generation is bumped whenever its slot
+ * is freed, so a handle to an erased order stops resolving instead of aliasing the next one.
+ */
+struct OrderHandle {
+    static constexpr uint32_t kNone = UINT32_MAX;
+    uint32_t slot{kNone};
+    uint32_t generation{0};
+
+    bool valid() const { return slot != kNone; }
+    bool operator==(const OrderHandle&) const = default;
+};
+
+/**
+ * Slot map of orders. Orders sit back to back in one dense array, so a full scan is a linear
+ * walk. Handles go through a slot table (slot -> dense position + generation), and erase moves
+ * the last order into the hole: O(1), at the cost of scan order. eraseIf compacts in one pass
+ * and keeps the survivors' order.
+ *
+ * Order pointers and references are invalidated by any insert or erase; keep handles (or ids)
+ * across those.
+ */
+class OrderRegistry {
+public:
+    OrderRegistry() = default;
+
+    /** Moves order in and returns its handle. */
+    OrderHandle insert(Order&& order);
+    /** The order behind handle, or nullptr once it has been erased. */
+    Order* get(OrderHandle handle);
+    const Order* get(OrderHandle handle) const;
+    /** Removes handle's order by moving the last order into its place; false if stale. */
+    bool erase(OrderHandle handle);
+    void reserve(size_t count);
+    void clear();
+
+    /** Calls fn(Order&) for every order, in dense order. */
+    template <typename Func>
+    void forEach(Func fn) {
+        for (Order& o : orders_) fn(o);
+    }
+    template <typename Func>
+    void forEach(Func fn) const {
+        for (const Order& o : orders_) fn(o);
+    }
+
+    /**
+     * Removes every order pred(order) accepts in one stable pass, handing each to taken(Order&&)
+     * first. Returns the number removed.
+     */
+    template <typename Pred, typename Taken>
+    size_t eraseIf(Pred pred, Taken taken) {
+        size_t kept = 0;
+        for (size_t i = 0; i < orders_.size(); ++i) {
+            uint32_t slot = slotOf_[i];
+            if (pred(orders_[i])) {
+                taken(std::move(orders_[i]));
+                release(slot);
+                continue;
+            }
+            if (kept != i) {
+                orders_[kept] = std::move(orders_[i]);
+                slotOf_[kept] = slot;
+                slots_[slot].dense = static_cast<uint32_t>(kept);
+            }
+            ++kept;
+        }
+        size_t removed = orders_.size() - kept;
+        orders_.resize(kept);
+        slotOf_.resize(kept);
+        return removed;
+    }
+
+    size_t size() const { return orders_.size(); }
+    bool empty() const { return orders_.empty(); }
+
+private:
+    struct Slot {
+        /** Position in orders_ while live; next free slot (or kNone) while free. */
+        uint32_t dense{OrderHandle::kNone};
+        uint32_t generation{0};
+    };
+
+    std::vector<Order> orders_;
+    /** Slot of each dense position, to fix up the slot table when orders move. */
+    std::vector<uint32_t> slotOf_;
+    std::vector<Slot> slots_;
+    uint32_t freeHead_{OrderHandle::kNone};
+
+    /** Retires slot (new generation) and puts it on the free list. */
+    void release(uint32_t slot);
+};
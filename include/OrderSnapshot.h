@@ -0,0 +1,96 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "MenuBST.h"
+#include "Order.h"
+
+/**
+ * Read-only, point-in-time view of every order plus the small state a save needs (ids, queue,
+ * menu, stage names). Orders live in shared copy-on-write pages, so a snapshot holds a page table
+ * rather than copies of the orders, and holding one never blocks the manager: later writes go to
+ * fresh pages. A snapshot never changes and may be read from any thread; pages are freed when
+ * the last snapshot sharing them is dropped.
+ */
+class OrderSnapshot {
+public:
+    static constexpr size_t kPageSize = 256;
+    using Page = std::array<std::shared_ptr<const Order>, kPageSize>;
+    using PageTable = std::vector<std::shared_ptr<const Page>>;
+
+    /** Grows with every snapshot that saw new writes; equal epochs mean equal orders. */
+    std::uint64_t epoch() const { return epoch_; }
+    size_t size() const { return count_; }
+    /** The order as of this snapshot, or nullptr. */
+    const Order* find(int id) const;
+
+    /** Visits every order in id order. */
+    template <typename Func>
+    void forEach(Func fn) const {
+        if (!pages_) return;
+        for (const auto& page : *pages_) {
+            if (!page) continue;
+            for (const auto& order : *page) {
+                if (order) fn(*order);
+            }
+        }
+    }
+
+    int nextId() const { return nextId_; }
+    int nextMenuId() const { return nextMenuId_; }
+    /** Normal queue in FIFO order. */
+    const std::vector<int>& queue() const { return queue_; }
+    const std::vector<MenuItem>& menu() const { return menu_; }
+    /** Workflow stage names by stage id, as of the snapshot. */
+    const std::string& stageName(int stage) const { return stageNames_[static_cast<size_t>(stage)]; }
+    size_t stageCount() const { return stageNames_.size(); }
+
+private:
+    friend class OrderVersions;
+    friend class OrderManager;
+
+    std::uint64_t epoch_{0};
+    std::shared_ptr<const PageTable> pages_;
+    size_t count_{0};
+    int nextId_{1};
+    int nextMenuId_{1};
+    std::vector<int> queue_;
+    std::vector<MenuItem> menu_;
+    std::vector<std::string> stageNames_;
+};
+
+/**
+ * Writer side of OrderSnapshot, owned by OrderManager. A write only marks the order id (O(1), no
+ * copy); snapshot() then copies each order changed since the previous snapshot once, cloning its
+ * page first only while an older snapshot still shares it. A snapshot costs O(changed orders +
+ * pages), and orders nobody changed are shared by every snapshot. Use from the manager's thread.
+ */
+class OrderVersions {
+public:
+    /** Marks id as changed (created, edited, moved or restored). */
+    void touch(int id);
+    /**
+     * Publishes the current state of every touched id; lookup returns the live order, or
+     * nullptr if it is gone. The caller fills in the non-order fields.
+     */
+    OrderSnapshot snapshot(const std::function<const Order*(int)>& lookup);
+    /** Drops every version (after a reset); snapshots already taken stay valid. */
+    void clear();
+    size_t pendingCount() const { return pending_.size(); }
+
+private:
+    /** The writer's page table; a page is written in place only when no snapshot shares it. */
+    std::vector<std::shared_ptr<OrderSnapshot::Page>> pages_;
+    /** Table handed to the last snapshot, reused while nothing changes. */
+    std::shared_ptr<const OrderSnapshot::PageTable> published_;
+    std::vector<int> pending_;
+    std::vector<std::uint8_t> pendingFlag_;
+    size_t count_{0};
+    std::uint64_t epoch_{0};
+
+    void store(int id, const Order* current);
+};
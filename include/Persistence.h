@@ -1,5 +1,8 @@
 #pragma once
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 #include "OrderManager.h"
 
 /**
@@ -10,4 +13,62 @@ namespace Persistence {
     bool saveState(const OrderManager& manager, const std::string& path);
     /** Loads manager state from JSON file at path; resets manager first. */
     bool loadState(OrderManager& manager, const std::string& path);
+
+    /**
+     * Segmented layout: dir/manifest.json (ids, queue, segment list), dir/menu.json and one
+     * dir/orders-YYYYMMDD.json per UTC placement day. Only segments holding dirty orders (and the
+     * menu when it changed) are rewritten; writing into a different dir rewrites everything.
+     */
+    bool saveSegments(OrderManager& manager, const std::string& dir, size_t* segmentsWritten = nullptr);
+    /** Loads a segmented store written by saveSegments; resets manager first. */
+    bool loadSegments(OrderManager& manager, const std::string& dir);
+
+    /*
+     * Split save/load for callers that keep file I/O off the manager's thread: the render/prepare
+     * and apply steps touch the manager, the read/write steps only touch files and can run on any
+     * thread. saveState/loadState and saveSegments/loadSegments are the two halves run back to back.
+     */
+
+    /** (path, contents) pairs, written in order; each file is replaced atomically. */
+    using PendingWrites = std::vector<std::pair<std::string, std::string>>;
+    /** Raw files of a segmented store, as read by readSegmentFiles. */
+    struct SegmentFiles {
+        std::string manifest;
+        std::string menu;
+        std::vector<std::string> segments;
+    };
+
+    /** Serializes the full state in the saveState format. */
+    std::string renderState(const OrderManager& manager);
+    /** Same from a snapshot; runs on any thread while the manager keeps taking orders. */
+    std::string renderState(const OrderSnapshot& snapshot);
+    /** Replaces manager state with a document produced by renderState. */
+    void applyState(OrderManager& manager, const std::string& content);
+    /**
+     * Serializes the changed segments, the menu if needed and the manifest (last) into writes,
+     * and marks the manager clean for dir. If the writes then fail, call setSegmentStore("") so
+     * the next save rewrites everything.
+     */
+    void prepareSegments(OrderManager& manager, const std::string& dir, PendingWrites& writes);
+
+    /** What a segmented save needs, captured on the manager's thread by beginSegments. */
+    struct SegmentJob {
+        OrderSnapshot snapshot;
+        std::string dir;
+        bool full{false};
+        bool menuChanged{false};
+        /** Every placement day (epoch seconds / 86400) holding an order, for the manifest. */
+        std::vector<long long> days;
+        /** Ids (ascending) of every order in each day that has to be rewritten. */
+        std::map<long long, std::vector<int>> dirtySegments;
+    };
+    /** prepareSegments split in two: capture and mark clean here, render on any thread. */
+    SegmentJob beginSegments(OrderManager& manager, const std::string& dir);
+    void renderSegments(const SegmentJob& job, PendingWrites& writes);
+    bool readSegmentFiles(const std::string& dir, SegmentFiles& files);
+    void applySegments(OrderManager& manager, const std::string& dir, const SegmentFiles& files);
+
+    bool readText(const std::string& path, std::string& content);
+    /** Writes every entry, creating parent directories; stops at the first failure. */
+    bool writeAll(const PendingWrites& writes);
 }
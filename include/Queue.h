@@ -3,14 +3,18 @@
 #include <vector>
 
 /**
- * Simple circular queue for integer order IDs.
+ * Simple circular queue for integer order IDs. Grows (doubling) when full.
  */
 class IntQueue {
 public:
     explicit IntQueue(size_t capacity = 128);
 
-    /** Inserts at tail; returns false if full. */
+    /** Inserts at tail, growing the buffer if it is full. */
     bool enqueue(int value);
+    /** Inserts at head, ahead of everything queued, growing the buffer if it is full. */
+    bool pushFront(int value);
+    /** Ensures room for capacity elements without further reallocation. */
+    void reserve(size_t capacity);
     /** Removes head into out; returns false if empty. */
     bool dequeue(int& out);
     bool isEmpty() const { return count_ == 0; }
@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Order.h"
+
+class OrderManager;
+struct MenuItem;
+
+/**
+ * Mutation log of a primary OrderManager, fed by the manager as each public mutation succeeds
+ * (see OrderManager::setReplicationLog) and drained by a ReplicationSender. Records are logical
+ * (created, edited, stage change, kitchen pull, menu change, full state) and carry the
+ * primary's timestamps, so a standby replaying them through the same API rebuilds identical
+ * registry, queue, heap and indexes.
+ *
+ * Wire format: one record per line, "<type> <loggedNanos> <fields...>\n", where loggedNanos is
+ * steady-clock time (for lag) and strings are "<length>:<bytes>".
+ */
+class ReplicationLog {
+public:
+    void created(const Order& order);
+    void edited(const Order& order);
+    void staged(int id, int stage, std::chrono::system_clock::time_point at);
+    void pulled(int id, std::chrono::system_clock::time_point at);
+    void menuAdded(const MenuItem& item);
+    void menuRemoved(const std::string& name);
+    /** Replaces the standby's whole state (on connect and after a load). */
+    void fullState(const std::string& document);
+
+    /**
+     * Records are dropped while no standby listens; after beginResync they are dropped until
+     * the next fullState, which becomes the first record the new standby sees.
+     */
+    void beginResync();
+    void pause();
+
+    /** Waits up to wait for records and moves them into out; false if there were none. */
+    bool take(std::string& out, std::chrono::milliseconds wait);
+    /** Wakes a waiting take(). */
+    void wake();
+    uint64_t recordCount() const { return records_.load(); }
+
+private:
+    enum class State { Idle, AwaitingFull, Streaming };
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::string buffer_;
+    State state_{State::Idle};
+    std::atomic<uint64_t> records_{0};
+
+    void append(char type, const std::string& body, bool full = false);
+};
+
+/**
+ * Primary side transport: connects to the standby's unix socket (retrying until it is up),
+ * asks for a full-state record through requestResync, then streams the log. A write failure
+ * pauses the log and reconnects. On destruction the records already logged are flushed, so a
+ * clean primary exit hands the standby everything.
+ */
+class ReplicationSender {
+public:
+    ReplicationSender(ReplicationLog& log, std::string socketPath, std::function<void()> requestResync);
+    ~ReplicationSender();
+    ReplicationSender(const ReplicationSender&) = delete;
+    ReplicationSender& operator=(const ReplicationSender&) = delete;
+
+    bool connected() const { return connected_.load(); }
+
+private:
+    ReplicationLog& log_;
+    std::string path_;
+    std::function<void()> requestResync_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<bool> connected_{false};
+    std::thread thread_;
+
+    void run();
+};
+
+/** Counters kept by a standby while it applies the stream. */
+struct ReplicaStats {
+    uint64_t records{0};
+    /** Records that did not apply (unknown id, refused transition); the next full state heals them. */
+    uint64_t failed{0};
+    long long lagTotalNanos{0};
+    long long lagMaxNanos{0};
+    /** When set, every record's lag is appended (benchmarks). */
+    std::vector<long long>* lagSamples{nullptr};
+};
+
+/**
+ * Standby side: parses the byte stream and replays each record into manager with now() pinned
+ * to the primary's timestamps. feed() accepts arbitrary chunks; a partial record waits for
+ * the rest. Returns false on a malformed stream.
+ */
+class ReplicaApplier {
+public:
+    ReplicaApplier(OrderManager& manager, ReplicaStats& stats) : manager_(manager), stats_(stats) {}
+    bool feed(const char* data, size_t size);
+
+private:
+    OrderManager& manager_;
+    ReplicaStats& stats_;
+    std::string pending_;
+
+    /** 1 applied, 0 incomplete, -1 malformed. */
+    int applyOne(size_t& pos);
+};
+
+namespace Replication {
+    /**
+     * Listens on socketPath, accepts one primary and applies its stream until it disconnects.
+     * False if the socket cannot be set up or the stream is malformed; stats cover what arrived.
+     */
+    bool runStandby(OrderManager& manager, const std::string& socketPath, ReplicaStats& stats);
+}
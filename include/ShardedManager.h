@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Async.h"
+#include "OrderManager.h"
+
+/** Per-branch counters gathered by ShardedManager::stats(). */
+struct BranchStats {
+    std::string branch;
+    size_t byStatus[6]{};
+    long long backlogMinutes{0};
+    /** Mean placed -> served minutes over served orders; 0 if none. */
+    double avgServeMinutes{0.0};
+    size_t servedCount{0};
+};
+
+/**
+ * Several branches in one process. Each branch has its own OrderManager, id space and state file,
+ * and is only touched from its own thread (an EventLoop), so branches never contend with each
+ * other. Global order ids carry the branch in their low kShardBits bits (global = local << 4 |
+ * shard), which makes routing a mask. Cross-branch queries scatter to every branch thread and
+ * merge the already-sorted per-branch results.
+ */
+class ShardedManager {
+public:
+    static constexpr int kShardBits = 4;
+    static constexpr size_t kMaxShards = size_t{1} << kShardBits;
+
+    /** Every branch stamps orders from clock (shared, not owned; nullptr = system clock). */
+    explicit ShardedManager(ServiceClock* clock = nullptr) : clock_(clock) {}
+    ~ShardedManager();
+    ShardedManager(const ShardedManager&) = delete;
+    ShardedManager& operator=(const ShardedManager&) = delete;
+
+    /**
+     * Starts one shard per name; names are used for state files. Fails, starting nothing, for an
+     * empty list, more than kMaxShards names, duplicate names or a second call.
+     */
+    bool open(const std::vector<std::string>& branches, std::string* error = nullptr);
+
+    size_t shardCount() const { return shards_.size(); }
+    const std::string& branchName(size_t shard) const { return shards_[shard]->name; }
+    /** Shard index for a branch name, or -1. */
+    int shardOf(const std::string& branch) const;
+
+    static int globalId(size_t shard, int localId) { return (localId << kShardBits) | static_cast<int>(shard); }
+    static size_t shardOfId(int globalId) { return static_cast<size_t>(globalId) & (kMaxShards - 1); }
+    static int localId(int globalId) { return globalId >> kShardBits; }
+
+    /**
+     * Runs fn(OrderManager&) on the shard's thread and returns a future for its result. This is
+     * the only way to reach a branch manager; ids inside fn are branch-local.
+     */
+    template <typename Fn>
+    auto call(size_t shard, Fn fn) -> std::future<std::invoke_result_t<Fn, OrderManager&>> {
+        using Result = std::invoke_result_t<Fn, OrderManager&>;
+        Shard* s = shards_[shard].get();
+        auto task = std::make_shared<std::packaged_task<Result()>>([s, fn]() mutable { return fn(s->manager); });
+        auto future = task->get_future();
+        s->loop.post([task] { (*task)(); });
+        return future;
+    }
+
+    /** Creates an order in a branch; returns its global id, or 0 for a bad shard. */
+    int createOrder(size_t shard, std::string customerName, bool isVip, std::vector<OrderItem> items, int estimatedPrepMinutes);
+    /** Routes to the owning branch; false for unknown ids or refused transitions. */
+    bool startOrder(int globalId);
+    bool readyOrder(int globalId);
+    bool serveOrder(int globalId);
+    bool cancelOrder(int globalId);
+    /** Copy of the order with its global id; false if unknown. */
+    bool getOrder(int globalId, Order& out);
+
+    /**
+     * Runs query on every branch in parallel and merges the results into one list sorted the way
+     * OrderManager::listPage sorts (time column, then global id), truncated to query.limit. Ids in
+     * the result are global. The afterId cursor is branch-local and not supported here; page
+     * with since/until instead.
+     */
+    std::vector<Order> listAll(const ListQuery& query);
+    std::vector<BranchStats> stats();
+
+    /** Saves/loads every branch to dir/<branch>.json in parallel; false if any branch failed. */
+    bool saveAll(const std::string& dir);
+    bool loadAll(const std::string& dir);
+
+private:
+    struct Shard {
+        std::string name;
+        OrderManager manager;
+        EventLoop loop;
+        std::thread thread;
+    };
+
+    ServiceClock* clock_{nullptr};
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    template <typename Fn>
+    bool route(int globalId, Fn fn);
+};
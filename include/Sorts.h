@@ -1,6 +1,11 @@
 #pragma once
-#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "Order.h"
 
 /**
@@ -11,4 +16,204 @@ namespace Sorts {
     void insertionSort(std::vector<Order>& items, const std::function<bool(const Order&, const Order&)>& cmp);
     void bubbleSort(std::vector<Order>& items, const std::function<bool(const Order&, const Order&)>& cmp);
     void mergeSort(std::vector<Order>& items, const std::function<bool(const Order&, const Order&)>& cmp);
+
+    /** Inputs at or below this size are sorted on the calling thread. */
+    constexpr size_t kParallelCutoff = 1 << 15;
+
+    /**
+     * Stable parallel merge sort. Each worker sorts one chunk bottom-up, then chunks are merged
+     * pairwise; every merge is split across workers with merge-path partitioning so the last
+     * rounds stay parallel too. One scratch buffer of items.size() is allocated and reused.
+     * threads == 0 uses std::thread::hardware_concurrency().
+     */
+    template <typename T, typename Cmp>
+    void parallelMergeSort(std::vector<T>& items, Cmp cmp, unsigned threads = 0, size_t cutoff = kParallelCutoff);
+
+    /** Order overload used by listings; falls back to a sequential sort below kParallelCutoff. */
+    void parallelMergeSort(std::vector<Order>& items, const std::function<bool(const Order&, const Order&)>& cmp, unsigned threads = 0);
+}
+
+namespace Sorts {
+namespace detail {
+    template <typename T, typename Cmp>
+    void insertionSortRange(T* first, T* last, Cmp& cmp) {
+        if (first == last) return;
+        for (T* i = first + 1; i < last; ++i) {
+            T key = std::move(*i);
+            T* j = i;
+            while (j > first && cmp(key, *(j - 1))) {
+                *j = std::move(*(j - 1));
+                --j;
+            }
+            *j = std::move(key);
+        }
+    }
+
+    /** Stable merge of [a, aEnd) and [b, bEnd) into out; ties keep the left run first. */
+    template <typename T, typename Cmp>
+    void mergeRuns(T* a, T* aEnd, T* b, T* bEnd, T* out, Cmp& cmp) {
+        while (a < aEnd && b < bEnd) {
+            if (cmp(*b, *a)) {
+                *out++ = std::move(*b++);
+            } else {
+                *out++ = std::move(*a++);
+            }
+        }
+        out = std::move(a, aEnd, out);
+        std::move(b, bEnd, out);
+    }
+
+    /** Bottom-up merge sort of data[0, n) using scratch[0, n); result is left in data. */
+    template <typename T, typename Cmp>
+    void bottomUpSort(T* data, T* scratch, size_t n, Cmp& cmp) {
+        constexpr size_t kRun = 32;
+        for (size_t i = 0; i < n; i += kRun) {
+            insertionSortRange(data + i, data + std::min(n, i + kRun), cmp);
+        }
+        T* from = data;
+        T* to = scratch;
+        for (size_t width = kRun; width < n; width *= 2) {
+            for (size_t lo = 0; lo < n; lo += 2 * width) {
+                size_t mid = std::min(n, lo + width);
+                size_t hi = std::min(n, lo + 2 * width);
+                mergeRuns(from + lo, from + mid, from + mid, from + hi, to + lo, cmp);
+            }
+            std::swap(from, to);
+        }
+        if (from != data) {
+            std::move(from, from + n, data);
+        }
+    }
+
+    /**
+     * Merge-path split: number of elements taken from a (length m) among the first k outputs
+     * of a stable merge of a and b (length n).
+     */
+    template <typename T, typename Cmp>
+    size_t coRank(size_t k, const T* a, size_t m, const T* b, size_t n, Cmp& cmp) {
+        size_t lo = k > n ? k - n : 0;
+        size_t hi = std::min(k, m);
+        while (lo < hi) {
+            size_t i = lo + (hi - lo) / 2;
+            size_t j = k - i;
+            if (!cmp(b[j - 1], a[i])) {
+                lo = i + 1;
+            } else {
+                hi = i;
+            }
+        }
+        return lo;
+    }
+
+    /** Runs tasks on up to `threads` workers (the caller is one of them). */
+    inline void runTasks(std::vector<std::function<void()>>& tasks, unsigned threads) {
+        if (threads <= 1 || tasks.size() <= 1) {
+            for (auto& t : tasks) t();
+            return;
+        }
+        std::atomic<size_t> nextTask{0};
+        auto worker = [&]() {
+            for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+                tasks[i]();
+            }
+        };
+        size_t extra = std::min<size_t>(threads, tasks.size()) - 1;
+        std::vector<std::thread> pool;
+        pool.reserve(extra);
+        for (size_t i = 0; i < extra; ++i) {
+            pool.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : pool) t.join();
+    }
+}
+
+template <typename T, typename Cmp>
+void parallelMergeSort(std::vector<T>& items, Cmp cmp, unsigned threads, size_t cutoff) {
+    const size_t n = items.size();
+    if (n < 2) return;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<T> scratch(n);
+    if (threads == 1 || n <= cutoff) {
+        detail::bottomUpSort(items.data(), scratch.data(), n, cmp);
+        return;
+    }
+
+    // Phase 1: one chunk per worker (never smaller than the cutoff), each sorted bottom-up.
+    size_t chunks = std::min<size_t>(threads, (n + cutoff - 1) / cutoff);
+    std::vector<size_t> bounds;
+    bounds.reserve(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c) {
+        bounds.push_back(n * c / chunks);
+    }
+    std::vector<std::function<void()>> tasks;
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t lo = bounds[c];
+        size_t hi = bounds[c + 1];
+        tasks.emplace_back([&, lo, hi]() {
+            detail::bottomUpSort(items.data() + lo, scratch.data() + lo, hi - lo, cmp);
+        });
+    }
+    detail::runTasks(tasks, threads);
+
+    // Phase 2: pairwise merge rounds, ping-ponging between items and scratch.
+    T* from = items.data();
+    T* to = scratch.data();
+    while (bounds.size() > 2) {
+        tasks.clear();
+        size_t runs = bounds.size() - 1;
+        size_t pairs = runs / 2;
+        size_t splits = std::max<size_t>(1, threads / std::max<size_t>(1, pairs));
+        std::vector<size_t> next;
+        next.reserve(pairs + 2);
+        for (size_t r = 0; r + 1 < runs; r += 2) {
+            size_t lo = bounds[r];
+            size_t mid = bounds[r + 1];
+            size_t hi = bounds[r + 2];
+            next.push_back(lo);
+            size_t total = hi - lo;
+            for (size_t s = 0; s < splits; ++s) {
+                size_t k0 = total * s / splits;
+                size_t k1 = total * (s + 1) / splits;
+                tasks.emplace_back([&, from, to, lo, mid, hi, k0, k1]() {
+                    const T* a = from + lo;
+                    const T* b = from + mid;
+                    size_t m = mid - lo;
+                    size_t len = hi - mid;
+                    size_t i0 = detail::coRank(k0, a, m, b, len, cmp);
+                    size_t i1 = detail::coRank(k1, a, m, b, len, cmp);
+                    detail::mergeRuns(from + lo + i0, from + lo + i1,
+                                      from + mid + (k0 - i0), from + mid + (k1 - i1),
+                                      to + lo + k0, cmp);
+                });
+            }
+        }
+        if (runs % 2 == 1) {
+            size_t lo = bounds[runs - 1];
+            size_t hi = bounds[runs];
+            next.push_back(lo);
+            tasks.emplace_back([from, to, lo, hi]() {
+                std::move(from + lo, from + hi, to + lo);
+            });
+        }
+        next.push_back(n);
+        detail::runTasks(tasks, threads);
+        bounds.swap(next);
+        std::swap(from, to);
+    }
+
+    if (from != items.data()) {
+        tasks.clear();
+        for (unsigned s = 0; s < threads; ++s) {
+            size_t lo = n * s / threads;
+            size_t hi = n * (s + 1) / threads;
+            tasks.emplace_back([from, &items, lo, hi]() {
+                std::move(from + lo, from + hi, items.data() + lo);
+            });
+        }
+        detail::runTasks(tasks, threads);
+    }
+}
 }
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Order.h"
+
+/**
+ * Formats epoch seconds as "dd/mm/yyyy hh:mm am" without iostreams.
+ * UTC offsets are kept per block of days as a starting offset plus the exact second of each
+ * change (std::localtime is probed once per day, and a day whose offset changes is bisected), and
+ * finished strings are cached per minute.
+ */
+class TimestampCache {
+public:
+    static constexpr size_t kWidth = 19;
+
+    /** Writes kWidth characters into out, or a single '-' for unset times; returns chars written. */
+    size_t format(long long seconds, char* out);
+
+private:
+    static constexpr long long kBlockDays = 365;
+
+    struct Transition {
+        long long at{0};
+        long long offset{0};
+    };
+    struct OffsetBlock {
+        long long block{-1};
+        long long initial{0};
+        /** Offset changes within the block, in time order. */
+        std::vector<Transition> transitions;
+    };
+    struct MinuteSlot {
+        long long minute{-1};
+        std::array<char, kWidth> text{};
+    };
+
+    std::array<OffsetBlock, 4> offsets_{};
+    std::array<MinuteSlot, 1024> minutes_{};
+
+    long long utcOffset(long long seconds);
+    void fillBlock(OffsetBlock& slot, long long block) const;
+    void render(long long localSeconds, char* out) const;
+};
+
+/** Machine-readable timestamps for exports. */
+namespace TimeFormat {
+    constexpr size_t kIsoWidth = 20;
+    /** Writes epoch seconds as "YYYY-MM-DDTHH:MM:SSZ" (kIsoWidth chars, UTC, no time zone lookup). */
+    void isoUtc(long long seconds, char* out);
+}
+
+/**
+ * Renders the fixed-width orders table straight into one reusable output buffer.
+ */
+class TableRenderer {
+public:
+    /** Appends header plus one line per order to out. */
+    void renderOrders(const std::vector<Order>& orders, std::string& out);
+
+private:
+    TimestampCache timestamps_;
+
+    void appendTime(std::string& out, long long seconds, size_t width);
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Order.h"
+
+class OrderManager;
+
+/**
+ * One 32-byte journal slot: the kitchen-relevant state of an order after one transition.
+ */
+struct TicketRecord {
+    static constexpr uint8_t kVip = 1;
+
+    /** Journal sequence number; 0 marks an empty slot. */
+    uint64_t sequence{0};
+    int32_t orderId{0};
+    /** Workflow stage (standard stages share OrderStatus numbering). */
+    int16_t stage{0};
+    /** Bit 0: VIP; bits 1-3: base OrderStatus. */
+    uint8_t flags{0};
+    /** Checksum over the other fields; a torn write fails it and the slot is ignored. */
+    uint8_t check{0};
+    int64_t placedAtNanos{0};
+    /**
+     * Waiting orders: normal-queue rank (FIFO position; a VIP keeps the rank it would have if
+     * moved back, 0 if none). Others: nanoseconds of the transition.
+     */
+    int64_t value{0};
+
+    bool isVip() const { return (flags & kVip) != 0; }
+    OrderStatus status() const { return static_cast<OrderStatus>((flags >> 1) & 7); }
+    bool isWaiting() const { return status() == OrderStatus::Placed || status() == OrderStatus::Queued; }
+    bool isLive() const { return status() != OrderStatus::Served && status() != OrderStatus::Cancelled; }
+};
+static_assert(sizeof(TicketRecord) == 32, "journal records are 32 bytes on disk");
+
+/** What recover() reads back: the kitchen as of the last journaled transition. */
+struct KitchenState {
+    /** Latest record per order, by id (finished orders too while their records survive). */
+    std::vector<TicketRecord> tickets;
+    /** Waiting normal orders in queue order; waiting VIPs rank by placed time as usual. */
+    std::vector<int> queue;
+    size_t waitingVips{0};
+    /** Orders in PREPPING/READY or a custom stage between them. */
+    size_t inFlight{0};
+    /** Sequence covered by the last save (see TicketJournal::checkpoint). */
+    uint64_t checkpoint{0};
+    /** Records lost before a save covered them: finished orders' outcomes, or live orders when the ring was full. */
+    uint64_t overflows{0};
+};
+
+/**
+ * Crash journal for kitchen tickets: a fixed-size ring of TicketRecords in a memory-mapped file.
+ * Every transition is appended with plain stores into the mapping, with an asynchronous msync
+ * every kSyncEvery records. A process crash loses nothing, since the pages belong to the kernel.
+ * An OS crash loses at most the records since the last sync that reached the disk.
+ *
+ * The ring always holds the latest record of every live order: a slot about to be overwritten
+ * that is still a live order's latest record is re-stamped in place and skipped, which costs
+ * live / (capacity - live) extra writes per record. Finished orders' records survive one lap of
+ * the ring; one overwritten before a save covered it (checkpoint) counts as an overflow.
+ * Recovery scans the ring once, with no parsing: O(capacity).
+ */
+class TicketJournal {
+public:
+    static constexpr size_t kDefaultCapacity = 16384;
+    static constexpr uint32_t kSyncEvery = 256;
+
+    TicketJournal() = default;
+    ~TicketJournal();
+    TicketJournal(const TicketJournal&) = delete;
+    TicketJournal& operator=(const TicketJournal&) = delete;
+
+    /**
+     * Maps path, creating it with room for capacity records. An existing journal of the same
+     * capacity is kept (call recover before attach); any other file is reinitialized.
+     */
+    bool open(const std::string& path, size_t capacity = kDefaultCapacity, std::string* error = nullptr);
+    void close();
+    bool isOpen() const { return slots_ != nullptr; }
+
+    /** Reads the ring back; nothing in out is from the manager. */
+    void recover(KitchenState& out) const;
+
+    /** Journals every live order of manager as a baseline, then the manager's transitions. */
+    void attach(OrderManager& manager);
+    /** Drops every record and journals manager's live orders again (after a load replaced them). */
+    void rebase(OrderManager& manager);
+
+    /** Appends order's state. at stamps transitions without their own timestamp (cancel). */
+    void record(const Order& order, std::chrono::system_clock::time_point at);
+    /** Sequence of the last record written. */
+    uint64_t sequence() const { return nextSequence_ - 1; }
+    /** A save holding the state as of sequence is durable: outcomes up to it are no longer needed. */
+    void checkpoint(uint64_t sequence);
+    /** Writes the mapping to disk synchronously. */
+    bool flush();
+
+    size_t capacity() const { return capacity_; }
+    uint64_t overflows() const;
+
+private:
+    struct Header;
+    /** Latest record of an order still worth keeping. */
+    struct Tracked {
+        uint64_t sequence{0};
+        /** Queue rank while waiting in (or returnable to) the normal queue; 0 otherwise. */
+        int64_t rank{0};
+        bool live{false};
+    };
+
+    int fd_{-1};
+    void* map_{nullptr};
+    size_t mapSize_{0};
+    Header* header_{nullptr};
+    TicketRecord* slots_{nullptr};
+    size_t capacity_{0};
+    size_t head_{0};
+    uint64_t nextSequence_{1};
+    int64_t nextRank_{1};
+    uint32_t sinceSync_{0};
+    std::unordered_map<int, Tracked> latest_;
+
+    /** Rebuilds head, counters and latest_ from the mapped ring. */
+    void scan();
+    /** True if slot holds a record that must survive; forgets it otherwise. */
+    bool keeps(const TicketRecord& slot);
+    void write(TicketRecord& slot, const TicketRecord& record, uint64_t sequence);
+    void writeBaseline(OrderManager& manager);
+    static uint8_t checksum(const TicketRecord& record);
+};
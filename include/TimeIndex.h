@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/**
+ * Time-ordered index of (seconds, order id) pairs. Live orders arrive in clock order, so inserts
+ * are appends; out-of-order inserts (loading old data) are appended too and the vector is
+ * re-sorted once before the next query. Range queries are a binary search plus a scan of the
+ * matching entries, O(log n + k).
+ */
+class TimeIndex {
+public:
+    void insert(long long seconds, int id);
+    /** Removes one (seconds, id) pair; returns false if it was not indexed. */
+    bool erase(long long seconds, int id);
+    /** Removes every entry whose id matches pred in one compacting pass, O(n); returns how many. */
+    template <typename Pred>
+    size_t eraseIf(Pred pred) {
+        size_t kept = 0;
+        for (const Entry& e : entries_) {
+            if (!pred(e.id)) entries_[kept++] = e;
+        }
+        size_t erased = entries_.size() - kept;
+        entries_.resize(kept);
+        return erased;
+    }
+    void clear();
+    size_t size() const { return entries_.size(); }
+
+    /** Calls fn(id) for every entry with from <= seconds < to, oldest first; stop early by returning false. */
+    template <typename Func>
+    void forEachInRange(long long from, long long to, Func fn) const {
+        ensureSorted();
+        for (size_t i = lowerBound(from); i < entries_.size() && entries_[i].seconds < to; ++i) {
+            if (!fn(entries_[i].id)) return;
+        }
+    }
+
+    /**
+     * Calls fn(bucket) once for each distinct seconds / width among the entries, ascending, in
+     * O(buckets * log n) by jumping to the start of the next bucket. Seconds must not be negative.
+     */
+    template <typename Func>
+    void forEachBucket(long long width, Func fn) const {
+        ensureSorted();
+        for (size_t i = 0; i < entries_.size(); i = lowerBound((entries_[i].seconds / width + 1) * width)) {
+            fn(entries_[i].seconds / width);
+        }
+    }
+
+    /** Same as forEachInRange but newest first. */
+    template <typename Func>
+    void forEachInRangeReverse(long long from, long long to, Func fn) const {
+        ensureSorted();
+        size_t begin = lowerBound(from);
+        for (size_t i = lowerBound(to); i > begin; --i) {
+            if (!fn(entries_[i - 1].id)) return;
+        }
+    }
+
+private:
+    struct Entry {
+        long long seconds{0};
+        int id{0};
+    };
+
+    mutable std::vector<Entry> entries_;
+    mutable bool sorted_{true};
+
+    static bool before(const Entry& a, const Entry& b) {
+        return a.seconds != b.seconds ? a.seconds < b.seconds : a.id < b.id;
+    }
+    void ensureSorted() const;
+    /** First position whose seconds >= value. */
+    size_t lowerBound(long long value) const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Order.h"
+#include "WorkflowGraph.h"
+
+/**
+ * Runtime workflow with site-specific stages. Stages get dense ids: 0..5 are the standard
+ * OrderStatus values (same numbering), custom stages follow and each behaves like a base
+ * OrderStatus for queueing and reporting. Adjacency is one bitset row per stage, so a transition
+ * check is a single bit test, and shortest paths come from a next-hop table built by compile().
+ *
+ * Config files start from the standard lifecycle and apply one directive per line:
+ *   state EXPO READY     # new stage EXPO that counts as READY
+ *   edge READY EXPO      # allow READY -> EXPO
+ *   remove READY SERVED  # forbid READY -> SERVED
+ * '#' starts a comment.
+ */
+class WorkflowEngine {
+public:
+    static constexpr size_t kMaxStates = 64;
+    static constexpr int kAnyState = -1;
+    using StateSet = std::bitset<kMaxStates>;
+    using Path = StatePath<int, kMaxStates>;
+    /** Transition callback; plain function pointer plus context so dispatch stays a direct call. */
+    using Hook = void (*)(void* context, Order& order, int from, int to);
+
+    /**
+     * Standard lifecycle: adjacency and next hops are copied from WorkflowGraph's compile-time
+     * tables, so only a loaded config pays for compile().
+     */
+    WorkflowEngine();
+
+    /**
+     * Replaces the graph with the standard lifecycle plus the directives in path. Keeps the old
+     * graph on error; on success all hooks are dropped, since stage ids may have changed.
+     */
+    bool loadConfig(const std::string& path, std::string& error);
+    /** Same as loadConfig but reads directives from text. */
+    bool parseConfig(const std::string& text, std::string& error);
+
+    size_t stateCount() const { return states_.size(); }
+    /** Dense id for a stage name, or -1. */
+    int stateId(const std::string& name) const;
+    const std::string& stateName(int id) const { return states_[static_cast<size_t>(id)].name; }
+    OrderStatus baseStatus(int id) const { return states_[static_cast<size_t>(id)].base; }
+    /** Stage an order is in: its custom stage if set, otherwise the stage of its status. */
+    static int stageOf(const Order& order) { return order.stage >= 0 ? order.stage : static_cast<int>(order.status); }
+
+    bool canTransition(int from, int to) const {
+        return from >= 0 && to >= 0 && static_cast<size_t>(from) < states_.size() && adjacency_[static_cast<size_t>(from)].test(static_cast<size_t>(to));
+    }
+    const StateSet& successors(int from) const { return adjacency_[static_cast<size_t>(from)]; }
+    /** Shortest legal stage path from -> to (inclusive); empty if unreachable. */
+    Path shortestPath(int from, int to) const;
+
+    /** Moves order into stage to and runs the hooks registered for that edge; false if not allowed. */
+    bool apply(Order& order, int to) const;
+
+    /** Registers fn for transitions from (or kAnyState) into to. */
+    void addHook(int from, int to, Hook fn, void* context);
+    /** Registers fn for every transition that makes an order's base status become base. */
+    void addStatusEntryHook(OrderStatus base, Hook fn, void* context);
+    void clearHooks();
+
+private:
+    struct StateInfo {
+        std::string name;
+        OrderStatus base{OrderStatus::Placed};
+    };
+    struct HookEntry {
+        StateSet from;
+        Hook fn{nullptr};
+        void* context{nullptr};
+    };
+
+    std::vector<StateInfo> states_;
+    std::vector<StateSet> adjacency_;
+    std::vector<int> nextHop_;
+    std::vector<std::vector<HookEntry>> hooks_;
+
+    void resetToStandard();
+    int addState(const std::string& name, OrderStatus base);
+    void compile();
+};
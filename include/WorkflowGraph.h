@@ -1,19 +1,158 @@
 #pragma once
 #include "Order.h"
 #include <array>
-#include <vector>
+#include <cstddef>
 
 /**
- * Simple directed graph encoded as adjacency matrix for allowed status transitions.
+ * One allowed status change in a workflow declaration.
  */
-class WorkflowGraph {
+template <typename State>
+struct WorkflowEdge {
+    State from;
+    State to;
+};
+
+/**
+ * Fixed-capacity status path (at most one entry per state), so path lookups never allocate.
+ */
+template <typename State, size_t N>
+class StatePath {
+public:
+    constexpr void push(State s) { states_[size_++] = s; }
+    constexpr size_t size() const { return size_; }
+    constexpr bool empty() const { return size_ == 0; }
+    constexpr State operator[](size_t i) const { return states_[i]; }
+    constexpr const State* begin() const { return states_.data(); }
+    constexpr const State* end() const { return states_.data() + size_; }
+
+private:
+    std::array<State, N> states_{};
+    size_t size_{0};
+};
+
+/**
+ * Adjacency matrix plus all-pairs next-hop table for shortest paths; nextHop is -1 when unreachable.
+ */
+template <size_t N>
+struct WorkflowTables {
+    std::array<std::array<bool, N>, N> allowed{};
+    std::array<std::array<int, N>, N> nextHop{};
+};
+
+/**
+ * Builds the tables from a transition list with one BFS per source state. Meant for constant
+ * evaluation, so it only uses fixed-size arrays.
+ */
+template <typename State, size_t N, size_t E>
+constexpr WorkflowTables<N> buildWorkflowTables(const std::array<WorkflowEdge<State>, E>& edges) {
+    WorkflowTables<N> t{};
+    for (const auto& e : edges) {
+        t.allowed[static_cast<size_t>(e.from)][static_cast<size_t>(e.to)] = true;
+    }
+    for (size_t src = 0; src < N; ++src) {
+        std::array<int, N> prev{};
+        std::array<bool, N> visited{};
+        std::array<size_t, N> queue{};
+        size_t head = 0;
+        size_t tail = 0;
+        for (size_t v = 0; v < N; ++v) {
+            prev[v] = -1;
+            t.nextHop[src][v] = -1;
+        }
+        visited[src] = true;
+        queue[tail++] = src;
+        while (head < tail) {
+            size_t u = queue[head++];
+            for (size_t v = 0; v < N; ++v) {
+                if (!t.allowed[u][v] || visited[v]) continue;
+                visited[v] = true;
+                prev[v] = static_cast<int>(u);
+                queue[tail++] = v;
+            }
+        }
+        t.nextHop[src][src] = static_cast<int>(src);
+        for (size_t dst = 0; dst < N; ++dst) {
+            if (dst == src || !visited[dst]) continue;
+            size_t hop = dst;
+            while (prev[hop] != static_cast<int>(src)) {
+                hop = static_cast<size_t>(prev[hop]);
+            }
+            t.nextHop[src][dst] = static_cast<int>(hop);
+        }
+    }
+    return t;
+}
+
+/**
+ * Directed graph of allowed status transitions, generated at compile time from Spec:
+ *
+ *   struct Spec {
+ *       using State = MyStatus;                     // enum with values 0..kStateCount-1
+ *       static constexpr size_t kStateCount = 7;
+ *       static constexpr std::array<WorkflowEdge<MyStatus>, M> kTransitions{{...}};
+ *   };
+ *
+ * canTransition and shortestPath are table lookups; custom workflows (an extra Plated or OnHold
+ * state, say) only need another Spec. For OrderWorkflowSpec the same tables are also the
+ * runtime default: WorkflowEngine copies them instead of searching the standard graph again.
+ */
+template <typename Spec>
+class BasicWorkflowGraph {
 public:
-    WorkflowGraph();
+    using State = typename Spec::State;
+    static constexpr size_t kStates = Spec::kStateCount;
+    using Path = StatePath<State, kStates>;
+
     /** Returns true if moving from -> to is allowed. */
-    bool canTransition(OrderStatus from, OrderStatus to) const;
+    static constexpr bool canTransition(State from, State to) {
+        size_t f = static_cast<size_t>(from);
+        size_t t = static_cast<size_t>(to);
+        if (f >= kStates || t >= kStates) {
+            return false;
+        }
+        return kTables.allowed[f][t];
+    }
+
     /** Returns the shortest legal status path from -> to (inclusive); empty if unreachable. */
-    std::vector<OrderStatus> shortestPath(OrderStatus from, OrderStatus to) const;
+    static constexpr Path shortestPath(State from, State to) {
+        Path path;
+        size_t at = static_cast<size_t>(from);
+        size_t goal = static_cast<size_t>(to);
+        if (at >= kStates || goal >= kStates || kTables.nextHop[at][goal] < 0) {
+            return path;
+        }
+        path.push(from);
+        while (at != goal) {
+            at = static_cast<size_t>(kTables.nextHop[at][goal]);
+            path.push(static_cast<State>(at));
+        }
+        return path;
+    }
+
+    /** The compile-time adjacency and next-hop tables behind the lookups above. */
+    static constexpr const WorkflowTables<kStates>& tables() { return kTables; }
 
 private:
-    std::array<std::array<bool, 6>, 6> allowed_{};
+    static constexpr WorkflowTables<kStates> kTables = buildWorkflowTables<State, kStates>(Spec::kTransitions);
+};
+
+/**
+ * The standard order lifecycle: PLACED -> QUEUED -> PREPPING -> READY -> SERVED, with
+ * cancellation allowed from any active state.
+ */
+struct OrderWorkflowSpec {
+    using State = OrderStatus;
+    static constexpr size_t kStateCount = 6;
+    static constexpr std::array<WorkflowEdge<OrderStatus>, 8> kTransitions{{
+        {OrderStatus::Placed, OrderStatus::Queued},
+        {OrderStatus::Queued, OrderStatus::Prepping},
+        {OrderStatus::Prepping, OrderStatus::Ready},
+        {OrderStatus::Ready, OrderStatus::Served},
+        {OrderStatus::Placed, OrderStatus::Cancelled},
+        {OrderStatus::Queued, OrderStatus::Cancelled},
+        {OrderStatus::Prepping, OrderStatus::Cancelled},
+        {OrderStatus::Ready, OrderStatus::Cancelled},
+    }};
 };
+
+using WorkflowGraph = BasicWorkflowGraph<OrderWorkflowSpec>;
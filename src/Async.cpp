@@ -0,0 +1,142 @@
+#include "Async.h"
+
+#include <fstream>
+
+void EventLoop::post(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    ready_.notify_one();
+}
+
+void EventLoop::run() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [&] { return stopped_ || !jobs_.empty(); });
+            if (stopped_) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+void EventLoop::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    ready_.notify_all();
+}
+
+WorkerPool::WorkerPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back([this] {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    ready_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+                    if (jobs_.empty()) return;
+                    job = std::move(jobs_.front());
+                    jobs_.pop_front();
+                }
+                job();
+            }
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void WorkerPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back(std::move(job));
+    }
+    ready_.notify_one();
+}
+
+void AsyncMutex::unlock() {
+    if (waiters_.empty()) {
+        locked_ = false;
+        return;
+    }
+    // Ownership passes straight to the next waiter, which resumes on a later loop turn.
+    std::coroutine_handle<> next = waiters_.front();
+    waiters_.pop_front();
+    loop_.post([next] { next.resume(); });
+}
+
+CommandSource::CommandSource(EventLoop& loop, std::string name)
+    : loop_(loop), name_(std::move(name)), link_(std::make_shared<ReaderLink>()) {
+    link_->source = this;
+}
+
+CommandSource::~CommandSource() {
+    {
+        std::lock_guard<std::mutex> lock(link_->mutex);
+        link_->source = nullptr;
+    }
+    // A reader blocked on an interactive terminal cannot be interrupted portably; it exits with
+    // the process and, with the link cleared, never posts again.
+    if (reader_.joinable()) reader_.detach();
+}
+
+void CommandSource::start(std::istream& in) {
+    startReader(in, nullptr);
+}
+
+bool CommandSource::open(const std::string& path) {
+    auto file = std::make_shared<std::ifstream>(path);
+    if (!file->is_open()) return false;
+    startReader(*file, file);
+    return true;
+}
+
+void CommandSource::startReader(std::istream& in, std::shared_ptr<std::istream> owned) {
+    reader_ = std::thread([link = link_, &in, owned] {
+        auto post = [&](std::optional<std::string> line) {
+            std::lock_guard<std::mutex> lock(link->mutex);
+            if (!link->source) return false;
+            CommandSource* source = link->source;
+            source->loop_.post([source, line = std::move(line)]() mutable { source->deliver(std::move(line)); });
+            return true;
+        };
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!post(line)) return;
+        }
+        post(std::nullopt);
+    });
+}
+
+void CommandSource::deliver(std::optional<std::string> line) {
+    if (line) {
+        lines_.push_back(std::move(*line));
+    } else {
+        closed_ = true;
+    }
+    if (waiting_) {
+        std::coroutine_handle<> h = std::exchange(waiting_, {});
+        h.resume();
+    }
+}
+
+std::optional<std::string> CommandSource::NextLine::await_resume() {
+    if (source.lines_.empty()) return std::nullopt;
+    std::string line = std::move(source.lines_.front());
+    source.lines_.pop_front();
+    return line;
+}
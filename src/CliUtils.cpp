@@ -1,13 +1,13 @@
 #include "CliUtils.h"
 
 #include "Sorts.h"
+#include "TableRenderer.h"
 
-#include <cctype>
+#include <chrono>
 #include <cstdlib>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
-#include <sstream>
 
 namespace {
 long long placedSeconds(const Order& o) {
@@ -26,71 +26,58 @@ long long totalOrEstimateSeconds(const Order& o) {
     }
     return static_cast<long long>(o.estimatedPrepMinutes) * 60;
 }
-
-std::string formatTimestamp(long long seconds) {
-    if (seconds <= 0) return "-";
-    std::time_t tt = static_cast<std::time_t>(seconds);
-    std::tm* tm = std::localtime(&tt);
-    if (!tm) return "-";
-    std::ostringstream ss;
-    ss << std::put_time(tm, "%d/%m/%Y %I:%M %p");
-    std::string out = ss.str();
-    for (char& c : out) {
-        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
-    }
-    return out;
-}
 }
 
 void clearScreen() {
 #ifdef _WIN32
     std::system("cls");
 #else
-    std::system("clear");
+    // Same escape sequence clear(1) emits, without spawning a shell on the command thread.
+    std::cout << "\033[H\033[2J\033[3J" << std::flush;
 #endif
 }
 
-std::string readLine() {
-    std::string line;
-    std::getline(std::cin, line);
-    return line;
+Task<std::string> readLine(CommandSource& in) {
+    std::cout << std::flush;
+    auto line = co_await in.nextLine();
+    co_return line ? std::move(*line) : std::string();
 }
 
-bool readPositiveInt(const std::string& prompt, int& out) {
+Task<bool> readPositiveInt(CommandSource& in, std::string prompt, int& out) {
     std::cout << prompt;
-    std::string line = readLine();
+    std::string line = co_await readLine(in);
     try {
         int v = std::stoi(line);
         if (v > 0) {
             out = v;
-            return true;
+            co_return true;
         }
     } catch (...) {
     }
     std::cout << "Invalid number, must be > 0.\n";
-    return false;
+    co_return false;
 }
 
-bool gatherOrderInput(OrderManager& manager, std::string& customer, bool& vip, int& estimate, std::vector<OrderItem>& items) {
+Task<bool> gatherOrderInput(CommandSource& in, OrderManager& manager, std::string& customer, bool& vip, int& estimate, std::vector<OrderItem>& items) {
     std::cout << "Customer name: ";
-    customer = readLine();
+    customer = co_await readLine(in);
     if (customer.empty()) {
         std::cout << "Customer name required.\n";
-        return false;
+        co_return false;
     }
     std::cout << "VIP (y/n): ";
-    std::string vipInput = readLine();
+    std::string vipInput = co_await readLine(in);
     vip = (!vipInput.empty() && (vipInput[0] == 'y' || vipInput[0] == 'Y'));
 
     std::cout << "Enter items (blank name to finish):\n";
     items.clear();
-    int computedEstimate = 0;
+    bool learned = false;
     while (true) {
         std::cout << "  Item name: ";
-        std::string name = readLine();
+        std::string name = co_await readLine(in);
         if (name.empty()) break;
         int qty = 0;
-        if (!readPositiveInt("  Quantity: ", qty)) {
+        if (!co_await readPositiveInt(in, "  Quantity: ", qty)) {
             std::cout << "  Skipping this item due to invalid quantity.\n";
             continue;
         }
@@ -100,20 +87,22 @@ bool gatherOrderInput(OrderManager& manager, std::string& customer, bool& vip, i
         MenuItem* menu = manager.findMenuItem(name);
         if (menu) {
             it.itemId = menu->itemId;
-            computedEstimate += menu->defaultPrepMinutes * qty;
+            if (manager.prepEstimator().stats(menu->itemId)) learned = true;
         }
         items.push_back(it);
     }
 
+    int computedEstimate = manager.estimatePrepMinutes(items);
     if (computedEstimate > 0) {
         estimate = computedEstimate;
-        std::cout << "Estimated prep minutes (from menu defaults): " << estimate << "\n";
+        std::cout << "Estimated prep minutes (" << (learned ? "learned from past orders" : "from menu defaults")
+                  << ", " << manager.kitchenLoad() << " in prep): " << estimate << "\n";
     } else {
-        if (!readPositiveInt("Estimated prep minutes: ", estimate)) {
-            return false;
+        if (!co_await readPositiveInt(in, "Estimated prep minutes: ", estimate)) {
+            co_return false;
         }
     }
-    return true;
+    co_return true;
 }
 
 bool parseId(const std::string& token, int& out) {
@@ -125,6 +114,106 @@ bool parseId(const std::string& token, int& out) {
     }
 }
 
+bool parseTimeToken(const std::string& token, long long now, long long& out) {
+    if (token.empty()) return false;
+    if (token[0] == '-' && token.size() > 2) {
+        char unit = token.back();
+        long long amount = 0;
+        try { amount = std::stoll(token.substr(1, token.size() - 2)); } catch (...) { return false; }
+        if (amount < 0 || (unit != 'm' && unit != 'h')) return false;
+        out = now - amount * (unit == 'h' ? 3600 : 60);
+        return true;
+    }
+    auto colon = token.find(':');
+    if (colon != std::string::npos) {
+        int hour = 0;
+        int minute = 0;
+        try {
+            hour = std::stoi(token.substr(0, colon));
+            minute = std::stoi(token.substr(colon + 1));
+        } catch (...) {
+            return false;
+        }
+        if (hour < 0 || hour > 23 || minute < 0 || minute > 59) return false;
+        std::time_t tt = static_cast<std::time_t>(now);
+        std::tm* tm = std::localtime(&tt);
+        if (!tm) return false;
+        std::tm local = *tm;
+        local.tm_hour = hour;
+        local.tm_min = minute;
+        local.tm_sec = 0;
+        local.tm_isdst = -1;
+        out = static_cast<long long>(std::mktime(&local));
+        return true;
+    }
+    try {
+        size_t used = 0;
+        out = std::stoll(token, &used);
+        return used == token.size() && out > 0;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool parseDuration(const std::string& token, long long& seconds) {
+    size_t start = !token.empty() && token[0] == '+' ? 1 : 0;
+    if (token.size() < start + 2) return false;
+    char unit = token.back();
+    long long scale = unit == 's' ? 1 : unit == 'm' ? 60 : unit == 'h' ? 3600 : 0;
+    if (scale == 0) return false;
+    try {
+        size_t used = 0;
+        long long amount = std::stoll(token.substr(start, token.size() - start - 1), &used);
+        if (used != token.size() - start - 1 || amount <= 0) return false;
+        seconds = amount * scale;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool parseListOptions(OrderManager& manager, const std::vector<std::string>& args, ListQuery& query, std::string& positional) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--limit" || arg == "--after") {
+            int value = 0;
+            if (i + 1 >= args.size() || !parseId(args[i + 1], value) || value <= 0) {
+                std::cout << "Option " << arg << " needs a positive number.\n";
+                return false;
+            }
+            ++i;
+            if (arg == "--limit") {
+                query.limit = static_cast<size_t>(value);
+            } else if (manager.getOrder(value)) {
+                query.afterId = value;
+            } else {
+                std::cout << "Cursor order " << value << " not found.\n";
+                return false;
+            }
+        } else if (arg == "--since" || arg == "--until") {
+            long long seconds = 0;
+            if (i + 1 >= args.size() || !parseTimeToken(args[i + 1], TimeUtils::toSeconds(manager.now()), seconds)) {
+                std::cout << "Option " << arg << " needs HH:MM (today), -<N>m / -<N>h, or epoch seconds.\n";
+                return false;
+            }
+            ++i;
+            (arg == "--since" ? query.since : query.until) = seconds;
+        } else if (arg == "--served") {
+            query.byServed = true;
+        } else if (arg == "--newest") {
+            query.newestFirst = true;
+        } else if (arg == "--oldest") {
+            query.newestFirst = false;
+        } else if (positional.empty()) {
+            positional = arg;
+        } else {
+            std::cout << "Unexpected argument: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
 void printHelp() {
     std::cout << "Commands:\n"
               << "  new                 - create a new order\n"
@@ -134,14 +223,26 @@ void printHelp() {
               << "  ready <id>          - mark order as READY\n"
               << "  serve <id>          - mark order as SERVED\n"
               << "  cancel <id>         - cancel an order\n"
-              << "  show <id>           - show order details\n"
+              << "  show <id>           - show order details and ETA\n"
+              << "  advance <id> <STAGE> - move an order to a custom workflow stage\n"
+              << "  events              - show order events since the last call (kitchen display feed)\n"
+              << "  workflow            - show workflow stages and allowed transitions\n"
               << "  list [status]       - list orders (all or by status)\n"
               << "  report active       - list active orders sorted (placed time)\n"
               << "  report completed    - list completed orders sorted (served time)\n"
-              << "  find <id>           - find order by id\n"
+              << "    list/report options: --limit N, --newest, --after <id> (next page),\n"
+              << "                         --since/--until HH:MM|-15m|-2h|epoch, --served (by served time)\n"
+              << "  find <id>           - find order by id (live, then the archive)\n"
+              << "  find name <prefix>  - live and archived orders by customer name prefix (fuzzy if none)\n"
               << "  menu add/remove/find/list - manage menu (BST)\n"
-              << "  save [path]         - save state to JSON (default data.json)\n"
-              << "  load [path]         - load state from JSON (default data.json)\n"
+              << "  save [path]         - save state to JSON in the background (default db.json)\n"
+              << "  load [path]         - load state from JSON (default db.json), after pending saves\n"
+              << "  save|load --segments [dir] - incremental per-day segment store (default db.segments)\n"
+              << "  archive [--before <time>] - move served/cancelled orders into the archive, then save\n"
+              << "  archive report [options]  - archived orders by time (list options), reading matching blocks only\n"
+              << "  archive stats       - archive size and block count\n"
+              << "  export csv|columnar [path] [--no-archive] [--threads N] - stream live and archived orders to a file\n"
+              << "  clock [+<N>s|m|h]   - show the order clock; advance it (--clock virtual)\n"
               << "  clear               - clear the console\n"
               << "  help                - show this help\n"
               << "  exit                - quit\n";
@@ -166,42 +267,16 @@ void printOrder(const Order& o) {
     }
 }
 
-void printOrdersTable(const std::vector<Order>& orders) {
+void printOrdersTable(TableRenderer& renderer, std::string& buffer, const std::vector<Order>& orders) {
     if (orders.empty()) {
         std::cout << "No orders.\n";
         return;
     }
 
-    auto timeStr = [](long long s) {
-        return formatTimestamp(s);
-    };
-
-    std::cout << std::left
-              << std::setw(5) << "ID"
-              << std::setw(14) << "Customer"
-              << std::setw(5) << "VIP"
-              << std::setw(10) << "Status"
-              << std::setw(8) << "Est"
-              << std::setw(20) << "Placed"
-              << std::setw(20) << "Started"
-              << std::setw(20) << "Ready"
-              << std::setw(20) << "Served"
-              << "\n";
-    std::cout << std::string(122, '-') << "\n";
-
-    for (const auto& o : orders) {
-        std::cout << std::left
-                  << std::setw(5) << o.id
-                  << std::setw(14) << o.customerName.substr(0, 13)
-                  << std::setw(5) << (o.isVip ? "yes" : "no")
-                  << std::setw(10) << OrderStatusStrings::toString(o.status)
-                  << std::setw(8) << o.estimatedPrepMinutes
-                  << std::setw(20) << timeStr(placedSeconds(o))
-                  << std::setw(20) << timeStr(TimeUtils::toSeconds(o.startedAt))
-                  << std::setw(20) << timeStr(TimeUtils::toSeconds(o.readyAt))
-                  << std::setw(20) << timeStr(TimeUtils::toSeconds(o.servedAt))
-                  << "\n";
-    }
+    // Rows are rendered into one reused buffer and written once, so cost tracks the page size.
+    buffer.clear();
+    renderer.renderOrders(orders, buffer);
+    std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 void printMenuTable(const std::vector<MenuItem>& items) {
@@ -224,6 +299,37 @@ void printMenuTable(const std::vector<MenuItem>& items) {
     }
 }
 
+void printWorkflow(const WorkflowEngine& workflow) {
+    for (size_t i = 0; i < workflow.stateCount(); ++i) {
+        int id = static_cast<int>(i);
+        std::cout << std::left << std::setw(12) << workflow.stateName(id)
+                  << "(" << OrderStatusStrings::toString(workflow.baseStatus(id)) << ") ->";
+        const auto& next = workflow.successors(id);
+        bool any = false;
+        for (size_t j = 0; j < workflow.stateCount(); ++j) {
+            if (next.test(j)) {
+                std::cout << " " << workflow.stateName(static_cast<int>(j));
+                any = true;
+            }
+        }
+        std::cout << (any ? "" : " (terminal)") << "\n";
+    }
+}
+
+void printEvents(const WorkflowEngine& workflow, OrderEventRing& ring) {
+    size_t count = ring.drain([&](const OrderEvent& e) {
+        std::cout << "Order " << e.orderId << " " << OrderEventStrings::toString(e.type);
+        if (e.type == OrderEventType::Transitioned || e.type == OrderEventType::Cancelled) {
+            std::cout << " " << workflow.stateName(e.fromStage) << " -> " << workflow.stateName(e.toStage);
+        }
+        std::cout << "\n";
+    });
+    if (count == 0) std::cout << "No new events.\n";
+    if (ring.dropped() > 0) {
+        std::cout << ring.dropped() << " events dropped so far (display ring full).\n";
+    }
+}
+
 void sortOrders(std::vector<Order>& orders, const std::string& metric) {
     auto cmp = [&](const Order& a, const Order& b) {
         if (metric == "prep") return a.estimatedPrepMinutes < b.estimatedPrepMinutes;
@@ -231,5 +337,5 @@ void sortOrders(std::vector<Order>& orders, const std::string& metric) {
         if (metric == "served") return servedSeconds(a) < servedSeconds(b);
         return placedSeconds(a) < placedSeconds(b);
     };
-    Sorts::mergeSort(orders, cmp);
+    Sorts::parallelMergeSort(orders, cmp);
 }
@@ -0,0 +1,36 @@
+#include "Clock.h"
+#include "Order.h"
+
+RealClock& RealClock::instance() {
+    static RealClock clock;
+    return clock;
+}
+
+MonotonicClock::MonotonicClock(double rate)
+    : wallStart_(std::chrono::system_clock::now()), steadyStart_(std::chrono::steady_clock::now()), rate_(rate > 0 ? rate : 1.0) {}
+
+ServiceClock::time_point MonotonicClock::now() {
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - steadyStart_) * rate_;
+    return wallStart_ + std::chrono::duration_cast<std::chrono::system_clock::duration>(elapsed);
+}
+
+VirtualClock::VirtualClock(time_point start, std::chrono::nanoseconds tick) : nanos_(TimeUtils::toNanos(start)), tick_(tick.count()) {}
+
+ServiceClock::time_point VirtualClock::now() {
+    return TimeUtils::fromNanos(tick_ ? nanos_.fetch_add(tick_) : nanos_.load());
+}
+
+ServiceClock::time_point VirtualClock::peek() const {
+    return TimeUtils::fromNanos(nanos_.load());
+}
+
+void VirtualClock::advance(std::chrono::nanoseconds by) {
+    if (by.count() > 0) nanos_.fetch_add(by.count());
+}
+
+void VirtualClock::advanceTo(time_point at) {
+    long long target = TimeUtils::toNanos(at);
+    long long current = nanos_.load();
+    while (current < target && !nanos_.compare_exchange_weak(current, target)) {
+    }
+}
@@ -0,0 +1,298 @@
+#include "CustomerIndex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <utility>
+
+CustomerIndex::CustomerIndex() {
+    clear();
+}
+
+void CustomerIndex::clear() {
+    nodes_.assign(1, TrieNode{});
+    postings_.clear();
+    freeRuns_.clear();
+    gramBits_ = 8;
+    grams_.assign(size_t{1} << gramBits_, GramSlot{});
+    gramsUsed_ = 0;
+    nextSameName_.clear();
+    nodeById_.clear();
+    runById_.clear();
+    gramsById_.clear();
+}
+
+void CustomerIndex::normalize(const std::string& name, std::string& key) {
+    key.clear();
+    for (char c : name) {
+        key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+}
+
+void CustomerIndex::trigramsOf(const std::string& key, std::vector<std::uint32_t>& out) {
+    // As if padded with two leading spaces and one trailing space, so short names and word
+    // starts still produce trigrams.
+    out.clear();
+    size_t padded = key.size() + 3;
+    auto at = [&](size_t i) -> std::uint32_t {
+        if (i < 2 || i >= key.size() + 2) return static_cast<unsigned char>(' ');
+        return static_cast<unsigned char>(key[i - 2]);
+    };
+    for (size_t i = 0; i + 3 <= padded; ++i) {
+        out.push_back((at(i) << 16) | (at(i + 1) << 8) | at(i + 2));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+int CustomerIndex::child(int node, char c) const {
+    for (int k = nodes_[static_cast<size_t>(node)].firstChild; k >= 0; k = nodes_[static_cast<size_t>(k)].nextSibling) {
+        char kc = nodes_[static_cast<size_t>(k)].ch;
+        if (kc == c) return k;
+        if (kc > c) break;
+    }
+    return -1;
+}
+
+int CustomerIndex::walk(const std::string& key) const {
+    int node = 0;
+    for (char c : key) {
+        node = child(node, c);
+        if (node < 0) return -1;
+    }
+    return node;
+}
+
+int CustomerIndex::walkOrCreate(const std::string& key) {
+    int node = 0;
+    for (char c : key) {
+        // Find the sibling slot that keeps children in character order.
+        int prev = -1;
+        int k = nodes_[static_cast<size_t>(node)].firstChild;
+        while (k >= 0 && nodes_[static_cast<size_t>(k)].ch < c) {
+            prev = k;
+            k = nodes_[static_cast<size_t>(k)].nextSibling;
+        }
+        if (k < 0 || nodes_[static_cast<size_t>(k)].ch != c) {
+            TrieNode created;
+            created.parent = node;
+            created.nextSibling = k;
+            created.ch = c;
+            int index = static_cast<int>(nodes_.size());
+            nodes_.push_back(created);
+            if (prev < 0) {
+                nodes_[static_cast<size_t>(node)].firstChild = index;
+            } else {
+                nodes_[static_cast<size_t>(prev)].nextSibling = index;
+            }
+            k = index;
+        }
+        node = k;
+    }
+    return node;
+}
+
+int CustomerIndex::findGram(std::uint32_t gram) const {
+    size_t mask = grams_.size() - 1;
+    for (size_t i = (gram * 0x9E3779B1u) >> (32 - gramBits_);; i = (i + 1) & mask) {
+        if (grams_[i].gram == gram) return static_cast<int>(i);
+        if (grams_[i].gram == kNoGram) return -1;
+    }
+}
+
+int CustomerIndex::gramSlot(std::uint32_t gram) {
+    int found = findGram(gram);
+    if (found >= 0) return found;
+    if ((gramsUsed_ + 1) * 2 > grams_.size()) {
+        // Rehash; first postings encode their list's slot, so they are re-pointed too.
+        std::vector<GramSlot> old(size_t{1} << (gramBits_ + 1), GramSlot{});
+        old.swap(grams_);
+        ++gramBits_;
+        for (const GramSlot& g : old) {
+            if (g.gram == kNoGram) continue;
+            size_t mask = grams_.size() - 1;
+            size_t i = (g.gram * 0x9E3779B1u) >> (32 - gramBits_);
+            while (grams_[i].gram != kNoGram) i = (i + 1) & mask;
+            grams_[i] = g;
+            if (g.head >= 0) postings_[static_cast<size_t>(g.head)].prev = -2 - static_cast<int>(i);
+        }
+    }
+    size_t mask = grams_.size() - 1;
+    size_t i = (gram * 0x9E3779B1u) >> (32 - gramBits_);
+    while (grams_[i].gram != kNoGram) i = (i + 1) & mask;
+    grams_[i].gram = gram;
+    ++gramsUsed_;
+    return static_cast<int>(i);
+}
+
+int CustomerIndex::allocRun(size_t length) {
+    if (length < freeRuns_.size() && freeRuns_[length] >= 0) {
+        int run = freeRuns_[length];
+        freeRuns_[length] = postings_[static_cast<size_t>(run)].next;
+        return run;
+    }
+    int run = static_cast<int>(postings_.size());
+    postings_.resize(postings_.size() + length);
+    return run;
+}
+
+void CustomerIndex::addPostings(int id, const std::string& key) {
+    trigramsOf(key, gramScratch_);
+    int run = allocRun(gramScratch_.size());
+    for (size_t i = 0; i < gramScratch_.size(); ++i) {
+        int slot = gramSlot(gramScratch_[i]);
+        int p = run + static_cast<int>(i);
+        int head = grams_[static_cast<size_t>(slot)].head;
+        postings_[static_cast<size_t>(p)] = Posting{id, head, -2 - slot};
+        if (head >= 0) postings_[static_cast<size_t>(head)].prev = p;
+        grams_[static_cast<size_t>(slot)].head = p;
+    }
+    runById_[static_cast<size_t>(id)] = run;
+    gramsById_[static_cast<size_t>(id)] = static_cast<int>(gramScratch_.size());
+}
+
+void CustomerIndex::dropPostings(int id) {
+    size_t slot = static_cast<size_t>(id);
+    int run = runById_[slot];
+    if (run < 0) return;
+    size_t length = static_cast<size_t>(gramsById_[slot]);
+    for (size_t i = 0; i < length; ++i) {
+        const Posting& p = postings_[static_cast<size_t>(run) + i];
+        if (p.next >= 0) postings_[static_cast<size_t>(p.next)].prev = p.prev;
+        if (p.prev >= 0) {
+            postings_[static_cast<size_t>(p.prev)].next = p.next;
+        } else {
+            grams_[static_cast<size_t>(-2 - p.prev)].head = p.next;
+        }
+    }
+    if (length >= freeRuns_.size()) freeRuns_.resize(length + 1, -1);
+    postings_[static_cast<size_t>(run)].next = freeRuns_[length];
+    freeRuns_[length] = run;
+    runById_[slot] = -1;
+    gramsById_[slot] = 0;
+}
+
+void CustomerIndex::add(int id, const std::string& name) {
+    if (id <= 0) return;
+    size_t slot = static_cast<size_t>(id);
+    if (slot >= nodeById_.size()) {
+        nodeById_.resize(slot + 1, -1);
+        nextSameName_.resize(slot + 1, 0);
+        runById_.resize(slot + 1, -1);
+        gramsById_.resize(slot + 1, 0);
+    }
+    if (nodeById_[slot] >= 0) unlink(id);
+
+    normalize(name, keyScratch_);
+    int node = walkOrCreate(keyScratch_);
+    nextSameName_[slot] = nodes_[static_cast<size_t>(node)].firstId;
+    nodes_[static_cast<size_t>(node)].firstId = id;
+    nodeById_[slot] = node;
+    addPostings(id, keyScratch_);
+}
+
+void CustomerIndex::unlink(int id) {
+    size_t slot = static_cast<size_t>(id);
+    int node = nodeById_[slot];
+    int* link = &nodes_[static_cast<size_t>(node)].firstId;
+    while (*link != 0 && *link != id) {
+        link = &nextSameName_[static_cast<size_t>(*link)];
+    }
+    if (*link == id) *link = nextSameName_[slot];
+    nextSameName_[slot] = 0;
+    nodeById_[slot] = -1;
+    dropPostings(id);
+}
+
+void CustomerIndex::remove(int id) {
+    if (id <= 0 || static_cast<size_t>(id) >= nodeById_.size() || nodeById_[static_cast<size_t>(id)] < 0) return;
+    unlink(id);
+}
+
+void CustomerIndex::rename(int id, const std::string& oldName, const std::string& newName) {
+    normalize(oldName, oldKeyScratch_);
+    normalize(newName, keyScratch_);
+    if (oldKeyScratch_ == keyScratch_) return;
+    add(id, newName);
+}
+
+std::vector<int> CustomerIndex::prefix(const std::string& prefix, size_t limit) const {
+    std::vector<int> out;
+    std::string key;
+    normalize(prefix, key);
+    int start = walk(key);
+    if (start < 0) return out;
+    // Preorder walk over the subtree: node, then children left to right, so results come back
+    // sorted by name. Sibling links of start itself are outside the subtree and never followed.
+    int node = start;
+    while (node >= 0) {
+        for (int id = nodes_[static_cast<size_t>(node)].firstId; id != 0; id = nextSameName_[static_cast<size_t>(id)]) {
+            out.push_back(id);
+            if (limit > 0 && out.size() == limit) return out;
+        }
+        if (nodes_[static_cast<size_t>(node)].firstChild >= 0) {
+            node = nodes_[static_cast<size_t>(node)].firstChild;
+            continue;
+        }
+        while (node != start && nodes_[static_cast<size_t>(node)].nextSibling < 0) {
+            node = nodes_[static_cast<size_t>(node)].parent;
+        }
+        node = node == start ? -1 : nodes_[static_cast<size_t>(node)].nextSibling;
+    }
+    return out;
+}
+
+std::vector<int> CustomerIndex::fuzzy(const std::string& query, size_t limit, double minScore) const {
+    std::string key;
+    normalize(query, key);
+    std::vector<std::uint32_t> queryGrams;
+    trigramsOf(key, queryGrams);
+    // Jaccard >= minScore needs at least minScore * |query| shared trigrams, so ids with fewer
+    // posting hits are dropped before the exact recount. Hits are counted in a dense array kept
+    // across calls; only the entries this query touched are zeroed again at the end.
+    size_t needed = static_cast<size_t>(minScore * static_cast<double>(queryGrams.size()));
+    if (needed == 0) needed = 1;
+    if (hitScratch_.size() < nodeById_.size()) hitScratch_.resize(nodeById_.size(), 0);
+    std::vector<std::uint32_t>& hits = hitScratch_;
+    std::vector<int>& touched = touchedScratch_;
+    touched.clear();
+    // The lists are walked round-robin so their independent cache misses overlap, instead of
+    // one dependent load at a time down a single list.
+    std::vector<int> cursors;
+    for (std::uint32_t t : queryGrams) {
+        int slot = findGram(t);
+        if (slot >= 0 && grams_[static_cast<size_t>(slot)].head >= 0) cursors.push_back(grams_[static_cast<size_t>(slot)].head);
+    }
+    while (!cursors.empty()) {
+        for (size_t c = 0; c < cursors.size();) {
+            const Posting& posting = postings_[static_cast<size_t>(cursors[c])];
+            if (hits[static_cast<size_t>(posting.id)]++ == 0) touched.push_back(posting.id);
+            if (posting.next >= 0) {
+                cursors[c++] = posting.next;
+            } else {
+                cursors[c] = cursors.back();
+                cursors.pop_back();
+            }
+        }
+    }
+
+    // Postings hold exactly each current name's trigrams, so the hit count is the overlap.
+    std::vector<std::pair<double, int>> scored;
+    for (int id : touched) {
+        std::uint32_t shared = hits[static_cast<size_t>(id)];
+        hits[static_cast<size_t>(id)] = 0;
+        if (shared < needed) continue;
+        double common = static_cast<double>(shared);
+        double names = static_cast<double>(gramsById_[static_cast<size_t>(id)]);
+        double score = common / (static_cast<double>(queryGrams.size()) + names - common);
+        if (score >= minScore) scored.emplace_back(score, id);
+    }
+    std::sort(scored.begin(), scored.end(), [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    std::vector<int> out;
+    for (const auto& s : scored) {
+        if (limit > 0 && out.size() == limit) break;
+        out.push_back(s.second);
+    }
+    return out;
+}
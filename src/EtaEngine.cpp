@@ -0,0 +1,99 @@
+#include "EtaEngine.h"
+
+size_t FenwickTree::append(long long value) {
+    // The new node k covers (k - lowbit(k), k]; everything but position k itself is already in
+    // the tree, so its initial sum is a difference of two prefix sums.
+    size_t k = tree_.size() + 1;
+    size_t lowbit = k & (~k + 1);
+    long long covered = prefix(k - 1) - prefix(k - lowbit);
+    tree_.push_back(covered + value);
+    return k - 1;
+}
+
+void FenwickTree::add(size_t index, long long delta) {
+    for (size_t k = index + 1; k <= tree_.size(); k += k & (~k + 1)) {
+        tree_[k - 1] += delta;
+    }
+}
+
+long long FenwickTree::prefix(size_t end) const {
+    long long sum = 0;
+    for (size_t k = end; k > 0; k -= k & (~k + 1)) {
+        sum += tree_[k - 1];
+    }
+    return sum;
+}
+
+void EtaEngine::enqueue(int id, bool vip, int minutes) {
+    if (id <= 0) return;
+    size_t slotIndex = static_cast<size_t>(id);
+    if (slotIndex >= slots_.size()) slots_.resize(slotIndex + 1);
+    if (slots_[slotIndex].lane != None) remove(id);
+    Slot& slot = slots_[slotIndex];
+    slot.minutes = minutes;
+    if (vip) {
+        while (vip_.size() <= slotIndex) vip_.append(0);
+        slot.lane = Vip;
+        slot.position = slotIndex;
+        vip_.add(slotIndex, minutes);
+        vipTotal_ += minutes;
+    } else {
+        slot.lane = Normal;
+        slot.position = normal_.append(minutes);
+        normalTotal_ += minutes;
+        ++normalCount_;
+    }
+}
+
+void EtaEngine::update(int id, bool vip, int minutes) {
+    if (!isQueued(id)) return;
+    Slot& slot = slots_[static_cast<size_t>(id)];
+    if ((slot.lane == Vip) != vip) {
+        enqueue(id, vip, minutes);
+        return;
+    }
+    long long delta = static_cast<long long>(minutes) - slot.minutes;
+    slot.minutes = minutes;
+    if (slot.lane == Vip) {
+        vip_.add(slot.position, delta);
+        vipTotal_ += delta;
+    } else {
+        normal_.add(slot.position, delta);
+        normalTotal_ += delta;
+    }
+}
+
+void EtaEngine::remove(int id) {
+    if (!isQueued(id)) return;
+    Slot& slot = slots_[static_cast<size_t>(id)];
+    if (slot.lane == Vip) {
+        vip_.add(slot.position, -slot.minutes);
+        vipTotal_ -= slot.minutes;
+    } else {
+        normal_.add(slot.position, -slot.minutes);
+        normalTotal_ -= slot.minutes;
+        // Sequence positions are never reused; start over whenever the lane drains.
+        if (--normalCount_ == 0) normal_.clear();
+    }
+    slot = Slot{};
+}
+
+bool EtaEngine::isQueued(int id) const {
+    return id > 0 && static_cast<size_t>(id) < slots_.size() && slots_[static_cast<size_t>(id)].lane != None;
+}
+
+long long EtaEngine::minutesAhead(int id) const {
+    if (!isQueued(id)) return -1;
+    const Slot& slot = slots_[static_cast<size_t>(id)];
+    if (slot.lane == Vip) return vip_.prefix(slot.position);
+    return vipTotal_ + normal_.prefix(slot.position);
+}
+
+void EtaEngine::clear() {
+    vip_.clear();
+    normal_.clear();
+    vipTotal_ = 0;
+    normalTotal_ = 0;
+    normalCount_ = 0;
+    slots_.clear();
+}
@@ -0,0 +1,11 @@
+#include "EventRing.h"
+
+std::string OrderEventStrings::toString(OrderEventType type) {
+    switch (type) {
+        case OrderEventType::Created: return "CREATED";
+        case OrderEventType::Edited: return "EDITED";
+        case OrderEventType::Transitioned: return "TRANSITIONED";
+        case OrderEventType::Cancelled: return "CANCELLED";
+    }
+    return "UNKNOWN";
+}
@@ -5,6 +5,24 @@ void VipHeap::push(const VipEntry& entry) {
     heapifyUp(data_.size() - 1);
 }
 
+void VipHeap::pushMany(const std::vector<VipEntry>& entries) {
+    // Sift-up costs about k*log(n + k); a rebuild costs about n + k. Pick the cheaper one.
+    size_t before = data_.size();
+    data_.reserve(before + entries.size());
+    data_.insert(data_.end(), entries.begin(), entries.end());
+    size_t logN = 1;
+    for (size_t n = data_.size(); n > 1; n >>= 1) ++logN;
+    if (entries.size() * logN < data_.size()) {
+        for (size_t i = before; i < data_.size(); ++i) {
+            heapifyUp(i);
+        }
+        return;
+    }
+    for (size_t i = data_.size() / 2; i > 0; --i) {
+        heapifyDown(i - 1);
+    }
+}
+
 bool VipHeap::pop(VipEntry& out) {
     if (data_.empty()) {
         return false;
@@ -28,7 +46,9 @@ std::vector<int> VipHeap::snapshotIds() const {
 }
 
 bool VipHeap::higherPriority(const VipEntry& a, const VipEntry& b) {
-    return a.placedAtSeconds < b.placedAtSeconds;
+    // Ties go to the lower id, so pop order depends only on the entries, not on how they were inserted.
+    if (a.placedAtNanos != b.placedAtNanos) return a.placedAtNanos < b.placedAtNanos;
+    return a.orderId < b.orderId;
 }
 
 void VipHeap::heapifyUp(size_t idx) {
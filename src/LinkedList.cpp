@@ -1,5 +1,7 @@
 #include "LinkedList.h"
 
+#include <utility>
+
 OrderList::OrderList() = default;
 
 OrderList::~OrderList() {
@@ -7,8 +9,17 @@ OrderList::~OrderList() {
 }
 
 OrderNode* OrderList::pushBack(const Order& order) {
+    return pushBack(Order(order));
+}
+
+OrderNode* OrderList::pushBack(Order&& order) {
+    OrderNode* node = emplaceBack();
+    node->data = std::move(order);
+    return node;
+}
+
+OrderNode* OrderList::emplaceBack() {
     OrderNode* node = new OrderNode();
-    node->data = order;
     node->prev = tail_;
     if (tail_) {
         tail_->next = node;
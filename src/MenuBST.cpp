@@ -4,6 +4,24 @@ MenuBST::~MenuBST() {
     destroy(root_);
 }
 
+MenuBST::MenuBST(MenuBST&& other) noexcept : root_(other.root_) {
+    other.root_ = nullptr;
+}
+
+MenuBST& MenuBST::operator=(MenuBST&& other) noexcept {
+    if (this != &other) {
+        destroy(root_);
+        root_ = other.root_;
+        other.root_ = nullptr;
+    }
+    return *this;
+}
+
+void MenuBST::clear() {
+    destroy(root_);
+    root_ = nullptr;
+}
+
 void MenuBST::destroy(MenuNode* node) {
     if (!node) return;
     destroy(node->left);
@@ -1,16 +1,18 @@
 #include "Order.h"
 #include <sstream>
 
+namespace {
+    /** Status names indexed by OrderStatus. */
+    const char* const kStatusNames[] = {"PLACED", "QUEUED", "PREPPING", "READY", "SERVED", "CANCELLED"};
+}
+
+const char* OrderStatusStrings::name(OrderStatus status) {
+    size_t index = static_cast<size_t>(status);
+    return index < sizeof(kStatusNames) / sizeof(kStatusNames[0]) ? kStatusNames[index] : "UNKNOWN";
+}
+
 std::string OrderStatusStrings::toString(OrderStatus status) {
-    switch (status) {
-        case OrderStatus::Placed: return "PLACED";
-        case OrderStatus::Queued: return "QUEUED";
-        case OrderStatus::Prepping: return "PREPPING";
-        case OrderStatus::Ready: return "READY";
-        case OrderStatus::Served: return "SERVED";
-        case OrderStatus::Cancelled: return "CANCELLED";
-    }
-    return "UNKNOWN";
+    return name(status);
 }
 
 bool OrderStatusStrings::fromString(const std::string& text, OrderStatus& out) {
@@ -30,3 +32,12 @@ long long TimeUtils::toSeconds(const std::chrono::system_clock::time_point& tp)
 std::chrono::system_clock::time_point TimeUtils::fromSeconds(long long seconds) {
     return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
 }
+
+long long TimeUtils::toNanos(const std::chrono::system_clock::time_point& tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point TimeUtils::fromNanos(long long nanos) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(nanos)));
+}
@@ -0,0 +1,545 @@
+#include "OrderArchive.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <string_view>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    constexpr size_t kMinMatch = 4;
+    constexpr size_t kMaxOffset = 65535;
+    constexpr unsigned kHashBits = 14;
+
+    void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    uint64_t zigzag(int64_t value) {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value) {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    /** Bounds-checked cursor over encoded bytes; any overrun clears ok and reads zeros. */
+    struct Reader {
+        const unsigned char* pos;
+        const unsigned char* end;
+        bool ok{true};
+
+        Reader() : pos(nullptr), end(nullptr) {}
+        Reader(const char* data, size_t size)
+            : pos(reinterpret_cast<const unsigned char*>(data)), end(pos + size) {}
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                if (pos == end) break;
+                unsigned char byte = *pos++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return value;
+            }
+            ok = false;
+            return 0;
+        }
+        int64_t signedVarint() { return unzigzag(varint()); }
+        unsigned char byte() {
+            if (pos == end) {
+                ok = false;
+                return 0;
+            }
+            return *pos++;
+        }
+        /** Splits off the next length-prefixed section. */
+        Reader section() {
+            uint64_t size = varint();
+            if (!ok || size > static_cast<uint64_t>(end - pos)) {
+                ok = false;
+                return Reader();
+            }
+            Reader part(reinterpret_cast<const char*>(pos), static_cast<size_t>(size));
+            pos += size;
+            return part;
+        }
+        std::string text() {
+            Reader part = section();
+            ok = ok && part.ok;
+            return std::string(reinterpret_cast<const char*>(part.pos), static_cast<size_t>(part.end - part.pos));
+        }
+    };
+
+    void putLength(std::string& out, size_t length) {
+        if (length >= 15) putVarint(out, length - 15);
+    }
+
+    size_t getLength(Reader& in, size_t nibble) {
+        return nibble == 15 ? 15 + static_cast<size_t>(in.varint()) : nibble;
+    }
+
+    void emitSequence(std::string& out, const char* literals, size_t literalCount, size_t offset, size_t matchLength) {
+        size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+        out.push_back(static_cast<char>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        putLength(out, literalCount);
+        out.append(literals, literalCount);
+        if (!matchLength) return;
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>(offset >> 8));
+        putLength(out, matchCode);
+    }
+
+    uint32_t fnv1a(const char* data, size_t size) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i) hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+        return hash;
+    }
+
+    bool fail(std::string* error, const std::string& what) {
+        if (error) *error = what + (errno ? std::string(": ") + std::strerror(errno) : "");
+        return false;
+    }
+
+    bool writeAt(int fd, const void* data, size_t size, uint64_t offset) {
+        const char* bytes = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            bytes += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool readAt(int fd, void* data, size_t size, uint64_t offset) {
+        char* bytes = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t n = pread(fd, bytes, size, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            bytes += n;
+            size -= static_cast<size_t>(n);
+            offset += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+
+    long long secondsOrZero(const std::chrono::system_clock::time_point& tp) {
+        return tp == std::chrono::system_clock::time_point{} ? 0 : TimeUtils::toSeconds(tp);
+    }
+}
+
+void BlockCodec::compress(const std::string& in, std::string& out) {
+    out.clear();
+    out.reserve(in.size() / 2 + 16);
+    const char* src = in.data();
+    const size_t n = in.size();
+    // Position + 1 of the last occurrence of each 4-byte hash; 0 = none.
+    std::vector<uint32_t> table(size_t{1} << kHashBits, 0);
+    size_t anchor = 0;
+    size_t i = 0;
+    while (i + kMinMatch <= n) {
+        uint32_t word;
+        std::memcpy(&word, src + i, sizeof(word));
+        uint32_t hash = (word * 2654435761u) >> (32 - kHashBits);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > kMaxOffset || std::memcmp(src + candidate - 1, src + i, kMinMatch) != 0) {
+            ++i;
+            continue;
+        }
+        size_t match = candidate - 1;
+        size_t length = kMinMatch;
+        while (i + length < n && src[match + length] == src[i + length]) ++length;
+        emitSequence(out, src + anchor, i - anchor, i - match, length);
+        i += length;
+        anchor = i;
+    }
+    // The last sequence is literals only; the decoder stops once it has rawSize bytes.
+    if (anchor < n) emitSequence(out, src + anchor, n - anchor, 0, 0);
+}
+
+bool BlockCodec::decompress(const char* data, size_t size, size_t rawSize, std::string& out) {
+    out.resize(rawSize);
+    char* dst = out.data();
+    size_t at = 0;
+    Reader in(data, size);
+    while (at < rawSize) {
+        unsigned char token = in.byte();
+        size_t literals = getLength(in, token >> 4);
+        if (!in.ok || literals > static_cast<size_t>(in.end - in.pos) || literals > rawSize - at) return false;
+        std::memcpy(dst + at, in.pos, literals);
+        in.pos += literals;
+        at += literals;
+        if (at == rawSize) break;
+
+        size_t offset = in.byte();
+        offset |= static_cast<size_t>(in.byte()) << 8;
+        size_t length = getLength(in, token & 15) + kMinMatch;
+        if (!in.ok || offset == 0 || offset > at || length > rawSize - at) return false;
+        if (offset >= length) {
+            std::memcpy(dst + at, dst + at - offset, length);
+        } else {
+            // The match overlaps the bytes it produces (a run): copy byte by byte.
+            for (size_t k = 0; k < length; ++k) dst[at + k] = dst[at - offset + k];
+        }
+        at += length;
+    }
+    return in.ok && in.pos == in.end;
+}
+
+/** First 32 bytes of the file. */
+struct OrderArchive::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockCount;
+    uint64_t indexOffset;
+    uint64_t orderCount;
+};
+
+namespace {
+    const char kMagic[8] = {'O', 'R', 'D', 'A', 'R', 'C', 'H', '1'};
+    constexpr uint32_t kVersion = 1;
+    /** Column sections of an encoded block, in file order. */
+    enum Column { Ids, Customers, Flags, Stages, Estimates, Placed, Times, ItemCounts, ItemIds, ItemNames, ItemQuantities, ColumnCount };
+}
+
+OrderArchive::~OrderArchive() {
+    close();
+}
+
+bool OrderArchive::open(const std::string& path, std::string* error) {
+    static_assert(sizeof(Header) == 32, "archive header is 32 bytes");
+    static_assert(sizeof(ArchiveBlockInfo) == 64, "archive index entries are 64 bytes");
+    close();
+    errno = 0;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return fail(error, "cannot open " + path);
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return fail(error, "cannot stat " + path);
+    }
+    Header header{};
+    if (st.st_size == 0) {
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.indexOffset = sizeof(Header);
+        if (!writeAt(fd, &header, sizeof(header), 0) || fsync(fd) != 0) {
+            ::close(fd);
+            return fail(error, "cannot initialize " + path);
+        }
+        fileBytes_ = sizeof(Header);
+    } else {
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        bool valid = size >= sizeof(Header) && readAt(fd, &header, sizeof(header), 0)
+                  && std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion
+                  && header.indexOffset <= size && (size - header.indexOffset) / sizeof(ArchiveBlockInfo) >= header.blockCount;
+        if (valid) {
+            blocks_.resize(header.blockCount);
+            valid = blocks_.empty() || readAt(fd, blocks_.data(), blocks_.size() * sizeof(ArchiveBlockInfo), header.indexOffset);
+        }
+        if (!valid) {
+            ::close(fd);
+            blocks_.clear();
+            errno = 0;
+            return fail(error, path + " is not an order archive");
+        }
+        fileBytes_ = size;
+    }
+    fd_ = fd;
+    orderCount_ = header.orderCount;
+    // Oldest blocks first, so an order archived twice keeps its latest name.
+    forEach([this](const Order& o) { customers_.add(o.id, o.customerName); });
+    return true;
+}
+
+void OrderArchive::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    blocks_.clear();
+    orderCount_ = 0;
+    fileBytes_ = 0;
+    customers_.clear();
+}
+
+void OrderArchive::encodeBlock(const Order* orders, size_t count, std::string& out, ArchiveBlockInfo& info) {
+    std::string columns[ColumnCount];
+    std::unordered_map<std::string, uint64_t> dictionary;
+    std::vector<const std::string*> words;
+    auto wordOf = [&](const std::string& text) {
+        auto inserted = dictionary.emplace(text, words.size());
+        if (inserted.second) words.push_back(&inserted.first->first);
+        return inserted.first->second;
+    };
+
+    info.count = static_cast<uint32_t>(count);
+    info.minServed = INT64_MAX;
+    info.maxServed = INT64_MIN;
+    int64_t previousId = 0;
+    int64_t previousPlaced = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const Order& o = orders[i];
+        int64_t placed = TimeUtils::toSeconds(o.placedAt);
+        if (i == 0) {
+            info.minId = o.id;
+            info.minPlaced = info.maxPlaced = placed;
+        }
+        info.maxId = o.id;
+        info.minPlaced = std::min<int64_t>(info.minPlaced, placed);
+        info.maxPlaced = std::max<int64_t>(info.maxPlaced, placed);
+        if (o.status == OrderStatus::Served) {
+            int64_t served = TimeUtils::toSeconds(o.servedAt);
+            info.minServed = std::min(info.minServed, served);
+            info.maxServed = std::max(info.maxServed, served);
+        }
+
+        putVarint(columns[Ids], zigzag(o.id - previousId));
+        previousId = o.id;
+        putVarint(columns[Customers], wordOf(o.customerName));
+        columns[Flags].push_back(static_cast<char>((o.isVip ? 1 : 0) | (static_cast<unsigned>(o.status) << 1)));
+        putVarint(columns[Stages], zigzag(o.stage));
+        putVarint(columns[Estimates], zigzag(o.estimatedPrepMinutes));
+        putVarint(columns[Placed], zigzag(placed - previousPlaced));
+        previousPlaced = placed;
+        // Offsets from placed time, + 1 so that 0 can mean "never happened".
+        for (const auto* tp : {&o.startedAt, &o.readyAt, &o.servedAt}) {
+            long long at = secondsOrZero(*tp);
+            putVarint(columns[Times], at ? zigzag(at - placed) + 1 : 0);
+        }
+        putVarint(columns[ItemCounts], o.items.size());
+        for (const OrderItem& item : o.items) {
+            putVarint(columns[ItemIds], zigzag(item.itemId));
+            putVarint(columns[ItemNames], wordOf(item.name));
+            putVarint(columns[ItemQuantities], zigzag(item.quantity));
+        }
+    }
+    if (info.minServed > info.maxServed) {
+        info.minServed = 1;
+        info.maxServed = 0;
+    }
+
+    out.clear();
+    putVarint(out, count);
+    putVarint(out, words.size());
+    for (const std::string* word : words) {
+        putVarint(out, word->size());
+        out += *word;
+    }
+    for (const std::string& column : columns) {
+        putVarint(out, column.size());
+        out += column;
+    }
+}
+
+bool OrderArchive::decodeBlock(const std::string& raw, std::vector<Order>& out, int onlyId) {
+    Reader in(raw.data(), raw.size());
+    uint64_t count = in.varint();
+    uint64_t wordCount = in.varint();
+    if (!in.ok || count > raw.size() || wordCount > raw.size()) return false;
+    // Views into raw: only the orders actually decoded copy their names.
+    std::vector<std::string_view> words(static_cast<size_t>(wordCount));
+    for (std::string_view& word : words) {
+        Reader text = in.section();
+        word = std::string_view(reinterpret_cast<const char*>(text.pos), static_cast<size_t>(text.end - text.pos));
+    }
+    Reader columns[ColumnCount];
+    for (Reader& column : columns) column = in.section();
+    if (!in.ok) return false;
+    auto word = [&](Reader& column) {
+        uint64_t index = column.varint();
+        if (index < words.size()) return words[static_cast<size_t>(index)];
+        column.ok = false;
+        return std::string_view();
+    };
+
+    out.reserve(out.size() + (onlyId ? 1 : static_cast<size_t>(count)));
+    int64_t id = 0;
+    int64_t placed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        id += columns[Ids].signedVarint();
+        placed += columns[Placed].signedVarint();
+        if (onlyId && id != onlyId) {
+            // Every column still advances past this order.
+            word(columns[Customers]);
+            columns[Flags].byte();
+            columns[Stages].varint();
+            columns[Estimates].varint();
+            for (int t = 0; t < 3; ++t) columns[Times].varint();
+            uint64_t items = columns[ItemCounts].varint();
+            if (items > raw.size()) return false;
+            for (uint64_t k = 0; k < items; ++k) {
+                columns[ItemIds].varint();
+                word(columns[ItemNames]);
+                columns[ItemQuantities].varint();
+            }
+            continue;
+        }
+        Order& o = out.emplace_back();
+        o.id = static_cast<int>(id);
+        o.customerName = word(columns[Customers]);
+        unsigned flags = columns[Flags].byte();
+        o.isVip = (flags & 1) != 0;
+        o.status = static_cast<OrderStatus>(std::min<unsigned>((flags >> 1) & 7, static_cast<unsigned>(OrderStatus::Cancelled)));
+        o.stage = static_cast<int>(columns[Stages].signedVarint());
+        o.estimatedPrepMinutes = static_cast<int>(columns[Estimates].signedVarint());
+        o.placedAt = TimeUtils::fromSeconds(placed);
+        for (auto* tp : {&o.startedAt, &o.readyAt, &o.servedAt}) {
+            uint64_t code = columns[Times].varint();
+            if (code) *tp = TimeUtils::fromSeconds(placed + unzigzag(code - 1));
+        }
+        uint64_t items = columns[ItemCounts].varint();
+        if (items > raw.size()) return false;
+        o.items.resize(static_cast<size_t>(items));
+        for (OrderItem& item : o.items) {
+            item.itemId = static_cast<int>(columns[ItemIds].signedVarint());
+            item.name = word(columns[ItemNames]);
+            item.quantity = static_cast<int>(columns[ItemQuantities].signedVarint());
+        }
+    }
+    for (const Reader& column : columns) {
+        if (!column.ok || column.pos != column.end) return false;
+    }
+    return true;
+}
+
+bool OrderArchive::append(std::vector<Order>& orders, std::string* error) {
+    if (fd_ < 0) return fail(error, "archive is not open");
+    if (orders.empty()) return true;
+    std::sort(orders.begin(), orders.end(), [](const Order& a, const Order& b) { return a.id < b.id; });
+
+    size_t oldBlocks = blocks_.size();
+    uint64_t end = fileBytes_;
+    std::string raw;
+    std::string packed;
+    errno = 0;
+    for (size_t begin = 0; begin < orders.size(); begin += kBlockOrders) {
+        size_t count = std::min(kBlockOrders, orders.size() - begin);
+        ArchiveBlockInfo info;
+        encodeBlock(orders.data() + begin, count, raw, info);
+        BlockCodec::compress(raw, packed);
+        info.offset = end;
+        info.size = static_cast<uint32_t>(packed.size());
+        info.rawSize = static_cast<uint32_t>(raw.size());
+        info.checksum = fnv1a(packed.data(), packed.size());
+        if (!writeAt(fd_, packed.data(), packed.size(), end)) {
+            blocks_.resize(oldBlocks);
+            return fail(error, "cannot write archive block");
+        }
+        end += packed.size();
+        blocks_.push_back(info);
+    }
+
+    // New index after the blocks, made durable before the header points at it.
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.blockCount = static_cast<uint32_t>(blocks_.size());
+    header.indexOffset = end;
+    header.orderCount = orderCount_ + orders.size();
+    size_t indexBytes = blocks_.size() * sizeof(ArchiveBlockInfo);
+    if (!writeAt(fd_, blocks_.data(), indexBytes, end) || fsync(fd_) != 0
+        || !writeAt(fd_, &header, sizeof(header), 0) || fsync(fd_) != 0) {
+        blocks_.resize(oldBlocks);
+        return fail(error, "cannot write archive index");
+    }
+    orderCount_ = header.orderCount;
+    fileBytes_ = end + indexBytes;
+    for (const Order& o : orders) customers_.add(o.id, o.customerName);
+    return true;
+}
+
+bool OrderArchive::readBlock(size_t i, std::vector<Order>& out, int onlyId) const {
+    const ArchiveBlockInfo& info = blocks_[i];
+    std::string packed(info.size, '\0');
+    std::string raw;
+    if (!readAt(fd_, packed.data(), packed.size(), info.offset) || fnv1a(packed.data(), packed.size()) != info.checksum) return false;
+    return BlockCodec::decompress(packed.data(), packed.size(), info.rawSize, raw) && decodeBlock(raw, out, onlyId);
+}
+
+bool OrderArchive::find(int id, Order& out) const {
+    std::vector<Order> orders;
+    // Newest blocks first: an order archived twice (after a crash before the next save) is
+    // found in its latest form.
+    for (size_t i = blocks_.size(); i-- > 0;) {
+        if (id < blocks_[i].minId || id > blocks_[i].maxId) continue;
+        orders.clear();
+        if (readBlock(i, orders, id) && !orders.empty()) {
+            out = std::move(orders.front());
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t OrderArchive::forEachInRange(long long from, long long to, bool byServed, const std::function<void(const Order&)>& fn) const {
+    auto inRange = [from, to](long long value) { return (from == 0 || value >= from) && (to == 0 || value < to); };
+    size_t read = 0;
+    std::vector<Order> orders;
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+        const ArchiveBlockInfo& info = blocks_[i];
+        long long low = byServed ? info.minServed : info.minPlaced;
+        long long high = byServed ? info.maxServed : info.maxPlaced;
+        if (low > high || (to != 0 && low >= to) || (from != 0 && high < from)) continue;
+        orders.clear();
+        if (!readBlock(i, orders)) continue;
+        ++read;
+        for (const Order& o : orders) {
+            if (byServed ? o.status == OrderStatus::Served && inRange(TimeUtils::toSeconds(o.servedAt)) : inRange(TimeUtils::toSeconds(o.placedAt))) {
+                fn(o);
+            }
+        }
+    }
+    return read;
+}
+
+void OrderArchive::forEach(const std::function<void(const Order&)>& fn) const {
+    forEachInRange(0, 0, false, fn);
+}
+
+std::vector<Order> OrderArchive::findByCustomer(const std::string& prefix, size_t limit, bool allowFuzzy, bool* fuzzy) const {
+    std::vector<int> ids = customers_.prefix(prefix, limit);
+    bool usedFuzzy = ids.empty() && allowFuzzy;
+    if (usedFuzzy) {
+        ids = customers_.fuzzy(prefix, limit == 0 ? 20 : limit);
+    }
+    if (fuzzy) *fuzzy = usedFuzzy;
+    // Each block that can hold a wanted id is decoded once, newest first as in find.
+    std::vector<std::pair<int, size_t>> wanted;
+    wanted.reserve(ids.size());
+    for (size_t rank = 0; rank < ids.size(); ++rank) wanted.emplace_back(ids[rank], rank);
+    std::sort(wanted.begin(), wanted.end());
+    std::vector<Order> found(ids.size());
+    std::vector<bool> have(ids.size(), false);
+    std::vector<Order> orders;
+    size_t remaining = ids.size();
+    for (size_t i = blocks_.size(); i-- > 0 && remaining > 0;) {
+        auto first = std::lower_bound(wanted.begin(), wanted.end(), std::make_pair(blocks_[i].minId, size_t{0}));
+        if (first == wanted.end() || first->first > blocks_[i].maxId) continue;
+        orders.clear();
+        if (!readBlock(i, orders)) continue;
+        for (Order& o : orders) {
+            auto it = std::lower_bound(wanted.begin(), wanted.end(), std::make_pair(o.id, size_t{0}));
+            if (it == wanted.end() || it->first != o.id || have[it->second]) continue;
+            found[it->second] = std::move(o);
+            have[it->second] = true;
+            --remaining;
+        }
+    }
+    std::vector<Order> result;
+    result.reserve(ids.size() - remaining);
+    for (size_t at = 0; at < ids.size(); ++at) {
+        if (have[at]) result.push_back(std::move(found[at]));
+    }
+    return result;
+}
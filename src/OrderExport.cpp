@@ -0,0 +1,424 @@
+#include "OrderExport.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include "OrderArchive.h"
+#include "Sorts.h"
+#include "TableRenderer.h"
+
+namespace {
+    const char kColumnarMagic[8] = {'O', 'R', 'D', 'C', 'O', 'L', '0', '1'};
+    const char kCsvHeader[] = "id,customer,vip,status,stage,estimate_minutes,placed_at,started_at,ready_at,served_at,items,archived\n";
+
+    /** Rows waiting to be encoded: live orders by pointer into the snapshot, archived ones copied. */
+    struct Chunk {
+        std::vector<const Order*> rows;
+        std::vector<uint8_t> archived;
+        /** Archived copies; reserved to chunkRows up front so rows can point into it. */
+        std::vector<Order> owned;
+        std::string encoded;
+    };
+
+    template <typename T>
+    void appendRaw(std::string& out, T value) {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    template <typename T>
+    T readRaw(const char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    void appendNumber(std::string& out, long long value) {
+        char buf[24];
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, static_cast<size_t>(result.ptr - buf));
+    }
+
+    long long secondsOrZero(const std::chrono::system_clock::time_point& tp) {
+        return tp == std::chrono::system_clock::time_point{} ? 0 : TimeUtils::toSeconds(tp);
+    }
+
+    /** Stage name as of the snapshot; standard stages share OrderStatus numbering. */
+    const std::string& stageLabel(const OrderSnapshot& snapshot, const Order& o, std::string& scratch) {
+        int stage = o.stage >= 0 ? o.stage : static_cast<int>(o.status);
+        if (static_cast<size_t>(stage) < snapshot.stageCount()) return snapshot.stageName(stage);
+        scratch = OrderStatusStrings::toString(o.status);
+        return scratch;
+    }
+
+    /** Appends text as a CSV field, quoted only when it holds a comma, quote or line break. */
+    void appendCsvField(std::string& out, const std::string& text) {
+        if (text.find_first_of(",\"\r\n") == std::string::npos) {
+            out += text;
+            return;
+        }
+        out.push_back('"');
+        for (char c : text) {
+            if (c == '"') out.push_back('"');
+            out.push_back(c);
+        }
+        out.push_back('"');
+    }
+
+    void appendCsvTime(std::string& out, const std::chrono::system_clock::time_point& tp) {
+        long long seconds = secondsOrZero(tp);
+        if (!seconds) return;
+        char buf[TimeFormat::kIsoWidth];
+        TimeFormat::isoUtc(seconds, buf);
+        out.append(buf, sizeof(buf));
+    }
+
+    void encodeCsv(const OrderSnapshot& snapshot, Chunk& chunk) {
+        std::string& out = chunk.encoded;
+        std::string scratch;
+        std::string items;
+        for (size_t i = 0; i < chunk.rows.size(); ++i) {
+            const Order& o = *chunk.rows[i];
+            appendNumber(out, o.id);
+            out.push_back(',');
+            appendCsvField(out, o.customerName);
+            out += o.isVip ? ",true," : ",false,";
+            out += OrderStatusStrings::toString(o.status);
+            out.push_back(',');
+            appendCsvField(out, stageLabel(snapshot, o, scratch));
+            out.push_back(',');
+            appendNumber(out, o.estimatedPrepMinutes);
+            for (const auto* tp : {&o.placedAt, &o.startedAt, &o.readyAt, &o.servedAt}) {
+                out.push_back(',');
+                appendCsvTime(out, *tp);
+            }
+            out.push_back(',');
+            items.clear();
+            for (const OrderItem& item : o.items) {
+                if (!items.empty()) items += "; ";
+                appendNumber(items, item.quantity);
+                items += "x ";
+                items += item.name;
+            }
+            appendCsvField(out, items);
+            out += chunk.archived[i] ? ",true\n" : ",false\n";
+        }
+    }
+
+    /** String column: rows + 1 offsets, then the bytes. */
+    template <typename Each>
+    void appendStrings(std::string& out, size_t count, Each each) {
+        size_t lengths = out.size();
+        out.resize(out.size() + (count + 1) * sizeof(uint32_t));
+        std::string bytes;
+        uint32_t offset = 0;
+        size_t i = 0;
+        each([&](const std::string& text) {
+            std::memcpy(&out[lengths + i++ * sizeof(uint32_t)], &offset, sizeof(offset));
+            bytes += text;
+            offset += static_cast<uint32_t>(text.size());
+        });
+        std::memcpy(&out[lengths + i * sizeof(uint32_t)], &offset, sizeof(offset));
+        out += bytes;
+    }
+
+    void encodeColumnar(const OrderSnapshot& snapshot, Chunk& chunk) {
+        std::string& out = chunk.encoded;
+        const auto& rows = chunk.rows;
+        appendRaw<uint32_t>(out, static_cast<uint32_t>(rows.size()));
+        std::string scratch;
+        size_t itemCount = 0;
+        for (const Order* o : rows) itemCount += o->items.size();
+        auto eachItem = [&rows](auto fn) {
+            for (const Order* o : rows) {
+                for (const OrderItem& item : o->items) fn(item);
+            }
+        };
+        for (int column = 0; column < OrderExport::ColumnarColumnCount; ++column) {
+            size_t lengthAt = out.size();
+            appendRaw<uint32_t>(out, 0);
+            switch (column) {
+                case OrderExport::ColId:
+                    for (const Order* o : rows) appendRaw<int32_t>(out, o->id);
+                    break;
+                case OrderExport::ColCustomer:
+                    appendStrings(out, rows.size(), [&](auto put) { for (const Order* o : rows) put(o->customerName); });
+                    break;
+                case OrderExport::ColVip:
+                    for (const Order* o : rows) out.push_back(o->isVip ? 1 : 0);
+                    break;
+                case OrderExport::ColStatus:
+                    for (const Order* o : rows) out.push_back(static_cast<char>(o->status));
+                    break;
+                case OrderExport::ColStage:
+                    appendStrings(out, rows.size(), [&](auto put) { for (const Order* o : rows) put(stageLabel(snapshot, *o, scratch)); });
+                    break;
+                case OrderExport::ColEstimate:
+                    for (const Order* o : rows) appendRaw<int32_t>(out, o->estimatedPrepMinutes);
+                    break;
+                case OrderExport::ColPlaced:
+                    for (const Order* o : rows) appendRaw<int64_t>(out, secondsOrZero(o->placedAt));
+                    break;
+                case OrderExport::ColStarted:
+                    for (const Order* o : rows) appendRaw<int64_t>(out, secondsOrZero(o->startedAt));
+                    break;
+                case OrderExport::ColReady:
+                    for (const Order* o : rows) appendRaw<int64_t>(out, secondsOrZero(o->readyAt));
+                    break;
+                case OrderExport::ColServed:
+                    for (const Order* o : rows) appendRaw<int64_t>(out, secondsOrZero(o->servedAt));
+                    break;
+                case OrderExport::ColItemCount:
+                    for (const Order* o : rows) appendRaw<uint32_t>(out, static_cast<uint32_t>(o->items.size()));
+                    break;
+                case OrderExport::ColItemId:
+                    eachItem([&](const OrderItem& item) { appendRaw<int32_t>(out, item.itemId); });
+                    break;
+                case OrderExport::ColItemName:
+                    appendStrings(out, itemCount, [&](auto put) { eachItem([&](const OrderItem& item) { put(item.name); }); });
+                    break;
+                case OrderExport::ColItemQuantity:
+                    eachItem([&](const OrderItem& item) { appendRaw<int32_t>(out, item.quantity); });
+                    break;
+                case OrderExport::ColArchived:
+                    out.append(reinterpret_cast<const char*>(chunk.archived.data()), chunk.archived.size());
+                    break;
+            }
+            uint32_t length = static_cast<uint32_t>(out.size() - lengthAt - sizeof(uint32_t));
+            std::memcpy(&out[lengthAt], &length, sizeof(length));
+        }
+    }
+
+    /** Fills chunks, encodes them a batch at a time and writes them in order. */
+    class ChunkWriter {
+    public:
+        ChunkWriter(const OrderSnapshot& snapshot, const OrderExport::Options& options, std::ofstream& out, OrderExport::Stats& stats)
+            : snapshot_(snapshot), options_(options), out_(out), stats_(stats) {
+            options_.chunkRows = std::max<size_t>(1, options_.chunkRows);
+            if (options_.threads == 0) options_.threads = std::max(1u, std::thread::hardware_concurrency());
+            batch_.resize(options_.threads);
+            for (Chunk& chunk : batch_) {
+                chunk.rows.reserve(options_.chunkRows);
+                chunk.archived.reserve(options_.chunkRows);
+            }
+            if (options_.format == OrderExport::Format::Csv) {
+                put(kCsvHeader, sizeof(kCsvHeader) - 1);
+            } else {
+                put(kColumnarMagic, sizeof(kColumnarMagic));
+            }
+        }
+
+        void add(const Order& order, bool archived) {
+            Chunk& chunk = batch_[filling_];
+            if (archived) {
+                if (chunk.owned.capacity() < options_.chunkRows) chunk.owned.reserve(options_.chunkRows);
+                chunk.owned.push_back(order);
+                chunk.rows.push_back(&chunk.owned.back());
+                ++stats_.archivedRows;
+            } else {
+                chunk.rows.push_back(&order);
+            }
+            chunk.archived.push_back(archived ? 1 : 0);
+            ++stats_.rows;
+            if (chunk.rows.size() == options_.chunkRows && ++filling_ == batch_.size()) flush();
+        }
+
+        /** Writes what is left and, for columnar files, the footer. */
+        bool finish() {
+            flush();
+            if (options_.format == OrderExport::Format::Columnar) {
+                std::string footer;
+                for (const auto& group : groups_) {
+                    appendRaw<uint64_t>(footer, group.first);
+                    appendRaw<uint32_t>(footer, group.second);
+                }
+                appendRaw<uint32_t>(footer, static_cast<uint32_t>(groups_.size()));
+                appendRaw<uint64_t>(footer, stats_.rows);
+                appendRaw<uint32_t>(footer, static_cast<uint32_t>(footer.size()));
+                footer.append(kColumnarMagic, sizeof(kColumnarMagic));
+                put(footer.data(), footer.size());
+            }
+            out_.flush();
+            return static_cast<bool>(out_);
+        }
+
+    private:
+        const OrderSnapshot& snapshot_;
+        OrderExport::Options options_;
+        std::ofstream& out_;
+        OrderExport::Stats& stats_;
+        std::vector<Chunk> batch_;
+        size_t filling_{0};
+        uint64_t written_{0};
+        /** Columnar row groups: (offset, rows). */
+        std::vector<std::pair<uint64_t, uint32_t>> groups_;
+
+        void put(const char* data, size_t size) {
+            out_.write(data, static_cast<std::streamsize>(size));
+            written_ += size;
+            stats_.bytes += size;
+        }
+
+        void flush() {
+            std::vector<std::function<void()>> tasks;
+            for (Chunk& chunk : batch_) {
+                if (chunk.rows.empty()) break;
+                tasks.emplace_back([this, &chunk] {
+                    chunk.encoded.clear();
+                    if (options_.format == OrderExport::Format::Csv) {
+                        encodeCsv(snapshot_, chunk);
+                    } else {
+                        encodeColumnar(snapshot_, chunk);
+                    }
+                });
+            }
+            Sorts::detail::runTasks(tasks, options_.threads);
+            uint64_t held = 0;
+            for (size_t i = 0; i < tasks.size(); ++i) {
+                Chunk& chunk = batch_[i];
+                held += chunk.encoded.size();
+                if (options_.format == OrderExport::Format::Columnar) {
+                    groups_.emplace_back(written_, static_cast<uint32_t>(chunk.rows.size()));
+                }
+                put(chunk.encoded.data(), chunk.encoded.size());
+                ++stats_.chunks;
+                chunk.rows.clear();
+                chunk.archived.clear();
+                chunk.owned.clear();
+            }
+            stats_.peakBufferBytes = std::max(stats_.peakBufferBytes, held);
+            filling_ = 0;
+        }
+    };
+
+    bool fail(std::string* error, const std::string& what) {
+        if (error) *error = what;
+        return false;
+    }
+}
+
+bool OrderExport::write(const OrderSnapshot& snapshot, const OrderArchive* archive, const std::string& path, const Options& options,
+                        Stats* stats, std::string* error) {
+    Stats local;
+    Stats& counts = stats ? *stats : local;
+    counts = Stats{};
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) return fail(error, "cannot open " + tmp);
+        ChunkWriter writer(snapshot, options, out, counts);
+        if (archive) archive->forEach([&](const Order& o) { writer.add(o, true); });
+        snapshot.forEach([&](const Order& o) { writer.add(o, false); });
+        if (!writer.finish()) return fail(error, "cannot write " + tmp);
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    return !ec || fail(error, "cannot replace " + path + ": " + ec.message());
+}
+
+bool OrderExport::readColumnar(const std::string& path, const std::function<void(const ColumnarRow&)>& fn, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return fail(error, "cannot open " + path);
+    in.seekg(0, std::ios::end);
+    uint64_t size = static_cast<uint64_t>(in.tellg());
+    const uint64_t tail = sizeof(uint32_t) + sizeof(kColumnarMagic);
+    char magic[sizeof(kColumnarMagic)];
+    char tailBytes[tail];
+    if (size < sizeof(kColumnarMagic) + tail || !in.seekg(0).read(magic, sizeof(magic))
+        || std::memcmp(magic, kColumnarMagic, sizeof(magic)) != 0
+        || !in.seekg(static_cast<std::streamoff>(size - tail)).read(tailBytes, tail)
+        || std::memcmp(tailBytes + sizeof(uint32_t), kColumnarMagic, sizeof(kColumnarMagic)) != 0) {
+        return fail(error, path + " is not a columnar export");
+    }
+    uint32_t footerSize = readRaw<uint32_t>(tailBytes);
+    if (footerSize < 12 || footerSize > size - tail - sizeof(kColumnarMagic)) return fail(error, path + ": bad footer");
+    std::string footer(footerSize, '\0');
+    in.seekg(static_cast<std::streamoff>(size - tail - footerSize)).read(footer.data(), footerSize);
+    uint32_t groupCount = readRaw<uint32_t>(footer.data() + footerSize - 12);
+    const size_t entry = sizeof(uint64_t) + sizeof(uint32_t);
+    if (!in || static_cast<uint64_t>(groupCount) * entry + 12 != footerSize) return fail(error, path + ": bad footer");
+
+    std::vector<uint64_t> starts;
+    for (uint32_t g = 0; g < groupCount; ++g) starts.push_back(readRaw<uint64_t>(footer.data() + g * entry));
+    starts.push_back(size - tail - footerSize);
+    std::string group;
+    ColumnarRow row;
+    for (uint32_t g = 0; g < groupCount; ++g) {
+        if (starts[g + 1] < starts[g] + sizeof(uint32_t) || starts[g + 1] > size) return fail(error, path + ": bad row group");
+        group.resize(static_cast<size_t>(starts[g + 1] - starts[g]));
+        if (!in.seekg(static_cast<std::streamoff>(starts[g])).read(group.data(), static_cast<std::streamsize>(group.size()))) {
+            return fail(error, path + ": short read");
+        }
+        // Column views, each checked against the size its row or item count implies.
+        const char* columns[ColumnarColumnCount];
+        size_t lengths[ColumnarColumnCount];
+        size_t pos = sizeof(uint32_t);
+        for (int c = 0; c < ColumnarColumnCount; ++c) {
+            if (pos + sizeof(uint32_t) > group.size()) return fail(error, path + ": bad row group");
+            lengths[c] = readRaw<uint32_t>(group.data() + pos);
+            pos += sizeof(uint32_t);
+            if (lengths[c] > group.size() - pos) return fail(error, path + ": bad row group");
+            columns[c] = group.data() + pos;
+            pos += lengths[c];
+        }
+        size_t rows = readRaw<uint32_t>(group.data());
+        bool valid = lengths[ColId] == rows * 4 && lengths[ColVip] == rows && lengths[ColStatus] == rows && lengths[ColEstimate] == rows * 4
+                  && lengths[ColPlaced] == rows * 8 && lengths[ColStarted] == rows * 8 && lengths[ColReady] == rows * 8
+                  && lengths[ColServed] == rows * 8 && lengths[ColItemCount] == rows * 4 && lengths[ColArchived] == rows;
+        size_t items = 0;
+        for (size_t r = 0; valid && r < rows; ++r) {
+            items += readRaw<uint32_t>(columns[ColItemCount] + r * sizeof(uint32_t));
+            valid = static_cast<unsigned char>(columns[ColStatus][r]) <= static_cast<unsigned>(OrderStatus::Cancelled);
+        }
+        valid = valid && lengths[ColItemId] == items * 4 && lengths[ColItemQuantity] == items * 4;
+        // String columns: offsets must rise and stay inside the column.
+        for (int c : {ColCustomer, ColStage, ColItemName}) {
+            size_t count = c == ColItemName ? items : rows;
+            valid = valid && lengths[c] >= (count + 1) * sizeof(uint32_t);
+            for (size_t i = 0; valid && i < count; ++i) {
+                uint32_t from = readRaw<uint32_t>(columns[c] + i * sizeof(uint32_t));
+                uint32_t to = readRaw<uint32_t>(columns[c] + (i + 1) * sizeof(uint32_t));
+                valid = from <= to && to <= lengths[c] - (count + 1) * sizeof(uint32_t);
+            }
+        }
+        if (!valid) return fail(error, path + ": bad row group");
+        auto text = [](const char* column, size_t count, size_t i) {
+            uint32_t from = readRaw<uint32_t>(column + i * sizeof(uint32_t));
+            uint32_t to = readRaw<uint32_t>(column + (i + 1) * sizeof(uint32_t));
+            return std::string(column + (count + 1) * sizeof(uint32_t) + from, to - from);
+        };
+        size_t item = 0;
+        for (size_t r = 0; r < rows; ++r) {
+            Order& o = row.order;
+            o.id = readRaw<int32_t>(columns[ColId] + r * sizeof(int32_t));
+            o.customerName = text(columns[ColCustomer], rows, r);
+            o.isVip = columns[ColVip][r] != 0;
+            o.status = static_cast<OrderStatus>(columns[ColStatus][r]);
+            row.stage = text(columns[ColStage], rows, r);
+            o.estimatedPrepMinutes = readRaw<int32_t>(columns[ColEstimate] + r * sizeof(int32_t));
+            auto time = [&](int column) {
+                int64_t seconds = readRaw<int64_t>(columns[column] + r * sizeof(int64_t));
+                return seconds ? TimeUtils::fromSeconds(seconds) : std::chrono::system_clock::time_point{};
+            };
+            o.placedAt = time(ColPlaced);
+            o.startedAt = time(ColStarted);
+            o.readyAt = time(ColReady);
+            o.servedAt = time(ColServed);
+            o.items.resize(readRaw<uint32_t>(columns[ColItemCount] + r * sizeof(uint32_t)));
+            for (OrderItem& it : o.items) {
+                it.itemId = readRaw<int32_t>(columns[ColItemId] + item * sizeof(int32_t));
+                it.name = text(columns[ColItemName], items, item);
+                it.quantity = readRaw<int32_t>(columns[ColItemQuantity] + item * sizeof(int32_t));
+                ++item;
+            }
+            row.archived = columns[ColArchived][r] != 0;
+            fn(row);
+        }
+    }
+    return true;
+}
@@ -1,164 +1,789 @@
 #include "OrderManager.h"
+#include "Replication.h"
+#include "Sorts.h"
+#include "TicketJournal.h"
 #include <chrono>
+#include <limits>
+#include <utility>
 
-OrderManager::OrderManager() : normalQueue_(256) {}
+namespace {
+// Lifecycle timestamps are stamped by workflow hooks when an order's base status changes,
+// so custom stages (e.g. EXPO counted as READY) keep the original timestamps.
+void stampStarted(void* manager, Order& order, int, int) { order.startedAt = static_cast<OrderManager*>(manager)->now(); }
+void stampReady(void* manager, Order& order, int from, int) {
+    auto* self = static_cast<OrderManager*>(manager);
+    order.readyAt = self->now();
+    // The prep counter is updated after the hooks run, so it still includes this order.
+    int others = self->kitchenLoad() - (self->workflow().baseStatus(from) == OrderStatus::Prepping ? 1 : 0);
+    self->recordPrepTime(order, others);
+}
+void stampServed(void* manager, Order& order, int, int) {
+    auto* self = static_cast<OrderManager*>(manager);
+    order.servedAt = self->now();
+    self->indexServed(order);
+}
+
+/**
+ * Filtering, ordering and paging shared by the live and the snapshot listings: rows sort by the
+ * query's time column, then id, and only the page is copied out at the end.
+ */
+class PageSelector {
+public:
+    PageSelector(const ListQuery& query, const Order* cursor) : query_(query) {
+        if (cursor) cursor_ = keyOf(*cursor);
+    }
+
+    /** Adds o if it matches, for sources already in output order; false once the page is full. */
+    bool append(const Order& o) {
+        Row row;
+        if (!accept(o, row)) return true;
+        if (query_.limit > 0 && rows_.size() == query_.limit) {
+            more_ = true;
+            return false;
+        }
+        rows_.push_back(row);
+        return true;
+    }
+
+    /** Selects the page from an unordered source; forEach(fn) calls fn(const Order&) per order. */
+    template <typename ForEach>
+    void scan(ForEach forEach) {
+        auto before = [this](const Row& a, const Row& b) { return this->before(a, b); };
+        if (query_.limit > 0) {
+            // Keep one extra row to learn whether another page follows.
+            TopK<Row, decltype(before)> top(query_.limit + 1, before);
+            forEach([&](const Order& o) {
+                Row row;
+                if (accept(o, row)) top.offer(row);
+            });
+            rows_ = top.drainSorted();
+            if (rows_.size() > query_.limit) {
+                more_ = true;
+                rows_.pop_back();
+            }
+        } else {
+            forEach([&](const Order& o) {
+                Row row;
+                if (accept(o, row)) rows_.push_back(row);
+            });
+            Sorts::parallelMergeSort(rows_, before);
+        }
+    }
+
+    std::vector<Order> finish(int* nextAfterId) const {
+        if (nextAfterId) {
+            *nextAfterId = (more_ && !rows_.empty()) ? rows_.back().id : 0;
+        }
+        std::vector<Order> out;
+        out.reserve(rows_.size());
+        for (const Row& row : rows_) {
+            out.push_back(*row.order);
+        }
+        return out;
+    }
+
+private:
+    struct Row {
+        long long seconds{0};
+        int id{0};
+        const Order* order{nullptr};
+    };
+
+    const ListQuery& query_;
+    Row cursor_{};
+    std::vector<Row> rows_;
+    bool more_{false};
+
+    bool before(const Row& a, const Row& b) const {
+        if (a.seconds != b.seconds) {
+            return query_.newestFirst ? a.seconds > b.seconds : a.seconds < b.seconds;
+        }
+        return query_.newestFirst ? a.id > b.id : a.id < b.id;
+    }
+    Row keyOf(const Order& o) const {
+        return Row{TimeUtils::toSeconds(query_.byServed ? o.servedAt : o.placedAt), o.id, &o};
+    }
+    bool accept(const Order& o, Row& row) const {
+        if (query_.statusMask != 0 && (query_.statusMask & ListQuery::maskOf(o.status)) == 0) {
+            return false;
+        }
+        row = keyOf(o);
+        if (query_.since != 0 && row.seconds < query_.since) return false;
+        if (query_.until != 0 && row.seconds >= query_.until) return false;
+        return query_.afterId == 0 || before(cursor_, row);
+    }
+};
+}
+
+OrderManager::OrderManager() : normalQueue_(256) {
+    registerBuiltinHooks();
+}
+
+void OrderManager::registerBuiltinHooks() {
+    workflow_.addStatusEntryHook(OrderStatus::Prepping, stampStarted, this);
+    workflow_.addStatusEntryHook(OrderStatus::Ready, stampReady, this);
+    workflow_.addStatusEntryHook(OrderStatus::Served, stampServed, this);
+}
+
+bool OrderManager::loadWorkflow(const std::string& path, std::string& error) {
+    if (!workflow_.loadConfig(path, error)) return false;
+    registerBuiltinHooks();
+    return true;
+}
+
+int OrderManager::createOrder(const std::string& customerName, bool isVip, const std::vector<OrderItem>& items, int estimatedPrepMinutes) {
+    return createOrder(std::string(customerName), isVip, std::vector<OrderItem>(items), estimatedPrepMinutes);
+}
 
-OrderNode* OrderManager::createOrder(const std::string& customerName, bool isVip, const std::vector<OrderItem>& items, int estimatedPrepMinutes) {
-    Order order;
+int OrderManager::createOrder(std::string&& customerName, bool isVip, std::vector<OrderItem>&& items, int estimatedPrepMinutes) {
+    return placeOrder(std::move(customerName), isVip, std::move(items), estimatedPrepMinutes, now(), nullptr)->id;
+}
+
+Order* OrderManager::placeOrder(std::string&& customerName, bool isVip, std::vector<OrderItem>&& items, int estimatedPrepMinutes,
+                                std::chrono::system_clock::time_point placedAt, std::vector<VipEntry>* deferredVips) {
+    // The order is built directly inside its registry slot; name and items are moved, never copied.
+    OrderHandle handle = active_.insert(Order{});
+    Order& order = *active_.get(handle);
     order.id = nextId_++;
-    order.customerName = customerName;
+    order.customerName = std::move(customerName);
     order.isVip = isVip;
-    order.items = items;
+    order.items = std::move(items);
     order.estimatedPrepMinutes = estimatedPrepMinutes;
-    order.placedAt = std::chrono::system_clock::now();
+    order.placedAt = placedAt;
     order.status = OrderStatus::Placed;
+    indexOrder(order, handle);
+    markChanged(order.id);
+    publish(OrderEventType::Created, order.id, static_cast<int>(OrderStatus::Placed), static_cast<int>(OrderStatus::Placed));
 
-    OrderNode* node = active_.pushBack(order);
     // Move to queued state and enqueue
-    transition(node->data, OrderStatus::Queued);
+    transition(order, OrderStatus::Queued);
     if (isVip) {
-        VipEntry e;
-        e.orderId = node->data.id;
-        e.placedAtSeconds = TimeUtils::toSeconds(node->data.placedAt);
-        vipHeap_.push(e);
+        VipEntry e{order.id, TimeUtils::toNanos(order.placedAt)};
+        if (deferredVips) {
+            deferredVips->push_back(e);
+        } else {
+            vipHeap_.push(e);
+        }
     } else {
-        normalQueue_.enqueue(node->data.id);
+        normalQueue_.enqueue(order.id);
     }
-    return node;
+    if (replication_) replication_->created(order);
+    return &order;
+}
+
+size_t OrderManager::createOrders(std::vector<NewOrder>&& batch) {
+    batchNow_ = clock_->now();
+    inBatch_ = true;
+    size_t vipCount = 0;
+    for (const auto& n : batch) {
+        if (n.isVip) ++vipCount;
+    }
+    normalQueue_.reserve(normalQueue_.size() + batch.size() - vipCount);
+    std::vector<VipEntry> vips;
+    vips.reserve(vipCount);
+
+    for (auto& n : batch) {
+        placeOrder(std::move(n.customerName), n.isVip, std::move(n.items), n.estimatedPrepMinutes, batchNow_, &vips);
+    }
+    vipHeap_.pushMany(vips);
+    inBatch_ = false;
+    size_t created = batch.size();
+    batch.clear();
+    return created;
+}
+
+size_t OrderManager::transitionMany(const std::vector<int>& ids, OrderStatus to) {
+    batchNow_ = clock_->now();
+    inBatch_ = true;
+    size_t moved = 0;
+    // One id lookup per entry rather than a registry scan. Once a repeated id has moved its
+    // status is already `to`, so later copies are skipped without a seen-set.
+    for (int id : ids) {
+        Order* o = findOrder(id);
+        if (o && o->status != to && changeStatus(*o, to)) {
+            ++moved;
+        }
+    }
+    inBatch_ = false;
+    return moved;
+}
+
+std::chrono::system_clock::time_point OrderManager::now() const {
+    return inBatch_ ? batchNow_ : clock_->now();
 }
 
 bool OrderManager::editOrder(int id, const std::string& customerName, bool isVip, const std::vector<OrderItem>& items, int estimatedPrepMinutes) {
-    OrderNode* node = active_.findById(id);
-    if (!node) return false;
-    Order& ord = node->data;
+    return editOrder(id, std::string(customerName), isVip, std::vector<OrderItem>(items), estimatedPrepMinutes);
+}
+
+bool OrderManager::editOrder(int id, std::string&& customerName, bool isVip, std::vector<OrderItem>&& items, int estimatedPrepMinutes) {
+    Order* found = findOrder(id);
+    if (!found) return false;
+    Order& ord = *found;
     if (ord.status == OrderStatus::Cancelled || ord.status == OrderStatus::Served) {
         return false;
     }
-    ord.customerName = customerName;
-    ord.items = items;
+    customers_.rename(ord.id, ord.customerName, customerName);
+    ord.customerName = std::move(customerName);
+    ord.items = std::move(items);
     ord.estimatedPrepMinutes = estimatedPrepMinutes;
+    markChanged(ord.id);
+    eta_.update(ord.id, isVip, estimatedPrepMinutes);
+    int stage = WorkflowEngine::stageOf(ord);
+    publish(OrderEventType::Edited, ord.id, stage, stage);
 
     if (ord.isVip != isVip) {
         ord.isVip = isVip;
         if (isVip) {
-            VipEntry e{ord.id, TimeUtils::toSeconds(ord.placedAt)};
+            VipEntry e{ord.id, TimeUtils::toNanos(ord.placedAt)};
             vipHeap_.push(e);
         } else {
             normalQueue_.enqueue(ord.id);
         }
+        if (journal_) journal_->record(ord, now());
     }
+    if (replication_) replication_->edited(ord);
     return true;
 }
 
 bool OrderManager::cancelOrder(int id) {
-    OrderNode* node = active_.findById(id);
-    if (!node) return false;
-    Order& ord = node->data;
-    if (!transition(ord, OrderStatus::Cancelled)) {
+    Order* found = findOrder(id);
+    if (!found) return false;
+    Order& ord = *found;
+    if (!changeStatus(ord, OrderStatus::Cancelled)) {
         return false;
     }
     return true;
 }
 
 bool OrderManager::startOrder(int id) {
-    OrderNode* node = active_.findById(id);
-    if (!node) return false;
-    Order& ord = node->data;
-    if (!transition(ord, OrderStatus::Prepping)) return false;
-    ord.startedAt = std::chrono::system_clock::now();
-    return true;
+    Order* found = findOrder(id);
+    if (!found) return false;
+    Order& ord = *found;
+    return changeStatus(ord, OrderStatus::Prepping);
 }
 
 bool OrderManager::readyOrder(int id) {
-    OrderNode* node = active_.findById(id);
-    if (!node) return false;
-    Order& ord = node->data;
-    if (!transition(ord, OrderStatus::Ready)) return false;
-    ord.readyAt = std::chrono::system_clock::now();
-    return true;
+    Order* found = findOrder(id);
+    if (!found) return false;
+    Order& ord = *found;
+    return changeStatus(ord, OrderStatus::Ready);
 }
 
 bool OrderManager::serveOrder(int id) {
-    OrderNode* node = active_.findById(id);
-    if (!node) return false;
-    Order& ord = node->data;
-    if (!transition(ord, OrderStatus::Served)) return false;
-    ord.servedAt = std::chrono::system_clock::now();
-    return true;
+    Order* found = findOrder(id);
+    if (!found) return false;
+    Order& ord = *found;
+    return changeStatus(ord, OrderStatus::Served);
+}
+
+bool OrderManager::advanceOrder(int id, int stage) {
+    Order* ord = findOrder(id);
+    return ord && changeStage(*ord, stage);
 }
 
-std::vector<OrderStatus> OrderManager::shortestPath(OrderStatus from, OrderStatus to) const {
-    return workflow_.shortestPath(from, to);
+WorkflowEngine::Path OrderManager::shortestPath(int fromStage, int toStage) const {
+    return workflow_.shortestPath(fromStage, toStage);
 }
 
 bool OrderManager::nextForKitchen(int& orderId) {
+    // One clock read for the start stamp and the replication record.
+    auto at = now();
+    if (!runAt(at, [&] { return pullForKitchen(orderId); })) return false;
+    if (replication_) replication_->pulled(orderId, at);
+    return true;
+}
+
+bool OrderManager::pullForKitchen(int& orderId) {
+    // A site workflow may not allow PREPPING from an order's current stage (e.g. it must be fired
+    // first). Such entries are skipped and put back where they were, never dropped.
+    std::vector<VipEntry> blockedVips;
+    std::vector<int> blockedQueue;
+    bool pulled = false;
     // Prefer VIP
     VipEntry top{};
-    while (vipHeap_.pop(top)) {
-        OrderNode* node = active_.findById(top.orderId);
-        if (!node) continue;
-        Order& ord = node->data;
-        if (ord.status == OrderStatus::Queued || ord.status == OrderStatus::Placed) {
-            orderId = ord.id;
-            startOrder(orderId);
-            return true;
+    while (!pulled && vipHeap_.pop(top)) {
+        Order* found = findOrder(top.orderId);
+        if (!found) continue;
+        Order& ord = *found;
+        // An order edited back to normal leaves a stale heap entry; it waits in the queue now.
+        if (ord.isVip && (ord.status == OrderStatus::Queued || ord.status == OrderStatus::Placed)) {
+            if (transition(ord, OrderStatus::Prepping)) {
+                orderId = ord.id;
+                pulled = true;
+            } else {
+                blockedVips.push_back(top);
+            }
         }
     }
 
     int fromQueue = 0;
-    while (normalQueue_.dequeue(fromQueue)) {
-        OrderNode* node = active_.findById(fromQueue);
-        if (!node) continue;
-        Order& ord = node->data;
+    while (!pulled && normalQueue_.dequeue(fromQueue)) {
+        Order* found = findOrder(fromQueue);
+        if (!found) continue;
+        Order& ord = *found;
         if (ord.status == OrderStatus::Queued || ord.status == OrderStatus::Placed) {
-            orderId = ord.id;
-            startOrder(orderId);
+            if (transition(ord, OrderStatus::Prepping)) {
+                orderId = ord.id;
+                pulled = true;
+            } else {
+                blockedQueue.push_back(fromQueue);
+            }
+        }
+    }
+    if (!blockedVips.empty()) vipHeap_.pushMany(blockedVips);
+    for (size_t i = blockedQueue.size(); i > 0; --i) normalQueue_.pushFront(blockedQueue[i - 1]);
+    return pulled;
+}
+
+bool OrderManager::applyKitchenPull(int id) {
+    Order* found = findOrder(id);
+    if (!found || (found->status != OrderStatus::Queued && found->status != OrderStatus::Placed)) return false;
+    if (!transition(*found, OrderStatus::Prepping)) return false;
+    // Its own entry goes stale; drain stale heads the way pullForKitchen skips them, so the
+    // queue and heap stay as short as the primary's.
+    auto waiting = [this](int orderId, bool vipLane) {
+        const Order* o = std::as_const(*this).findOrder(orderId);
+        return o && (!vipLane || o->isVip) && (o->status == OrderStatus::Queued || o->status == OrderStatus::Placed);
+    };
+    VipEntry top{};
+    while (vipHeap_.pop(top)) {
+        if (waiting(top.orderId, true)) {
+            vipHeap_.push(top);
+            break;
+        }
+    }
+    int head = 0;
+    while (normalQueue_.dequeue(head)) {
+        if (waiting(head, false)) {
+            normalQueue_.pushFront(head);
+            break;
+        }
+    }
+    return true;
+}
+
+Order* OrderManager::findOrder(int id) {
+    if (id <= 0 || static_cast<size_t>(id) >= byId_.size()) return nullptr;
+    return active_.get(byId_[static_cast<size_t>(id)]);
+}
+
+const Order* OrderManager::findOrder(int id) const {
+    if (id <= 0 || static_cast<size_t>(id) >= byId_.size()) return nullptr;
+    return active_.get(byId_[static_cast<size_t>(id)]);
+}
+
+void OrderManager::indexOrder(const Order& o, OrderHandle handle) {
+    if (o.id <= 0) return;
+    if (static_cast<size_t>(o.id) >= byId_.size()) {
+        byId_.resize(static_cast<size_t>(o.id) + 1);
+    }
+    byId_[static_cast<size_t>(o.id)] = handle;
+    placedIndex_.insert(TimeUtils::toSeconds(o.placedAt), o.id);
+    customers_.add(o.id, o.customerName);
+    if (o.status == OrderStatus::Served) {
+        indexServed(o);
+    }
+}
+
+void OrderManager::indexServed(const Order& order) {
+    servedIndex_.insert(TimeUtils::toSeconds(order.servedAt), order.id);
+}
+
+Order* OrderManager::restoreOrder(Order&& order) {
+    OrderHandle handle = active_.insert(std::move(order));
+    Order& o = *active_.get(handle);
+    indexOrder(o, handle);
+    versions_.touch(o.id);
+    if (o.status == OrderStatus::Prepping) ++preppingCount_;
+    // Replaying history trains item times; the kitchen load back then is unknown.
+    if (o.readyAt > o.startedAt) recordPrepTime(o, -1);
+    return &o;
+}
+
+size_t OrderManager::takeFinished(long long before, std::vector<Order>& out) {
+    std::vector<bool> taken(byId_.size(), false);
+    size_t count = 0;
+    active_.forEach([&](const Order& o) {
+        if (o.status == OrderStatus::Served ? TimeUtils::toSeconds(o.servedAt) < before
+                                            : o.status == OrderStatus::Cancelled && TimeUtils::toSeconds(o.placedAt) < before) {
+            taken[static_cast<size_t>(o.id)] = true;
+            ++count;
+        }
+    });
+    if (count == 0) return 0;
+    // The registry and the time indexes drop all of them in one pass each rather than one erase per order.
+    auto isTaken = [&taken](int id) { return taken[static_cast<size_t>(id)]; };
+    placedIndex_.eraseIf(isTaken);
+    servedIndex_.eraseIf(isTaken);
+    out.reserve(out.size() + count);
+    active_.eraseIf([&](const Order& o) { return isTaken(o.id); }, [&](Order&& o) {
+        customers_.remove(o.id);
+        byId_[static_cast<size_t>(o.id)] = OrderHandle{};
+        // The next snapshot drops it; saves rewrite the segments it was in.
+        versions_.touch(o.id);
+        dirtyOrders_.erase(o.id);
+        out.push_back(std::move(o));
+    });
+    segmentStore_.clear();
+    return count;
+}
+
+void OrderManager::rebuildSchedules(const std::vector<int>& queueIds) {
+    auto waiting = [](const Order& o) { return o.status == OrderStatus::Queued || o.status == OrderStatus::Placed; };
+    for (int id : queueIds) {
+        const Order* o = std::as_const(*this).findOrder(id);
+        if (o && !o->isVip && waiting(*o)) {
+            normalQueue_.enqueue(id);
+            eta_.enqueue(id, false, o->estimatedPrepMinutes);
+        }
+    }
+
+    // VIP order is derived from placement time, so the heap is rebuilt from the registry
+    std::vector<VipEntry> vips;
+    active_.forEach([&](const Order& o) {
+        if (o.isVip && waiting(o)) {
+            vips.push_back(VipEntry{o.id, TimeUtils::toNanos(o.placedAt)});
+            eta_.enqueue(o.id, true, o.estimatedPrepMinutes);
+        }
+    });
+    vipHeap_.pushMany(vips);
+}
+
+size_t OrderManager::recoverKitchen(const KitchenState& state) {
+    std::vector<bool> ticketed;
+    for (const TicketRecord& ticket : state.tickets) {
+        if (ticket.orderId <= 0 || ticket.stage < 0 || static_cast<size_t>(ticket.stage) >= workflow_.stateCount()) continue;
+        Order* order = findOrder(ticket.orderId);
+        if (!order) {
+            // Placed after the last save: the journal has no name or items, only the ticket.
+            Order placeholder;
+            placeholder.id = ticket.orderId;
+            placeholder.customerName = "(recovered ticket)";
+            placeholder.isVip = ticket.isVip();
+            placeholder.placedAt = TimeUtils::fromNanos(ticket.placedAtNanos);
+            order = restoreOrder(std::move(placeholder));
+            markChanged(ticket.orderId);
+            if (nextId_ <= ticket.orderId) nextId_ = ticket.orderId + 1;
+        }
+        applyTicket(*order, ticket);
+        if (ticketed.size() <= static_cast<size_t>(ticket.orderId)) ticketed.resize(static_cast<size_t>(ticket.orderId) + 1, false);
+        ticketed[static_cast<size_t>(ticket.orderId)] = true;
+    }
+    size_t unknown = 0;
+    active_.forEach([&](const Order& o) {
+        bool live = o.status != OrderStatus::Served && o.status != OrderStatus::Cancelled;
+        if (live && (static_cast<size_t>(o.id) >= ticketed.size() || !ticketed[static_cast<size_t>(o.id)])) ++unknown;
+    });
+
+    normalQueue_ = IntQueue(state.queue.size() + 16);
+    vipHeap_ = VipHeap();
+    eta_.clear();
+    rebuildSchedules(state.queue);
+    return unknown;
+}
+
+void OrderManager::applyTicket(Order& order, const TicketRecord& ticket) {
+    bool sameStage = WorkflowEngine::stageOf(order) == ticket.stage;
+    if (sameStage && order.isVip == ticket.isVip()) return;
+    if (order.status == OrderStatus::Prepping) --preppingCount_;
+    order.isVip = ticket.isVip();
+    order.stage = ticket.stage < static_cast<int>(OrderWorkflowSpec::kStateCount) ? -1 : ticket.stage;
+    order.status = workflow_.baseStatus(ticket.stage);
+    if (order.status == OrderStatus::Prepping) ++preppingCount_;
+    if (!sameStage && !ticket.isWaiting()) {
+        auto at = TimeUtils::fromNanos(ticket.value);
+        switch (order.status) {
+            case OrderStatus::Prepping: order.startedAt = at; break;
+            case OrderStatus::Ready: order.readyAt = at; break;
+            case OrderStatus::Served:
+                order.servedAt = at;
+                indexServed(order);
+                break;
+            default: break;
+        }
+    }
+    markChanged(order.id);
+}
+
+bool OrderManager::projectedReadyAt(int id, std::chrono::system_clock::time_point& out) const {
+    const Order* found = findOrder(id);
+    if (!found) return false;
+    const Order& o = *found;
+    switch (o.status) {
+        case OrderStatus::Placed:
+        case OrderStatus::Queued: {
+            long long ahead = eta_.minutesAhead(id);
+            if (ahead < 0) return false;
+            long long minutes = (ahead + kitchenStations_ - 1) / kitchenStations_ + o.estimatedPrepMinutes;
+            out = now() + std::chrono::minutes(minutes);
             return true;
         }
+        case OrderStatus::Prepping:
+            out = o.startedAt + std::chrono::minutes(o.estimatedPrepMinutes);
+            return true;
+        case OrderStatus::Ready:
+        case OrderStatus::Served:
+            out = o.readyAt;
+            return true;
+        case OrderStatus::Cancelled:
+            break;
     }
     return false;
 }
 
+void OrderManager::recordPrepTime(const Order& order, int load) {
+    estimator_.observe(order, menuDefaults_, load);
+}
+
+int OrderManager::estimatePrepMinutes(const std::vector<OrderItem>& items) const {
+    return estimator_.estimateMinutes(items, menuDefaults_, preppingCount_);
+}
+
+std::vector<Order> OrderManager::placedBetween(long long from, long long to, size_t limit) const {
+    ListQuery query;
+    query.since = from;
+    query.until = to;
+    query.limit = limit;
+    return listPage(query);
+}
+
+std::vector<Order> OrderManager::servedBetween(long long from, long long to, size_t limit) const {
+    ListQuery query;
+    query.since = from;
+    query.until = to;
+    query.limit = limit;
+    query.byServed = true;
+    query.statusMask = ListQuery::maskOf(OrderStatus::Served);
+    return listPage(query);
+}
+
+std::vector<Order> OrderManager::findByCustomer(const std::string& prefix, size_t limit, bool* fuzzy) const {
+    std::vector<int> ids = customers_.prefix(prefix, limit);
+    bool usedFuzzy = ids.empty();
+    if (usedFuzzy) {
+        ids = customers_.fuzzy(prefix, limit == 0 ? 20 : limit);
+    }
+    if (fuzzy) *fuzzy = usedFuzzy;
+    std::vector<Order> result;
+    result.reserve(ids.size());
+    for (int id : ids) {
+        if (const Order* o = findOrder(id)) {
+            result.push_back(*o);
+        }
+    }
+    return result;
+}
+
 Order* OrderManager::getOrder(int id) {
-    OrderNode* node = active_.findById(id);
-    if (!node) return nullptr;
-    return &node->data;
+    return findOrder(id);
+}
+
+const Order* OrderManager::getOrder(int id) const {
+    return findOrder(id);
 }
 
 std::vector<Order> OrderManager::listByStatus(OrderStatus status) const {
     std::vector<Order> out;
-    active_.forEach([&](OrderNode* node) {
-        if (node->data.status == status) {
-            out.push_back(node->data);
+    active_.forEach([&](const Order& o) {
+        if (o.status == status) {
+            out.push_back(o);
         }
     });
     return out;
 }
 
+template <typename Func>
+void OrderManager::forEachInWindow(const ListQuery& query, Func fn) const {
+    const TimeIndex& index = query.byServed ? servedIndex_ : placedIndex_;
+    long long from = query.since;
+    long long to = query.until != 0 ? query.until : std::numeric_limits<long long>::max();
+    if (query.newestFirst) {
+        index.forEachInRangeReverse(from, to, fn);
+    } else {
+        index.forEachInRange(from, to, fn);
+    }
+}
+
+std::vector<Order> OrderManager::listPage(const ListQuery& query, int* nextAfterId) const {
+    const Order* cursor = nullptr;
+    if (query.afterId != 0) {
+        cursor = findOrder(query.afterId);
+        if (!cursor) return {};
+    }
+    PageSelector select(query, cursor);
+    if (query.since != 0 || query.until != 0) {
+        // Time window: walk the matching slice of the time index, already in output order,
+        // so the cost is O(log n + k) instead of a registry scan.
+        forEachInWindow(query, [&](int id) {
+            const Order* o = findOrder(id);
+            return !o || select.append(*o);
+        });
+    } else {
+        select.scan([&](auto&& fn) { active_.forEach(fn); });
+    }
+    return select.finish(nextAfterId);
+}
+
+std::vector<int> OrderManager::windowIds(const ListQuery& query) const {
+    std::vector<int> ids;
+    if (query.since == 0 && query.until == 0) return ids;
+    forEachInWindow(query, [&](int id) {
+        ids.push_back(id);
+        return true;
+    });
+    return ids;
+}
+
+std::vector<Order> OrderManager::listPage(const OrderSnapshot& snapshot, const ListQuery& query, int* nextAfterId,
+                                          const std::vector<int>* window) {
+    const Order* cursor = nullptr;
+    if (query.afterId != 0) {
+        cursor = snapshot.find(query.afterId);
+        if (!cursor) return {};
+    }
+    PageSelector select(query, cursor);
+    if (window) {
+        // Already in output order, as in the live windowed listing.
+        for (int id : *window) {
+            const Order* o = snapshot.find(id);
+            if (o && !select.append(*o)) break;
+        }
+    } else {
+        select.scan([&](auto&& fn) { snapshot.forEach(fn); });
+    }
+    return select.finish(nextAfterId);
+}
+
 std::vector<Order> OrderManager::snapshotAll() const {
     std::vector<Order> out;
-    active_.forEach([&](OrderNode* node) {
-        out.push_back(node->data);
+    out.reserve(active_.size());
+    active_.forEach([&](const Order& o) {
+        out.push_back(o);
     });
     return out;
 }
 
 bool OrderManager::transition(Order& order, OrderStatus to) {
     if (order.status == to) return true;
-    if (!workflow_.canTransition(order.status, to)) {
+    // Standard stages share their OrderStatus numbering.
+    return transitionStage(order, static_cast<int>(to));
+}
+
+bool OrderManager::changeStatus(Order& order, OrderStatus to) {
+    if (order.status == to) return true;
+    return changeStage(order, static_cast<int>(to));
+}
+
+bool OrderManager::changeStage(Order& order, int to) {
+    if (!replication_) return transitionStage(order, to);
+    if (WorkflowEngine::stageOf(order) == to) return true;
+    // The hooks' timestamps and the record share one clock read, so the standby stamps the same times.
+    auto at = now();
+    if (!runAt(at, [&] { return transitionStage(order, to); })) return false;
+    replication_->staged(order.id, to, at);
+    return true;
+}
+
+bool OrderManager::transitionStage(Order& order, int to) {
+    int from = WorkflowEngine::stageOf(order);
+    if (from == to) return true;
+    if (!workflow_.apply(order, to)) {
         return false;
     }
-    order.status = to;
+    if (workflow_.baseStatus(from) == OrderStatus::Prepping) --preppingCount_;
+    if (order.status == OrderStatus::Prepping) ++preppingCount_;
+    OrderStatus before = workflow_.baseStatus(from);
+    bool wasWaiting = before == OrderStatus::Placed || before == OrderStatus::Queued;
+    if (order.status == OrderStatus::Placed || order.status == OrderStatus::Queued) {
+        if (!wasWaiting) {
+            // Back in line (a refire): a fresh lane entry, as editOrder adds on a lane change.
+            // Any older entry for the order is skipped as stale once it has been pulled.
+            if (order.isVip) {
+                vipHeap_.push(VipEntry{order.id, TimeUtils::toNanos(order.placedAt)});
+            } else {
+                normalQueue_.enqueue(order.id);
+            }
+        }
+        if (!eta_.isQueued(order.id)) eta_.enqueue(order.id, order.isVip, order.estimatedPrepMinutes);
+    } else {
+        eta_.remove(order.id);
+    }
+    markChanged(order.id);
+    publish(order.status == OrderStatus::Cancelled ? OrderEventType::Cancelled : OrderEventType::Transitioned, order.id, from, to);
+    if (journal_) journal_->record(order, now());
     return true;
 }
 
+OrderEventRing* OrderManager::subscribe(size_t capacity) {
+    subscribers_.push_back(std::make_unique<OrderEventRing>(capacity));
+    return subscribers_.back().get();
+}
+
+void OrderManager::unsubscribe(OrderEventRing* ring) {
+    for (size_t i = 0; i < subscribers_.size(); ++i) {
+        if (subscribers_[i].get() == ring) {
+            subscribers_.erase(subscribers_.begin() + static_cast<std::ptrdiff_t>(i));
+            return;
+        }
+    }
+}
+
+void OrderManager::publish(OrderEventType type, int orderId, int fromStage, int toStage) {
+    if (subscribers_.empty()) return;
+    OrderEvent event;
+    event.type = type;
+    event.orderId = orderId;
+    event.fromStage = fromStage;
+    event.toStage = toStage;
+    event.publishedNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    for (auto& ring : subscribers_) {
+        ring->tryPush(event);
+    }
+}
+
 void OrderManager::reset() {
-    active_.clearAll();
+    active_.clear();
+    byId_.clear();
+    placedIndex_.clear();
+    servedIndex_.clear();
+    customers_.clear();
+    estimator_.clear();
+    eta_.clear();
+    menuDefaults_.clear();
+    preppingCount_ = 0;
+    versions_.clear();
     normalQueue_ = IntQueue(256);
     vipHeap_ = VipHeap();
-    menu_ = MenuBST();
+    menu_.clear();
     nextId_ = 1;
     nextMenuId_ = 1;
+    clearDirty();
+    segmentStore_.clear();
+}
+
+void OrderManager::markChanged(int id) {
+    dirtyOrders_.insert(id);
+    versions_.touch(id);
+}
+
+OrderSnapshot OrderManager::snapshot() const {
+    OrderSnapshot snap = versions_.snapshot([this](int id) -> const Order* { return findOrder(id); });
+    snap.nextId_ = nextId_;
+    snap.nextMenuId_ = nextMenuId_;
+    snap.queue_ = normalQueue_.snapshot();
+    snap.menu_ = listMenuItems();
+    snap.stageNames_.reserve(workflow_.stateCount());
+    for (size_t i = 0; i < workflow_.stateCount(); ++i) {
+        snap.stageNames_.push_back(workflow_.stateName(static_cast<int>(i)));
+    }
+    return snap;
+}
+
+void OrderManager::clearDirty() {
+    dirtyOrders_.clear();
+    menuDirty_ = false;
 }
 
 int OrderManager::addMenuItem(const std::string& name, int defaultPrepMinutes, int itemId) {
@@ -178,11 +803,24 @@ int OrderManager::addMenuItem(const std::string& name, int defaultPrepMinutes, i
     if (!inserted) {
         return -1;
     }
+    if (static_cast<size_t>(item.itemId) >= menuDefaults_.size()) {
+        menuDefaults_.resize(static_cast<size_t>(item.itemId) + 1, 0);
+    }
+    menuDefaults_[static_cast<size_t>(item.itemId)] = defaultPrepMinutes;
+    menuDirty_ = true;
+    if (replication_) replication_->menuAdded(item);
     return item.itemId;
 }
 
 bool OrderManager::removeMenuItem(const std::string& name) {
-    return menu_.remove(name);
+    MenuItem* item = menu_.find(name);
+    if (!item) return false;
+    size_t id = static_cast<size_t>(item->itemId);
+    if (!menu_.remove(name)) return false;
+    if (id < menuDefaults_.size()) menuDefaults_[id] = 0;
+    menuDirty_ = true;
+    if (replication_) replication_->menuRemoved(name);
+    return true;
 }
 
 MenuItem* OrderManager::findMenuItem(const std::string& name) {
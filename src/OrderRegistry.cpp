@@ -0,0 +1,63 @@
+#include "OrderRegistry.h"
+
+#include <utility>
+
+OrderHandle OrderRegistry::insert(Order&& order) {
+    uint32_t slot = freeHead_;
+    if (slot != OrderHandle::kNone) {
+        freeHead_ = slots_[slot].dense;
+    } else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+    slots_[slot].dense = static_cast<uint32_t>(orders_.size());
+    orders_.push_back(std::move(order));
+    slotOf_.push_back(slot);
+    return OrderHandle{slot, slots_[slot].generation};
+}
+
+Order* OrderRegistry::get(OrderHandle handle) {
+    return const_cast<Order*>(std::as_const(*this).get(handle));
+}
+
+const Order* OrderRegistry::get(OrderHandle handle) const {
+    if (handle.slot >= slots_.size()) return nullptr;
+    const Slot& s = slots_[handle.slot];
+    // Freed slots move to a new generation, so a matching one is always live.
+    if (s.generation != handle.generation) return nullptr;
+    return &orders_[s.dense];
+}
+
+bool OrderRegistry::erase(OrderHandle handle) {
+    if (!get(handle)) return false;
+    uint32_t hole = slots_[handle.slot].dense;
+    uint32_t last = static_cast<uint32_t>(orders_.size() - 1);
+    if (hole != last) {
+        orders_[hole] = std::move(orders_[last]);
+        slotOf_[hole] = slotOf_[last];
+        slots_[slotOf_[hole]].dense = hole;
+    }
+    orders_.pop_back();
+    slotOf_.pop_back();
+    release(handle.slot);
+    return true;
+}
+
+void OrderRegistry::reserve(size_t count) {
+    orders_.reserve(count);
+    slotOf_.reserve(count);
+    slots_.reserve(count);
+}
+
+void OrderRegistry::clear() {
+    // Slots are retired rather than dropped, so handles from before the clear stay stale.
+    for (uint32_t slot : slotOf_) release(slot);
+    orders_.clear();
+    slotOf_.clear();
+}
+
+void OrderRegistry::release(uint32_t slot) {
+    ++slots_[slot].generation;
+    slots_[slot].dense = freeHead_;
+    freeHead_ = slot;
+}
@@ -0,0 +1,69 @@
+#include "OrderSnapshot.h"
+
+#include <atomic>
+
+const Order* OrderSnapshot::find(int id) const {
+    if (id <= 0 || !pages_) return nullptr;
+    size_t page = static_cast<size_t>(id) / kPageSize;
+    if (page >= pages_->size() || !(*pages_)[page]) return nullptr;
+    return (*(*pages_)[page])[static_cast<size_t>(id) % kPageSize].get();
+}
+
+void OrderVersions::touch(int id) {
+    if (id <= 0) return;
+    size_t slot = static_cast<size_t>(id);
+    if (slot >= pendingFlag_.size()) pendingFlag_.resize(slot + 1, 0);
+    if (pendingFlag_[slot]) return;
+    pendingFlag_[slot] = 1;
+    pending_.push_back(id);
+}
+
+OrderSnapshot OrderVersions::snapshot(const std::function<const Order*(int)>& lookup) {
+    if (!pending_.empty() || !published_) {
+        // Let go of the last published table first, so pages only it referenced become
+        // writable in place again.
+        published_.reset();
+        for (int id : pending_) {
+            store(id, lookup(id));
+            pendingFlag_[static_cast<size_t>(id)] = 0;
+        }
+        pending_.clear();
+        auto table = std::make_shared<OrderSnapshot::PageTable>(pages_.begin(), pages_.end());
+        published_ = std::move(table);
+        ++epoch_;
+    }
+    OrderSnapshot snap;
+    snap.epoch_ = epoch_;
+    snap.pages_ = published_;
+    snap.count_ = count_;
+    return snap;
+}
+
+void OrderVersions::store(int id, const Order* current) {
+    size_t index = static_cast<size_t>(id) / OrderSnapshot::kPageSize;
+    if (index >= pages_.size()) pages_.resize(index + 1);
+    auto& page = pages_[index];
+    if (!page) {
+        if (!current) return;
+        page = std::make_shared<OrderSnapshot::Page>();
+    } else if (page.use_count() > 1) {
+        page = std::make_shared<OrderSnapshot::Page>(*page);
+    } else {
+        // Sole owner: readers released the page with an acq_rel decrement, which this fence
+        // pairs with before the page is written in place.
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    auto& slot = (*page)[static_cast<size_t>(id) % OrderSnapshot::kPageSize];
+    if (slot && !current) --count_;
+    if (!slot && current) ++count_;
+    slot = current ? std::make_shared<const Order>(*current) : nullptr;
+}
+
+void OrderVersions::clear() {
+    pages_.clear();
+    published_.reset();
+    pending_.clear();
+    pendingFlag_.clear();
+    count_ = 0;
+    ++epoch_;
+}
@@ -1,7 +1,12 @@
 #include "Persistence.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <cctype>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <set>
 
 namespace {
     std::string escape(const std::string& s) {
@@ -73,15 +78,155 @@ namespace {
         return false;
     }
 
+
+    /** Index of the bracket closing the one at open, skipping quoted strings; npos if unbalanced. */
+    size_t findClosing(const std::string& src, size_t open) {
+        if (open >= src.size()) return std::string::npos;
+        char openCh = src[open];
+        char closeCh = openCh == '[' ? ']' : '}';
+        int depth = 0;
+        bool inString = false;
+        for (size_t i = open; i < src.size(); ++i) {
+            char c = src[i];
+            if (inString) {
+                if (c == '\\') ++i;
+                else if (c == '"') inString = false;
+            } else if (c == '"') {
+                inString = true;
+            } else if (c == openCh) {
+                ++depth;
+            } else if (c == closeCh && --depth == 0) {
+                return i;
+            }
+        }
+        return std::string::npos;
+    }
+
+    /** Reads a quoted string starting at src[pos] == '"', undoing escape(); pos ends past the closing quote. */
+    bool readQuoted(const std::string& src, size_t& pos, std::string& out) {
+        if (pos >= src.size() || src[pos] != '"') return false;
+        out.clear();
+        for (++pos; pos < src.size(); ++pos) {
+            char c = src[pos];
+            if (c == '\\' && pos + 1 < src.size()) {
+                out.push_back(src[++pos]);
+            } else if (c == '"') {
+                ++pos;
+                return true;
+            } else {
+                out.push_back(c);
+            }
+        }
+        return false;
+    }
+
+    bool readNumber(const std::string& src, size_t& pos, int& out) {
+        while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos]))) ++pos;
+        bool negative = pos < src.size() && src[pos] == '-';
+        if (negative) ++pos;
+        if (pos >= src.size() || !std::isdigit(static_cast<unsigned char>(src[pos]))) return false;
+        long long v = 0;
+        while (pos < src.size() && std::isdigit(static_cast<unsigned char>(src[pos]))) {
+            v = v * 10 + (src[pos++] - '0');
+        }
+        out = static_cast<int>(negative ? -v : v);
+        return true;
+    }
+
+    /**
+     * Items are stored as [itemId, qty] pairs when the menu still holds that id under the same
+     * name, otherwise as ["name", qty] so ad-hoc items survive a restart.
+     */
+    void writeItems(std::ostringstream& out, const std::vector<OrderItem>& items, const std::vector<const MenuItem*>& menuById) {
+        out << "[";
+        for (size_t i = 0; i < items.size(); ++i) {
+            const OrderItem& it = items[i];
+            if (i > 0) out << ",";
+            bool byId = it.itemId > 0 && static_cast<size_t>(it.itemId) < menuById.size()
+                        && menuById[it.itemId] && menuById[it.itemId]->name == it.name;
+            if (byId) {
+                out << "[" << it.itemId << "," << it.quantity << "]";
+            } else {
+                out << "[\"" << escape(it.name) << "\"," << it.quantity << "]";
+            }
+        }
+        out << "]";
+    }
+
+    /** Parses the "items" array of one order object, reserving once for all pairs. */
+    void readItems(const std::string& obj, const std::vector<const MenuItem*>& menuById, std::vector<OrderItem>& items) {
+        auto pos = obj.find("\"items\"");
+        if (pos == std::string::npos) return;
+        auto open = obj.find('[', pos);
+        auto close = findClosing(obj, open);
+        if (close == std::string::npos) return;
+
+        size_t pairs = 0;
+        bool inString = false;
+        for (size_t i = open + 1; i < close; ++i) {
+            char c = obj[i];
+            if (inString) {
+                if (c == '\\') ++i;
+                else if (c == '"') inString = false;
+            } else if (c == '"') {
+                inString = true;
+            } else if (c == '[') {
+                ++pairs;
+            }
+        }
+        items.reserve(pairs);
+
+        size_t cursor = open + 1;
+        while (true) {
+            auto pairStart = obj.find_first_of("[\"", cursor);
+            while (pairStart != std::string::npos && pairStart < close && obj[pairStart] == '"') {
+                // Stray string outside a pair: skip it.
+                std::string skipped;
+                if (!readQuoted(obj, pairStart, skipped)) return;
+                pairStart = obj.find_first_of("[\"", pairStart);
+            }
+            if (pairStart == std::string::npos || pairStart >= close) break;
+            size_t p = pairStart + 1;
+            while (p < close && std::isspace(static_cast<unsigned char>(obj[p]))) ++p;
+            OrderItem item;
+            bool ok = false;
+            if (p < close && obj[p] == '"') {
+                ok = readQuoted(obj, p, item.name);
+            } else if (readNumber(obj, p, item.itemId)) {
+                ok = item.itemId > 0 && static_cast<size_t>(item.itemId) < menuById.size() && menuById[item.itemId];
+                if (ok) item.name = menuById[item.itemId]->name;
+            }
+            auto comma = obj.find(',', p);
+            auto pairEnd = findClosing(obj, pairStart);
+            if (pairEnd == std::string::npos) return;
+            if (ok && comma < pairEnd) {
+                p = comma + 1;
+                ok = readNumber(obj, p, item.quantity) && item.quantity > 0;
+            } else {
+                ok = false;
+            }
+            if (ok) items.push_back(std::move(item));
+            cursor = pairEnd + 1;
+        }
+    }
+
     bool extractString(const std::string& src, const std::string& key, std::string& out) {
         auto pos = src.find("\"" + key + "\"");
         if (pos == std::string::npos) return false;
         pos = src.find('"', pos + key.size() + 2);
         if (pos == std::string::npos) return false;
-        size_t end = src.find('"', pos + 1);
-        if (end == std::string::npos) return false;
-        out = src.substr(pos + 1, end - pos - 1);
-        return true;
+        return readQuoted(src, pos, out);
+    }
+
+    /** Menu items indexed by id so order items can resolve names without BST searches. */
+    std::vector<const MenuItem*> indexMenu(const std::vector<MenuItem>& menuItems) {
+        std::vector<const MenuItem*> byId;
+        for (const auto& m : menuItems) {
+            if (m.itemId <= 0) continue;
+            if (static_cast<size_t>(m.itemId) >= byId.size()) byId.resize(m.itemId + 1, nullptr);
+            byId[m.itemId] = &m;
+        }
+        return byId;
     }
 
     std::vector<int> parseIntArray(const std::string& src, const std::string& key) {
@@ -106,83 +251,78 @@ namespace {
         }
         return values;
     }
-}
 
-bool Persistence::saveState(const OrderManager& manager, const std::string& path) {
-    std::ostringstream out;
-    auto orders = manager.snapshotAll();
-    auto normalIds = manager.normalQueue().snapshot();
-    auto menuItems = manager.listMenuItems();
-
-    out << "{\n";
-    out << "  \"nextId\": " << manager.nextIdValue() << ",\n";
-    out << "  \"nextMenuId\": " << manager.nextMenuIdValue() << ",\n";
-    out << "  \"orders\": [\n";
-    for (size_t i = 0; i < orders.size(); ++i) {
-        const Order& o = orders[i];
+    void writeOrder(std::ostringstream& out, const OrderSnapshot& snapshot, const Order& o, const std::vector<const MenuItem*>& menuById) {
         out << "    {";
         out << "\"id\": " << o.id << ",";
         out << " \"customer\": \"" << escape(o.customerName) << "\",";
         out << " \"vip\": " << (o.isVip ? "true" : "false") << ",";
         out << " \"estimated\": " << o.estimatedPrepMinutes << ",";
         out << " \"status\": \"" << OrderStatusStrings::toString(o.status) << "\",";
+        if (o.stage >= 0) {
+            out << " \"stage\": \"" << escape(snapshot.stageName(o.stage)) << "\",";
+        }
         out << " \"placed\": " << TimeUtils::toSeconds(o.placedAt) << ",";
         out << " \"started\": " << TimeUtils::toSeconds(o.startedAt) << ",";
         out << " \"ready\": " << TimeUtils::toSeconds(o.readyAt) << ",";
-        out << " \"served\": " << TimeUtils::toSeconds(o.servedAt) << "";
+        out << " \"served\": " << TimeUtils::toSeconds(o.servedAt) << ",";
+        out << " \"items\": ";
+        writeItems(out, o.items, menuById);
         out << " }";
-        if (i + 1 < orders.size()) out << ",";
-        out << "\n";
-    }
-    out << "  ],\n";
-    out << "  \"queue\": [";
-    for (size_t i = 0; i < normalIds.size(); ++i) {
-        out << normalIds[i];
-        if (i + 1 < normalIds.size()) out << ",";
-    }
-    out << "],\n";
-    out << "  \"menu\": [\n";
-    for (size_t i = 0; i < menuItems.size(); ++i) {
-        const auto& m = menuItems[i];
-        out << "    {\"id\": " << m.itemId << ", \"name\": \"" << escape(m.name) << "\", \"prep\": " << m.defaultPrepMinutes << "}";
-        if (i + 1 < menuItems.size()) out << ",";
-        out << "\n";
     }
-    out << "  ],\n";
-    out << "  \"version\": 1\n";
-    out << "}\n";
 
-    return writeFile(path, out.str());
-}
-
-bool Persistence::loadState(OrderManager& manager, const std::string& path) {
-    std::string content;
-    if (!readFile(path, content)) {
-        return false;
+    void writeQueue(std::ostringstream& out, const std::vector<int>& ids) {
+        out << "  \"queue\": [";
+        for (size_t i = 0; i < ids.size(); ++i) {
+            out << ids[i];
+            if (i + 1 < ids.size()) out << ",";
+        }
+        out << "],\n";
     }
 
-    manager.reset();
-
-    int nextId = 1;
-    extractInt(content, "nextId", nextId);
-    manager.setNextId(nextId);
-    int nextMenuId = 1;
-    extractInt(content, "nextMenuId", nextMenuId);
-    manager.setNextMenuId(nextMenuId);
+    void writeMenu(std::ostringstream& out, const std::vector<MenuItem>& menuItems) {
+        out << "  \"menu\": [\n";
+        for (size_t i = 0; i < menuItems.size(); ++i) {
+            const auto& m = menuItems[i];
+            out << "    {\"id\": " << m.itemId << ", \"name\": \"" << escape(m.name) << "\", \"prep\": " << m.defaultPrepMinutes << "}";
+            if (i + 1 < menuItems.size()) out << ",";
+            out << "\n";
+        }
+        out << "  ],\n";
+    }
 
-    // Parse orders array
-    auto ordersPos = content.find("\"orders\"");
-    if (ordersPos != std::string::npos) {
-        auto arrayStart = content.find('[', ordersPos);
-        auto arrayEnd = content.find(']', arrayStart);
+    /** Calls fn with the text of every object inside the array stored under key. */
+    template <typename Func>
+    void forEachObject(const std::string& content, const std::string& key, Func fn) {
+        auto keyPos = content.find("\"" + key + "\"");
+        if (keyPos == std::string::npos) return;
+        auto arrayStart = content.find('[', keyPos);
+        auto arrayEnd = findClosing(content, arrayStart);
         size_t cursor = arrayStart;
         while (true) {
             auto objStart = content.find('{', cursor);
             if (objStart == std::string::npos || objStart > arrayEnd) break;
-            auto objEnd = content.find('}', objStart);
+            auto objEnd = findClosing(content, objStart);
             if (objEnd == std::string::npos) break;
-            std::string obj = content.substr(objStart, objEnd - objStart + 1);
+            fn(content.substr(objStart, objEnd - objStart + 1));
+            cursor = objEnd + 1;
+        }
+    }
 
+    void loadMenu(OrderManager& manager, const std::string& content) {
+        forEachObject(content, "menu", [&](const std::string& obj) {
+            MenuItem item;
+            extractInt(obj, "id", item.itemId);
+            extractString(obj, "name", item.name);
+            extractInt(obj, "prep", item.defaultPrepMinutes);
+            if (!item.name.empty() && item.defaultPrepMinutes > 0) {
+                manager.addMenuItem(item.name, item.defaultPrepMinutes, item.itemId);
+            }
+        });
+    }
+
+    void loadOrders(OrderManager& manager, const std::string& content, const std::vector<const MenuItem*>& menuById) {
+        forEachObject(content, "orders", [&](const std::string& obj) {
             Order order;
             extractInt(obj, "id", order.id);
             extractString(obj, "customer", order.customerName);
@@ -206,54 +346,267 @@ bool Persistence::loadState(OrderManager& manager, const std::string& path) {
             order.startedAt = TimeUtils::fromSeconds(started);
             order.readyAt = TimeUtils::fromSeconds(ready);
             order.servedAt = TimeUtils::fromSeconds(served);
+            readItems(obj, menuById, order.items);
+            std::string stageText;
+            if (extractString(obj, "stage", stageText)) {
+                // Custom stages survive only if the current workflow still defines them.
+                int stage = manager.workflow().stateId(stageText);
+                if (stage >= static_cast<int>(OrderWorkflowSpec::kStateCount) && manager.workflow().baseStatus(stage) == order.status) {
+                    order.stage = stage;
+                }
+            }
 
-            manager.registry().pushBack(order);
-            cursor = objEnd + 1;
-        }
+            manager.restoreOrder(std::move(order));
+        });
     }
 
-    // Rebuild queues
-    auto queueIds = parseIntArray(content, "queue");
-    for (int id : queueIds) {
-        Order* order = manager.getOrder(id);
-        if (order && !order->isVip && (order->status == OrderStatus::Queued || order->status == OrderStatus::Placed)) {
-            manager.normalQueue().enqueue(order->id);
-        }
+    /** Writes via a temporary file and rename so a crash never leaves a half-written file behind. */
+    bool replaceFile(const std::string& path, const std::string& data) {
+        std::string tmp = path + ".tmp";
+        if (!writeFile(tmp, data)) return false;
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        return !ec;
     }
 
-    // Rebuild VIP heap from orders flagged as VIP and queued/placed
-    manager.registry().forEach([&](OrderNode* node) {
-        Order& o = node->data;
-        if (o.isVip && (o.status == OrderStatus::Queued || o.status == OrderStatus::Placed)) {
-            VipEntry e{o.id, TimeUtils::toSeconds(o.placedAt)};
-            manager.vipHeap().push(e);
+    /** Segment file name for the UTC day an order was placed on, e.g. orders-20250131.json. */
+    std::string segmentName(long long placedSeconds) {
+        std::time_t tt = static_cast<std::time_t>(placedSeconds - placedSeconds % 86400);
+        std::tm* tm = std::gmtime(&tt);
+        char buf[32];
+        if (!tm || std::strftime(buf, sizeof(buf), "orders-%Y%m%d.json", tm) == 0) {
+            return "orders-" + std::to_string(placedSeconds / 86400) + ".json";
         }
+        return buf;
+    }
+}
+
+std::string Persistence::renderState(const OrderManager& manager) {
+    return renderState(manager.snapshot());
+}
+
+std::string Persistence::renderState(const OrderSnapshot& snapshot) {
+    std::ostringstream out;
+    auto menuById = indexMenu(snapshot.menu());
+
+    out << "{\n";
+    out << "  \"nextId\": " << snapshot.nextId() << ",\n";
+    out << "  \"nextMenuId\": " << snapshot.nextMenuId() << ",\n";
+    out << "  \"orders\": [\n";
+    size_t remaining = snapshot.size();
+    snapshot.forEach([&](const Order& o) {
+        writeOrder(out, snapshot, o, menuById);
+        if (--remaining > 0) out << ",";
+        out << "\n";
     });
+    out << "  ],\n";
+    writeQueue(out, snapshot.queue());
+    writeMenu(out, snapshot.menu());
+    out << "  \"version\": 1\n";
+    out << "}\n";
+    return out.str();
+}
 
-    // Load menu items
-    auto menuPos = content.find("\"menu\"");
-    if (menuPos != std::string::npos) {
-        auto arrayStart = content.find('[', menuPos);
-        auto arrayEnd = content.find(']', arrayStart);
-        size_t cursor = arrayStart;
-        while (true) {
-            auto objStart = content.find('{', cursor);
-            if (objStart == std::string::npos || objStart > arrayEnd) break;
-            auto objEnd = content.find('}', objStart);
-            if (objEnd == std::string::npos) break;
-            std::string obj = content.substr(objStart, objEnd - objStart + 1);
+bool Persistence::saveState(const OrderManager& manager, const std::string& path) {
+    return writeAll({{path, renderState(manager)}});
+}
 
-            MenuItem item;
-            extractInt(obj, "id", item.itemId);
-            extractString(obj, "name", item.name);
-            extractInt(obj, "prep", item.defaultPrepMinutes);
-            if (!item.name.empty() && item.defaultPrepMinutes > 0) {
-                manager.addMenuItem(item.name, item.defaultPrepMinutes, item.itemId);
-            }
+bool Persistence::readText(const std::string& path, std::string& content) {
+    return readFile(path, content);
+}
 
-            cursor = objEnd + 1;
+bool Persistence::writeAll(const PendingWrites& writes) {
+    std::filesystem::path lastParent;
+    for (const auto& w : writes) {
+        std::filesystem::path parent = std::filesystem::path(w.first).parent_path();
+        if (!parent.empty() && parent != lastParent) {
+            std::error_code ec;
+            std::filesystem::create_directories(parent, ec);
+            if (ec) return false;
+            lastParent = parent;
+        }
+        if (!replaceFile(w.first, w.second)) return false;
+    }
+    return true;
+}
+
+bool Persistence::loadState(OrderManager& manager, const std::string& path) {
+    std::string content;
+    if (!readFile(path, content)) {
+        return false;
+    }
+    applyState(manager, content);
+    return true;
+}
+
+void Persistence::applyState(OrderManager& manager, const std::string& content) {
+    manager.reset();
+
+    int nextId = 1;
+    extractInt(content, "nextId", nextId);
+    manager.setNextId(nextId);
+    int nextMenuId = 1;
+    extractInt(content, "nextMenuId", nextMenuId);
+    manager.setNextMenuId(nextMenuId);
+
+    // Load menu items first so order items can resolve their names by id
+    loadMenu(manager, content);
+    auto menuItems = manager.listMenuItems();
+    loadOrders(manager, content, indexMenu(menuItems));
+    manager.rebuildSchedules(parseIntArray(content, "queue"));
+    manager.clearDirty();
+}
+
+bool Persistence::saveSegments(OrderManager& manager, const std::string& dir, size_t* segmentsWritten) {
+    PendingWrites writes;
+    prepareSegments(manager, dir, writes);
+    if (!writeAll(writes)) {
+        // Dirty marks were consumed by prepareSegments; forget the store so the next save is full.
+        manager.setSegmentStore("");
+        return false;
+    }
+    // The manifest is always written; every other entry is a rewritten segment or the menu.
+    if (segmentsWritten) *segmentsWritten = writes.size() - 1;
+    return true;
+}
+
+void Persistence::prepareSegments(OrderManager& manager, const std::string& dir, PendingWrites& writes) {
+    renderSegments(beginSegments(manager, dir), writes);
+}
+
+Persistence::SegmentJob Persistence::beginSegments(OrderManager& manager, const std::string& dir) {
+    SegmentJob job;
+    job.snapshot = manager.snapshot();
+    job.dir = dir;
+    // A store other than the one the clean state came from gets every segment.
+    job.full = manager.segmentStore() != dir;
+    job.menuChanged = job.full || manager.menuDirty();
+
+    // Days come from the placed-time index and changed orders are looked up by id, so a save
+    // visits only the orders of the days that changed instead of the whole snapshot.
+    const TimeIndex& placed = manager.placedIndex();
+    placed.forEachBucket(86400, [&](long long day) { job.days.push_back(day); });
+    std::set<long long> dirtyDays;
+    if (job.full) {
+        dirtyDays.insert(job.days.begin(), job.days.end());
+    } else {
+        for (int id : manager.dirtyOrders()) {
+            if (const Order* o = manager.getOrder(id)) dirtyDays.insert(TimeUtils::toSeconds(o->placedAt) / 86400);
         }
     }
+    for (long long day : dirtyDays) {
+        std::vector<int>& ids = job.dirtySegments[day];
+        placed.forEachInRange(day * 86400, (day + 1) * 86400, [&](int id) {
+            ids.push_back(id);
+            return true;
+        });
+        // Segments list their orders by id, whichever way they were found.
+        std::sort(ids.begin(), ids.end());
+    }
+    manager.clearDirty();
+    manager.setSegmentStore(dir);
+    return job;
+}
 
+void Persistence::renderSegments(const SegmentJob& job, PendingWrites& writes) {
+    const OrderSnapshot& snapshot = job.snapshot;
+    auto menuById = indexMenu(snapshot.menu());
+
+    writes.clear();
+    for (const auto& entry : job.dirtySegments) {
+        const auto& ids = entry.second;
+        std::ostringstream out;
+        out << "{\n  \"orders\": [\n";
+        for (size_t i = 0; i < ids.size(); ++i) {
+            writeOrder(out, snapshot, *snapshot.find(ids[i]), menuById);
+            if (i + 1 < ids.size()) out << ",";
+            out << "\n";
+        }
+        out << "  ]\n}\n";
+        writes.emplace_back(job.dir + "/" + segmentName(entry.first * 86400), out.str());
+    }
+
+    if (job.menuChanged) {
+        std::ostringstream out;
+        out << "{\n";
+        writeMenu(out, snapshot.menu());
+        out << "  \"version\": 2\n}\n";
+        writes.emplace_back(job.dir + "/menu.json", out.str());
+    }
+
+    // The manifest is small (ids, queue, segment names) and is always written last, so a crash
+    // mid-save leaves the previous manifest pointing at complete segment files.
+    std::ostringstream manifest;
+    manifest << "{\n";
+    manifest << "  \"nextId\": " << snapshot.nextId() << ",\n";
+    manifest << "  \"nextMenuId\": " << snapshot.nextMenuId() << ",\n";
+    writeQueue(manifest, snapshot.queue());
+    manifest << "  \"segments\": [";
+    for (size_t i = 0; i < job.days.size(); ++i) {
+        manifest << "\"" << segmentName(job.days[i] * 86400) << "\"";
+        if (i + 1 < job.days.size()) manifest << ",";
+    }
+    manifest << "],\n";
+    manifest << "  \"version\": 2\n";
+    manifest << "}\n";
+    writes.emplace_back(job.dir + "/manifest.json", manifest.str());
+}
+
+bool Persistence::loadSegments(OrderManager& manager, const std::string& dir) {
+    SegmentFiles files;
+    if (!readSegmentFiles(dir, files)) {
+        return false;
+    }
+    applySegments(manager, dir, files);
     return true;
 }
+
+bool Persistence::readSegmentFiles(const std::string& dir, SegmentFiles& files) {
+    if (!readFile(dir + "/manifest.json", files.manifest)) {
+        return false;
+    }
+    files.menu.clear();
+    readFile(dir + "/menu.json", files.menu);
+    files.segments.clear();
+
+    const std::string& manifest = files.manifest;
+    auto segmentsPos = manifest.find("\"segments\"");
+    if (segmentsPos != std::string::npos) {
+        size_t cursor = manifest.find('[', segmentsPos);
+        size_t end = findClosing(manifest, cursor);
+        while (true) {
+            cursor = manifest.find('"', cursor);
+            if (cursor == std::string::npos || cursor > end) break;
+            std::string name;
+            if (!readQuoted(manifest, cursor, name)) break;
+            std::string content;
+            if (readFile(dir + "/" + name, content)) {
+                files.segments.push_back(std::move(content));
+            }
+        }
+    }
+    return true;
+}
+
+void Persistence::applySegments(OrderManager& manager, const std::string& dir, const SegmentFiles& files) {
+    manager.reset();
+
+    int nextId = 1;
+    extractInt(files.manifest, "nextId", nextId);
+    manager.setNextId(nextId);
+    int nextMenuId = 1;
+    extractInt(files.manifest, "nextMenuId", nextMenuId);
+    manager.setNextMenuId(nextMenuId);
+
+    if (!files.menu.empty()) {
+        loadMenu(manager, files.menu);
+    }
+    auto menuItems = manager.listMenuItems();
+    auto menuById = indexMenu(menuItems);
+    for (const auto& content : files.segments) {
+        loadOrders(manager, content, menuById);
+    }
+    manager.rebuildSchedules(parseIntArray(files.manifest, "queue"));
+    manager.clearDirty();
+    manager.setSegmentStore(dir);
+}
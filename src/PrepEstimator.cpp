@@ -0,0 +1,96 @@
+#include "PrepEstimator.h"
+
+#include <cmath>
+
+size_t PrepEstimator::bucketOf(int load) {
+    if (load <= 2) return load < 0 ? 0 : static_cast<size_t>(load);
+    if (load <= 4) return 3;
+    if (load <= 8) return 4;
+    if (load <= 16) return 5;
+    return 6;
+}
+
+double PrepEstimator::unitMinutes(int itemId, const std::vector<int>& defaults) const {
+    if (itemId <= 0) return 0.0;
+    size_t id = static_cast<size_t>(itemId);
+    if (id < items_.size() && items_[id].samples > 0) return items_[id].meanMinutes;
+    if (id < defaults.size() && defaults[id] > 0) return defaults[id];
+    return 0.0;
+}
+
+void PrepEstimator::observe(const Order& order, const std::vector<int>& defaults, int load) {
+    long long started = TimeUtils::toSeconds(order.startedAt);
+    long long ready = TimeUtils::toSeconds(order.readyAt);
+    if (started <= 0 || ready <= started) return;
+    double actual = static_cast<double>(ready - started) / 60.0;
+
+    double predicted = 0.0;
+    for (const auto& item : order.items) {
+        predicted += unitMinutes(item.itemId, defaults) * item.quantity;
+    }
+    if (predicted <= 0.0) return;
+
+    // Load factor learns actual / base prediction, so it must see the prediction before the
+    // items move towards this observation.
+    if (load >= 0) {
+        size_t b = bucketOf(load);
+        double ratio = actual / predicted;
+        loadRatio_[b] = loadSamples_[b] == 0 ? ratio : loadRatio_[b] + kAlpha * (ratio - loadRatio_[b]);
+        ++loadSamples_[b];
+    }
+
+    // Split the observed time across lines by their share of the prediction, then strip the
+    // load effect so item stats describe an unloaded kitchen.
+    double unloaded = actual / (load >= 0 ? loadFactor(load) : 1.0);
+    for (const auto& item : order.items) {
+        double unit = unitMinutes(item.itemId, defaults);
+        if (unit <= 0.0 || item.quantity <= 0) continue;
+        double observedUnit = unloaded * (unit / predicted);
+        size_t id = static_cast<size_t>(item.itemId);
+        if (id >= items_.size()) items_.resize(id + 1);
+        ItemStats& s = items_[id];
+        if (s.samples == 0) {
+            s.meanMinutes = observedUnit;
+            s.variance = 0.0;
+        } else {
+            double diff = observedUnit - s.meanMinutes;
+            s.meanMinutes += kAlpha * diff;
+            s.variance = (1.0 - kAlpha) * (s.variance + kAlpha * diff * diff);
+        }
+        ++s.samples;
+    }
+}
+
+double PrepEstimator::loadFactor(int load) const {
+    size_t b = bucketOf(load);
+    return loadSamples_[b] == 0 ? 1.0 : loadRatio_[b];
+}
+
+int PrepEstimator::estimateMinutes(const std::vector<OrderItem>& items, const std::vector<int>& defaults, int load) const {
+    double total = 0.0;
+    for (const auto& item : items) {
+        total += unitMinutes(item.itemId, defaults) * item.quantity;
+    }
+    if (total <= 0.0) return 0;
+    return static_cast<int>(std::ceil(total * loadFactor(load)));
+}
+
+double PrepEstimator::unitMinutesP90(int itemId) const {
+    const ItemStats* s = stats(itemId);
+    if (!s) return 0.0;
+    return s->meanMinutes + 1.2816 * std::sqrt(s->variance);
+}
+
+const PrepEstimator::ItemStats* PrepEstimator::stats(int itemId) const {
+    if (itemId <= 0 || static_cast<size_t>(itemId) >= items_.size()) return nullptr;
+    const ItemStats& s = items_[static_cast<size_t>(itemId)];
+    return s.samples > 0 ? &s : nullptr;
+}
+
+void PrepEstimator::clear() {
+    items_.clear();
+    for (size_t i = 0; i < kLoadBuckets; ++i) {
+        loadRatio_[i] = 0.0;
+        loadSamples_[i] = 0;
+    }
+}
@@ -5,7 +5,9 @@ IntQueue::IntQueue(size_t capacity) : data_(capacity + 1, 0) {}
 bool IntQueue::enqueue(int value) {
     size_t nextTail = (tail_ + 1) % data_.size();
     if (nextTail == head_) {
-        return false; // full
+        // A queue built with capacity 0 is full while empty; grow it to at least one slot.
+        reserve(count_ == 0 ? 1 : count_ * 2);
+        nextTail = (tail_ + 1) % data_.size();
     }
     data_[tail_] = value;
     tail_ = nextTail;
@@ -13,6 +15,16 @@ bool IntQueue::enqueue(int value) {
     return true;
 }
 
+bool IntQueue::pushFront(int value) {
+    if ((tail_ + 1) % data_.size() == head_) {
+        reserve(count_ == 0 ? 1 : count_ * 2);
+    }
+    head_ = (head_ + data_.size() - 1) % data_.size();
+    data_[head_] = value;
+    ++count_;
+    return true;
+}
+
 bool IntQueue::dequeue(int& out) {
     if (isEmpty()) {
         return false;
@@ -33,3 +45,19 @@ std::vector<int> IntQueue::snapshot() const {
     }
     return result;
 }
+
+void IntQueue::reserve(size_t capacity) {
+    if (capacity + 1 <= data_.size()) {
+        return;
+    }
+    // Unroll the ring into the front of the new buffer so head_ becomes 0.
+    std::vector<int> grown(capacity + 1, 0);
+    size_t idx = head_;
+    for (size_t i = 0; i < count_; ++i) {
+        grown[i] = data_[idx];
+        idx = (idx + 1) % data_.size();
+    }
+    data_.swap(grown);
+    head_ = 0;
+    tail_ = count_;
+}
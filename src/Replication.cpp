@@ -0,0 +1,408 @@
+#include "Replication.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "OrderManager.h"
+#include "Persistence.h"
+
+namespace {
+    long long steadyNanos() {
+        // CLOCK_MONOTONIC on Linux, shared by every process on the host, so primary and standby
+        // stamps are comparable.
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void putInt(std::string& out, long long value) {
+        out += ' ';
+        out += std::to_string(value);
+    }
+
+    void putString(std::string& out, const std::string& value) {
+        putInt(out, static_cast<long long>(value.size()));
+        out += ':';
+        out += value;
+    }
+
+    void putItems(std::string& out, const std::vector<OrderItem>& items) {
+        putInt(out, static_cast<long long>(items.size()));
+        for (const auto& item : items) {
+            putInt(out, item.itemId);
+            putInt(out, item.quantity);
+            putString(out, item.name);
+        }
+    }
+
+    /** Field reader over a partially received buffer; status is 0 when more bytes are needed, -1 when malformed. */
+    struct Reader {
+        const std::string& text;
+        size_t pos;
+        int status{1};
+
+        bool fail(int code) {
+            status = code;
+            return false;
+        }
+
+        bool integer(long long& out) {
+            if (pos >= text.size()) return fail(0);
+            if (text[pos] != ' ') return fail(-1);
+            size_t p = pos + 1;
+            bool negative = p < text.size() && text[p] == '-';
+            if (negative) ++p;
+            size_t digits = p;
+            long long value = 0;
+            while (p < text.size() && text[p] >= '0' && text[p] <= '9') {
+                value = value * 10 + (text[p] - '0');
+                ++p;
+            }
+            if (p == text.size()) return fail(0);
+            if (p == digits || p - digits > 19) return fail(-1);
+            out = negative ? -value : value;
+            pos = p;
+            return true;
+        }
+
+        bool integer(int& out) {
+            long long value = 0;
+            if (!integer(value)) return false;
+            out = static_cast<int>(value);
+            return true;
+        }
+
+        bool string(std::string& out) {
+            long long length = 0;
+            if (!integer(length)) return false;
+            if (length < 0 || text[pos] != ':') return fail(-1);
+            size_t start = pos + 1;
+            if (start + static_cast<size_t>(length) > text.size()) return fail(0);
+            out.assign(text, start, static_cast<size_t>(length));
+            pos = start + static_cast<size_t>(length);
+            return true;
+        }
+
+        bool items(std::vector<OrderItem>& out) {
+            long long count = 0;
+            if (!integer(count)) return false;
+            if (count < 0) return fail(-1);
+            for (long long i = 0; i < count; ++i) {
+                OrderItem item;
+                if (!integer(item.itemId) || !integer(item.quantity) || !string(item.name)) return false;
+                out.push_back(std::move(item));
+            }
+            return true;
+        }
+
+        bool end() {
+            if (pos >= text.size()) return fail(0);
+            if (text[pos] != '\n') return fail(-1);
+            ++pos;
+            return true;
+        }
+    };
+
+    bool fillAddress(const std::string& path, sockaddr_un& addr) {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) return false;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    int connectTo(const std::string& path) {
+        sockaddr_un addr;
+        if (!fillAddress(path, addr)) return -1;
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+
+void ReplicationLog::created(const Order& order) {
+    std::string body;
+    putInt(body, order.id);
+    putInt(body, TimeUtils::toNanos(order.placedAt));
+    putInt(body, order.isVip ? 1 : 0);
+    putInt(body, order.estimatedPrepMinutes);
+    putString(body, order.customerName);
+    putItems(body, order.items);
+    append('O', body);
+}
+
+void ReplicationLog::edited(const Order& order) {
+    std::string body;
+    putInt(body, order.id);
+    putInt(body, order.isVip ? 1 : 0);
+    putInt(body, order.estimatedPrepMinutes);
+    putString(body, order.customerName);
+    putItems(body, order.items);
+    append('E', body);
+}
+
+void ReplicationLog::staged(int id, int stage, std::chrono::system_clock::time_point at) {
+    std::string body;
+    putInt(body, id);
+    putInt(body, stage);
+    putInt(body, TimeUtils::toNanos(at));
+    append('S', body);
+}
+
+void ReplicationLog::pulled(int id, std::chrono::system_clock::time_point at) {
+    std::string body;
+    putInt(body, id);
+    putInt(body, TimeUtils::toNanos(at));
+    append('K', body);
+}
+
+void ReplicationLog::menuAdded(const MenuItem& item) {
+    std::string body;
+    putInt(body, item.itemId);
+    putInt(body, item.defaultPrepMinutes);
+    putString(body, item.name);
+    append('A', body);
+}
+
+void ReplicationLog::menuRemoved(const std::string& name) {
+    std::string body;
+    putString(body, name);
+    append('R', body);
+}
+
+void ReplicationLog::fullState(const std::string& document) {
+    std::string body;
+    putString(body, document);
+    append('F', body, true);
+}
+
+void ReplicationLog::append(char type, const std::string& body, bool full) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ == State::Idle) return;
+        if (state_ == State::AwaitingFull) {
+            if (!full) return;
+            state_ = State::Streaming;
+        }
+        buffer_ += type;
+        buffer_ += ' ';
+        buffer_ += std::to_string(steadyNanos());
+        buffer_ += body;
+        buffer_ += '\n';
+    }
+    ++records_;
+    ready_.notify_one();
+}
+
+void ReplicationLog::beginResync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.clear();
+    state_ = State::AwaitingFull;
+}
+
+void ReplicationLog::pause() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.clear();
+    state_ = State::Idle;
+}
+
+bool ReplicationLog::take(std::string& out, std::chrono::milliseconds wait) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (buffer_.empty()) ready_.wait_for(lock, wait);
+    if (buffer_.empty()) return false;
+    // Swap buffers: the producer keeps appending into the (cleared) old output string.
+    out.clear();
+    out.swap(buffer_);
+    return true;
+}
+
+void ReplicationLog::wake() {
+    ready_.notify_all();
+}
+
+ReplicationSender::ReplicationSender(ReplicationLog& log, std::string socketPath, std::function<void()> requestResync)
+    : log_(log), path_(std::move(socketPath)), requestResync_(std::move(requestResync)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+ReplicationSender::~ReplicationSender() {
+    stopping_ = true;
+    log_.wake();
+    thread_.join();
+}
+
+void ReplicationSender::run() {
+    int fd = -1;
+    std::string chunk;
+    while (true) {
+        bool stopping = stopping_.load();
+        if (fd < 0) {
+            if (stopping) break;
+            fd = connectTo(path_);
+            if (fd < 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+                continue;
+            }
+            log_.beginResync();
+            connected_ = true;
+            requestResync_();
+        }
+        // After a stop request, drain whatever is left and then close.
+        if (!log_.take(chunk, std::chrono::milliseconds(stopping ? 0 : 100))) {
+            if (stopping) break;
+            continue;
+        }
+        if (!sendAll(fd, chunk)) {
+            log_.pause();
+            connected_ = false;
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (fd >= 0) ::close(fd);
+    connected_ = false;
+}
+
+bool ReplicaApplier::feed(const char* data, size_t size) {
+    pending_.append(data, size);
+    size_t pos = 0;
+    while (true) {
+        int result = applyOne(pos);
+        if (result < 0) return false;
+        if (result == 0) break;
+    }
+    pending_.erase(0, pos);
+    return true;
+}
+
+int ReplicaApplier::applyOne(size_t& pos) {
+    if (pos >= pending_.size()) return 0;
+    char type = pending_[pos];
+    Reader in{pending_, pos + 1};
+    long long logged = 0;
+    if (!in.integer(logged)) return in.status;
+
+    bool ok = false;
+    switch (type) {
+        case 'O': {
+            int id = 0, vip = 0, estimate = 0;
+            long long at = 0;
+            std::string name;
+            std::vector<OrderItem> items;
+            if (!in.integer(id) || !in.integer(at) || !in.integer(vip) || !in.integer(estimate) || !in.string(name) || !in.items(items) || !in.end()) {
+                return in.status;
+            }
+            manager_.setNextId(id);
+            ok = manager_.runAt(TimeUtils::fromNanos(at), [&] {
+                return manager_.createOrder(std::move(name), vip != 0, std::move(items), estimate) > 0;
+            });
+            break;
+        }
+        case 'E': {
+            int id = 0, vip = 0, estimate = 0;
+            std::string name;
+            std::vector<OrderItem> items;
+            if (!in.integer(id) || !in.integer(vip) || !in.integer(estimate) || !in.string(name) || !in.items(items) || !in.end()) {
+                return in.status;
+            }
+            ok = manager_.editOrder(id, std::move(name), vip != 0, std::move(items), estimate);
+            break;
+        }
+        case 'S': {
+            int id = 0, stage = 0;
+            long long at = 0;
+            if (!in.integer(id) || !in.integer(stage) || !in.integer(at) || !in.end()) return in.status;
+            ok = manager_.runAt(TimeUtils::fromNanos(at), [&] { return manager_.advanceOrder(id, stage); });
+            break;
+        }
+        case 'K': {
+            int id = 0;
+            long long at = 0;
+            if (!in.integer(id) || !in.integer(at) || !in.end()) return in.status;
+            // The logged id is applied as is: replaying the standby's own pick would move the
+            // wrong order if its queue had drifted from the primary's.
+            ok = manager_.runAt(TimeUtils::fromNanos(at), [&] { return manager_.applyKitchenPull(id); });
+            break;
+        }
+        case 'A': {
+            int id = 0, prep = 0;
+            std::string name;
+            if (!in.integer(id) || !in.integer(prep) || !in.string(name) || !in.end()) return in.status;
+            ok = manager_.addMenuItem(name, prep, id) > 0;
+            break;
+        }
+        case 'R': {
+            std::string name;
+            if (!in.string(name) || !in.end()) return in.status;
+            ok = manager_.removeMenuItem(name);
+            break;
+        }
+        case 'F': {
+            std::string document;
+            if (!in.string(document) || !in.end()) return in.status;
+            Persistence::applyState(manager_, document);
+            ok = true;
+            break;
+        }
+        default:
+            return -1;
+    }
+
+    pos = in.pos;
+    ++stats_.records;
+    if (!ok) ++stats_.failed;
+    long long lag = steadyNanos() - logged;
+    stats_.lagTotalNanos += lag;
+    if (lag > stats_.lagMaxNanos) stats_.lagMaxNanos = lag;
+    if (stats_.lagSamples) stats_.lagSamples->push_back(lag);
+    return 1;
+}
+
+bool Replication::runStandby(OrderManager& manager, const std::string& socketPath, ReplicaStats& stats) {
+    sockaddr_un addr;
+    if (!fillAddress(socketPath, addr)) return false;
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    ::unlink(socketPath.c_str());
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listener, 1) != 0) {
+        ::close(listener);
+        return false;
+    }
+    int fd = -1;
+    do {
+        fd = ::accept(listener, nullptr, nullptr);
+    } while (fd < 0 && errno == EINTR);
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    if (fd < 0) return false;
+
+    ReplicaApplier applier(manager, stats);
+    char buffer[64 * 1024];
+    bool ok = true;
+    while (true) {
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (!applier.feed(buffer, static_cast<size_t>(n))) {
+            ok = false;
+            break;
+        }
+    }
+    ::close(fd);
+    return ok;
+}
@@ -0,0 +1,182 @@
+#include "ShardedManager.h"
+
+#include <filesystem>
+#include "Persistence.h"
+
+namespace {
+    bool fail(std::string* error, const std::string& what) {
+        if (error) *error = what;
+        return false;
+    }
+}
+
+bool ShardedManager::open(const std::vector<std::string>& branches, std::string* error) {
+    if (!shards_.empty()) return fail(error, "branches are already open");
+    if (branches.empty()) return fail(error, "no branches given");
+    // Ids keep the branch in kShardBits bits; a further branch would alias the first ones.
+    if (branches.size() > kMaxShards) return fail(error, "at most " + std::to_string(kMaxShards) + " branches");
+    for (size_t i = 0; i < branches.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            if (branches[i] == branches[j]) return fail(error, "duplicate branch " + branches[i]);
+        }
+    }
+    for (const std::string& name : branches) {
+        auto shard = std::make_unique<Shard>();
+        shard->name = name;
+        shard->manager.setClock(clock_);
+        Shard* s = shard.get();
+        shard->thread = std::thread([s] { s->loop.run(); });
+        shards_.push_back(std::move(shard));
+    }
+    return true;
+}
+
+ShardedManager::~ShardedManager() {
+    for (auto& shard : shards_) {
+        // Drain what callers already posted, then stop the loop from its own thread.
+        Shard* s = shard.get();
+        s->loop.post([s] { s->loop.stop(); });
+    }
+    for (auto& shard : shards_) {
+        shard->thread.join();
+    }
+}
+
+int ShardedManager::shardOf(const std::string& branch) const {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        if (shards_[i]->name == branch) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int ShardedManager::createOrder(size_t shard, std::string customerName, bool isVip, std::vector<OrderItem> items, int estimatedPrepMinutes) {
+    if (shard >= shards_.size()) return 0;
+    int local = call(shard, [name = std::move(customerName), isVip, items = std::move(items), estimatedPrepMinutes](OrderManager& m) mutable {
+        return m.createOrder(std::move(name), isVip, std::move(items), estimatedPrepMinutes);
+    }).get();
+    return globalId(shard, local);
+}
+
+template <typename Fn>
+bool ShardedManager::route(int globalId, Fn fn) {
+    size_t shard = shardOfId(globalId);
+    if (globalId <= 0 || shard >= shards_.size()) return false;
+    int local = localId(globalId);
+    return call(shard, [fn, local](OrderManager& m) { return fn(m, local); }).get();
+}
+
+bool ShardedManager::startOrder(int globalId) {
+    return route(globalId, [](OrderManager& m, int id) { return m.startOrder(id); });
+}
+
+bool ShardedManager::readyOrder(int globalId) {
+    return route(globalId, [](OrderManager& m, int id) { return m.readyOrder(id); });
+}
+
+bool ShardedManager::serveOrder(int globalId) {
+    return route(globalId, [](OrderManager& m, int id) { return m.serveOrder(id); });
+}
+
+bool ShardedManager::cancelOrder(int globalId) {
+    return route(globalId, [](OrderManager& m, int id) { return m.cancelOrder(id); });
+}
+
+bool ShardedManager::getOrder(int globalId, Order& out) {
+    return route(globalId, [&out, globalId](OrderManager& m, int id) {
+        Order* o = m.getOrder(id);
+        if (!o) return false;
+        out = *o;
+        out.id = globalId;
+        return true;
+    });
+}
+
+std::vector<Order> ShardedManager::listAll(const ListQuery& query) {
+    ListQuery local = query;
+    local.afterId = 0;
+
+    // Scatter: every branch sorts and truncates its own slice in parallel.
+    std::vector<std::future<std::vector<Order>>> pending;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        pending.push_back(call(i, [local](OrderManager& m) { return m.listPage(local); }));
+    }
+    std::vector<std::vector<Order>> parts;
+    size_t total = 0;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        parts.push_back(pending[i].get());
+        for (auto& o : parts.back()) o.id = globalId(i, o.id);
+        total += parts.back().size();
+    }
+
+    // Gather: k-way merge of the sorted parts; k is at most kMaxShards, so a linear pick per row
+    // beats a heap.
+    auto key = [&](const Order& o) { return TimeUtils::toSeconds(query.byServed ? o.servedAt : o.placedAt); };
+    auto before = [&](const Order& a, const Order& b) {
+        long long ka = key(a);
+        long long kb = key(b);
+        if (ka != kb) return query.newestFirst ? ka > kb : ka < kb;
+        return query.newestFirst ? a.id > b.id : a.id < b.id;
+    };
+    size_t wanted = query.limit > 0 && query.limit < total ? query.limit : total;
+    std::vector<Order> merged;
+    merged.reserve(wanted);
+    std::vector<size_t> cursor(parts.size(), 0);
+    while (merged.size() < wanted) {
+        size_t best = parts.size();
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (cursor[i] == parts[i].size()) continue;
+            if (best == parts.size() || before(parts[i][cursor[i]], parts[best][cursor[best]])) best = i;
+        }
+        merged.push_back(std::move(parts[best][cursor[best]++]));
+    }
+    return merged;
+}
+
+std::vector<BranchStats> ShardedManager::stats() {
+    std::vector<std::future<BranchStats>> pending;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        pending.push_back(call(i, [name = shards_[i]->name](OrderManager& m) {
+            BranchStats s;
+            s.branch = name;
+            s.backlogMinutes = m.backlogMinutes();
+            long long servedSeconds = 0;
+            m.registry().forEach([&](const Order& o) {
+                ++s.byStatus[static_cast<size_t>(o.status)];
+                if (o.status == OrderStatus::Served && o.servedAt > o.placedAt) {
+                    servedSeconds += TimeUtils::toSeconds(o.servedAt) - TimeUtils::toSeconds(o.placedAt);
+                    ++s.servedCount;
+                }
+            });
+            if (s.servedCount > 0) s.avgServeMinutes = static_cast<double>(servedSeconds) / 60.0 / static_cast<double>(s.servedCount);
+            return s;
+        }));
+    }
+    std::vector<BranchStats> result;
+    for (auto& f : pending) result.push_back(f.get());
+    return result;
+}
+
+bool ShardedManager::saveAll(const std::string& dir) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) return false;
+    std::vector<std::future<bool>> pending;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        std::string path = dir + "/" + shards_[i]->name + ".json";
+        pending.push_back(call(i, [path](OrderManager& m) { return Persistence::saveState(m, path); }));
+    }
+    bool ok = true;
+    for (auto& f : pending) ok = f.get() && ok;
+    return ok;
+}
+
+bool ShardedManager::loadAll(const std::string& dir) {
+    std::vector<std::future<bool>> pending;
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        std::string path = dir + "/" + shards_[i]->name + ".json";
+        pending.push_back(call(i, [path](OrderManager& m) { return Persistence::loadState(m, path); }));
+    }
+    bool ok = true;
+    for (auto& f : pending) ok = f.get() && ok;
+    return ok;
+}
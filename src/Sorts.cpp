@@ -6,7 +6,8 @@ namespace {
         int j = mid + 1;
         int k = left;
         while (i <= mid && j <= right) {
-            if (cmp(items[i], items[j])) {
+            // Take from the left run unless the right element is strictly smaller: keeps ties stable.
+            if (!cmp(items[j], items[i])) {
                 buffer[k++] = items[i++];
             } else {
                 buffer[k++] = items[j++];
@@ -76,3 +77,7 @@ void Sorts::mergeSort(std::vector<Order>& items, const std::function<bool(const
     std::vector<Order> buffer(items.size());
     mergeSortInternal(items, buffer, 0, static_cast<int>(items.size()) - 1, cmp);
 }
+
+void Sorts::parallelMergeSort(std::vector<Order>& items, const std::function<bool(const Order&, const Order&)>& cmp, unsigned threads) {
+    parallelMergeSort<Order>(items, std::cref(cmp), threads, kParallelCutoff);
+}
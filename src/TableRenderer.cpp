@@ -0,0 +1,219 @@
+#include "TableRenderer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace {
+/** Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's algorithm). */
+long long daysFromCivil(long long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+void civilFromDays(long long z, long long& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const long long era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<long long>(yoe) + era * 400 + (m <= 2);
+}
+
+long long floorDiv(long long a, long long b) {
+    long long q = a / b;
+    if ((a % b != 0) && ((a < 0) != (b < 0))) --q;
+    return q;
+}
+
+void put2(char* out, unsigned v) {
+    out[0] = static_cast<char>('0' + v / 10 % 10);
+    out[1] = static_cast<char>('0' + v % 10);
+}
+
+void appendPadded(std::string& out, const char* text, size_t len, size_t width) {
+    out.append(text, len);
+    if (len < width) out.append(width - len, ' ');
+}
+
+void appendPadded(std::string& out, const char* text, size_t width) {
+    appendPadded(out, text, std::strlen(text), width);
+}
+
+void appendInt(std::string& out, long long value, size_t width) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    bool negative = value < 0;
+    unsigned long long v = negative ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    do {
+        *--p = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (negative) *--p = '-';
+    appendPadded(out, p, static_cast<size_t>(end - p), width);
+}
+
+/** Seconds east of UTC at the given instant, via one std::localtime call. */
+long long localOffsetAt(long long seconds) {
+    std::time_t tt = static_cast<std::time_t>(seconds);
+    std::tm* tm = std::localtime(&tt);
+    if (!tm) return 0;
+    long long local = daysFromCivil(tm->tm_year + 1900LL, static_cast<unsigned>(tm->tm_mon + 1), static_cast<unsigned>(tm->tm_mday)) * 86400
+                    + tm->tm_hour * 3600LL + tm->tm_min * 60LL + tm->tm_sec;
+    return local - seconds;
+}
+}
+
+void TimestampCache::fillBlock(OffsetBlock& slot, long long block) const {
+    const long long first = block * kBlockDays * 86400;
+    slot.block = block;
+    slot.transitions.clear();
+    slot.initial = localOffsetAt(first);
+    long long current = slot.initial;
+    for (long long day = 0; day < kBlockDays; ++day) {
+        long long end = first + (day + 1) * 86400;
+        long long next = localOffsetAt(end);
+        // A day whose offset changes is bisected down to the second it switches, so shifts of
+        // any size and at any minute (Lord Howe moves by 30 minutes) land exactly.
+        long long from = first + day * 86400;
+        while (next != current) {
+            long long lo = from;
+            long long hi = end;
+            while (hi - lo > 1) {
+                long long mid = lo + (hi - lo) / 2;
+                if (localOffsetAt(mid) == current) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            current = localOffsetAt(hi);
+            slot.transitions.push_back(Transition{hi, current});
+            from = hi;
+        }
+    }
+}
+
+long long TimestampCache::utcOffset(long long seconds) {
+    long long block = floorDiv(seconds, kBlockDays * 86400);
+    OffsetBlock& slot = offsets_[static_cast<size_t>(block) % offsets_.size()];
+    if (slot.block != block) {
+        fillBlock(slot, block);
+    }
+    // A couple of transitions a year at most; a linear walk beats a search.
+    long long offset = slot.initial;
+    for (const Transition& t : slot.transitions) {
+        if (t.at > seconds) break;
+        offset = t.offset;
+    }
+    return offset;
+}
+
+void TimestampCache::render(long long localSeconds, char* out) const {
+    long long days = floorDiv(localSeconds, 86400);
+    long long secOfDay = localSeconds - days * 86400;
+    long long y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    civilFromDays(days, y, m, d);
+    unsigned h24 = static_cast<unsigned>(secOfDay / 3600);
+    unsigned minute = static_cast<unsigned>(secOfDay / 60 % 60);
+    unsigned h12 = h24 % 12 == 0 ? 12 : h24 % 12;
+
+    // Same layout as "%d/%m/%Y %I:%M %p", lowercased.
+    put2(out, d);
+    out[2] = '/';
+    put2(out + 3, m);
+    out[5] = '/';
+    unsigned year = static_cast<unsigned>(y < 0 ? 0 : y % 10000);
+    put2(out + 6, year / 100);
+    put2(out + 8, year % 100);
+    out[10] = ' ';
+    put2(out + 11, h12);
+    out[13] = ':';
+    put2(out + 14, minute);
+    out[16] = ' ';
+    out[17] = h24 < 12 ? 'a' : 'p';
+    out[18] = 'm';
+}
+
+size_t TimestampCache::format(long long seconds, char* out) {
+    if (seconds <= 0) {
+        out[0] = '-';
+        return 1;
+    }
+    long long minute = floorDiv(seconds, 60);
+    MinuteSlot& slot = minutes_[static_cast<size_t>(minute) % minutes_.size()];
+    if (slot.minute != minute) {
+        render(minute * 60 + utcOffset(seconds), slot.text.data());
+        slot.minute = minute;
+    }
+    std::memcpy(out, slot.text.data(), kWidth);
+    return kWidth;
+}
+
+void TimeFormat::isoUtc(long long seconds, char* out) {
+    long long days = floorDiv(seconds, 86400);
+    long long secOfDay = seconds - days * 86400;
+    long long y = 0;
+    unsigned m = 0;
+    unsigned d = 0;
+    civilFromDays(days, y, m, d);
+    unsigned year = static_cast<unsigned>(y < 0 ? 0 : y % 10000);
+    put2(out, year / 100);
+    put2(out + 2, year % 100);
+    out[4] = '-';
+    put2(out + 5, m);
+    out[7] = '-';
+    put2(out + 8, d);
+    out[10] = 'T';
+    put2(out + 11, static_cast<unsigned>(secOfDay / 3600));
+    out[13] = ':';
+    put2(out + 14, static_cast<unsigned>(secOfDay / 60 % 60));
+    out[16] = ':';
+    put2(out + 17, static_cast<unsigned>(secOfDay % 60));
+    out[19] = 'Z';
+}
+
+void TableRenderer::appendTime(std::string& out, long long seconds, size_t width) {
+    char buf[TimestampCache::kWidth];
+    size_t len = timestamps_.format(seconds, buf);
+    appendPadded(out, buf, len, width);
+}
+
+void TableRenderer::renderOrders(const std::vector<Order>& orders, std::string& out) {
+    out.reserve(out.size() + (orders.size() + 2) * 124);
+    appendPadded(out, "ID", 5);
+    appendPadded(out, "Customer", 14);
+    appendPadded(out, "VIP", 5);
+    appendPadded(out, "Status", 10);
+    appendPadded(out, "Est", 8);
+    appendPadded(out, "Placed", 20);
+    appendPadded(out, "Started", 20);
+    appendPadded(out, "Ready", 20);
+    appendPadded(out, "Served", 20);
+    out.push_back('\n');
+    out.append(122, '-');
+    out.push_back('\n');
+
+    for (const auto& o : orders) {
+        appendInt(out, o.id, 5);
+        appendPadded(out, o.customerName.data(), std::min<size_t>(o.customerName.size(), 13), 14);
+        appendPadded(out, o.isVip ? "yes" : "no", 5);
+        appendPadded(out, OrderStatusStrings::name(o.status), 10);
+        appendInt(out, o.estimatedPrepMinutes, 8);
+        appendTime(out, TimeUtils::toSeconds(o.placedAt), 20);
+        appendTime(out, TimeUtils::toSeconds(o.startedAt), 20);
+        appendTime(out, TimeUtils::toSeconds(o.readyAt), 20);
+        appendTime(out, TimeUtils::toSeconds(o.servedAt), 20);
+        out.push_back('\n');
+    }
+}
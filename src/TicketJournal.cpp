@@ -0,0 +1,319 @@
+#include "TicketJournal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "OrderManager.h"
+
+/** First 64 bytes of the file; the ring follows. */
+struct TicketJournal::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t capacity;
+    uint64_t checkpoint;
+    uint64_t overflows;
+    char reserved[24];
+};
+
+namespace {
+    const char kMagic[8] = {'T', 'K', 'T', 'J', 'R', 'N', 'L', '1'};
+    constexpr uint32_t kVersion = 1;
+    constexpr size_t kHeaderSize = 64;
+
+    bool fail(std::string* error, const std::string& what) {
+        if (error) *error = what + ": " + std::strerror(errno);
+        return false;
+    }
+}
+
+TicketJournal::~TicketJournal() {
+    close();
+}
+
+bool TicketJournal::open(const std::string& path, size_t capacity, std::string* error) {
+    static_assert(sizeof(Header) == kHeaderSize, "journal header is 64 bytes");
+    close();
+    if (capacity == 0) capacity = kDefaultCapacity;
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return fail(error, "cannot open " + path);
+    size_t size = kHeaderSize + capacity * sizeof(TicketRecord);
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return fail(error, "cannot stat " + path);
+    }
+
+    bool fresh = static_cast<size_t>(st.st_size) != size;
+    if (!fresh) {
+        Header existing{};
+        fresh = pread(fd, &existing, sizeof(existing), 0) != static_cast<ssize_t>(sizeof(existing))
+             || std::memcmp(existing.magic, kMagic, sizeof(kMagic)) != 0 || existing.version != kVersion
+             || existing.recordSize != sizeof(TicketRecord) || existing.capacity != capacity;
+    }
+    // Truncating to zero first makes the whole ring read back as empty slots.
+    if (fresh && (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(size)) != 0)) {
+        ::close(fd);
+        return fail(error, "cannot size " + path);
+    }
+    // Populated up front: recovery reads every slot, and one bulk fault beats one per page.
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd);
+        return fail(error, "cannot map " + path);
+    }
+
+    fd_ = fd;
+    map_ = map;
+    mapSize_ = size;
+    header_ = static_cast<Header*>(map);
+    slots_ = reinterpret_cast<TicketRecord*>(static_cast<char*>(map) + kHeaderSize);
+    capacity_ = capacity;
+    if (fresh) {
+        std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+        header_->version = kVersion;
+        header_->recordSize = sizeof(TicketRecord);
+        header_->capacity = capacity;
+        header_->checkpoint = 0;
+        header_->overflows = 0;
+        msync(map_, kHeaderSize, MS_SYNC);
+    }
+    scan();
+    return true;
+}
+
+void TicketJournal::close() {
+    if (map_) {
+        msync(map_, mapSize_, MS_SYNC);
+        munmap(map_, mapSize_);
+    }
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    map_ = nullptr;
+    header_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0;
+    latest_.clear();
+}
+
+uint8_t TicketJournal::checksum(const TicketRecord& record) {
+    TicketRecord copy = record;
+    copy.check = 0;
+    uint64_t words[sizeof(TicketRecord) / 8];
+    std::memcpy(words, &copy, sizeof(copy));
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (uint64_t w : words) hash = (hash ^ w) * 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 32;
+    hash ^= hash >> 16;
+    hash ^= hash >> 8;
+    // Never 0, so an all-zero slot cannot pass as a record.
+    uint8_t folded = static_cast<uint8_t>(hash);
+    return folded ? folded : 1;
+}
+
+void TicketJournal::scan() {
+    latest_.clear();
+    head_ = 0;
+    nextSequence_ = 1;
+    nextRank_ = 1;
+    latest_.reserve(capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+        const TicketRecord& slot = slots_[i];
+        if (slot.sequence == 0 || slot.check != checksum(slot)) continue;
+        if (slot.sequence >= nextSequence_) {
+            nextSequence_ = slot.sequence + 1;
+            head_ = (i + 1) % capacity_;
+        }
+        if (slot.isWaiting()) nextRank_ = std::max(nextRank_, slot.value + 1);
+        Tracked& t = latest_[slot.orderId];
+        if (slot.sequence > t.sequence) t = Tracked{slot.sequence, slot.isWaiting() ? slot.value : 0, slot.isLive()};
+    }
+}
+
+void TicketJournal::recover(KitchenState& out) const {
+    out = KitchenState{};
+    if (!slots_) return;
+    out.checkpoint = header_->checkpoint;
+    out.overflows = header_->overflows;
+    // Valid slots, then the latest per order: ids in the ring are recent, so a table indexed by
+    // id - minId is small; sorting (id, sequence) covers the rare wide spread.
+    std::vector<const TicketRecord*> valid;
+    valid.reserve(capacity_);
+    int minId = 0;
+    int maxId = 0;
+    for (size_t i = 0; i < capacity_; ++i) {
+        const TicketRecord& slot = slots_[i];
+        if (slot.sequence == 0 || slot.check != checksum(slot)) continue;
+        if (valid.empty() || slot.orderId < minId) minId = slot.orderId;
+        if (valid.empty() || slot.orderId > maxId) maxId = slot.orderId;
+        valid.push_back(&slot);
+    }
+    if (valid.empty()) return;
+    size_t span = static_cast<size_t>(static_cast<int64_t>(maxId) - minId) + 1;
+    if (span <= 8 * capacity_) {
+        std::vector<const TicketRecord*> byId(span, nullptr);
+        for (const TicketRecord* slot : valid) {
+            const TicketRecord*& best = byId[static_cast<size_t>(slot->orderId - minId)];
+            if (!best || slot->sequence > best->sequence) best = slot;
+        }
+        for (const TicketRecord* slot : byId) {
+            if (slot) out.tickets.push_back(*slot);
+        }
+    } else {
+        std::sort(valid.begin(), valid.end(), [](const TicketRecord* a, const TicketRecord* b) {
+            return a->orderId != b->orderId ? a->orderId < b->orderId : a->sequence < b->sequence;
+        });
+        for (size_t i = 0; i < valid.size(); ++i) {
+            if (i + 1 == valid.size() || valid[i + 1]->orderId != valid[i]->orderId) out.tickets.push_back(*valid[i]);
+        }
+    }
+
+    std::vector<std::pair<int64_t, int>> ranked;
+    for (const TicketRecord& t : out.tickets) {
+        if (t.isWaiting()) {
+            if (t.isVip()) {
+                ++out.waitingVips;
+            } else {
+                ranked.emplace_back(t.value, t.orderId);
+            }
+        } else if (t.isLive()) {
+            ++out.inFlight;
+        }
+    }
+    std::sort(ranked.begin(), ranked.end());
+    out.queue.reserve(ranked.size());
+    for (const auto& r : ranked) out.queue.push_back(r.second);
+}
+
+bool TicketJournal::keeps(const TicketRecord& slot) {
+    if (slot.sequence == 0) return false;
+    auto it = latest_.find(slot.orderId);
+    if (it == latest_.end() || it->second.sequence != slot.sequence) return false;
+    if (it->second.live) return true;
+    // A finished order's last record goes; recovery misses its outcome unless a save has it.
+    if (slot.sequence > header_->checkpoint) ++header_->overflows;
+    latest_.erase(it);
+    return false;
+}
+
+void TicketJournal::write(TicketRecord& slot, const TicketRecord& record, uint64_t sequence) {
+    // Plain stores: the page is the kernel's, so a process crash cannot lose them.
+    slot = record;
+    slot.sequence = sequence;
+    slot.check = 0;
+    slot.check = checksum(slot);
+    if (++sinceSync_ >= kSyncEvery) {
+        sinceSync_ = 0;
+        msync(map_, mapSize_, MS_ASYNC);
+    }
+}
+
+void TicketJournal::record(const Order& order, std::chrono::system_clock::time_point at) {
+    if (!slots_) return;
+    TicketRecord next;
+    next.orderId = order.id;
+    next.stage = static_cast<int16_t>(WorkflowEngine::stageOf(order));
+    next.flags = static_cast<uint8_t>((order.isVip ? TicketRecord::kVip : 0) | (static_cast<unsigned>(order.status) << 1));
+    next.placedAtNanos = TimeUtils::toNanos(order.placedAt);
+
+    Tracked& tracked = latest_[order.id];
+    int64_t rank = 0;
+    if (next.isWaiting()) {
+        // An order keeps its queue position while it waits: the queue entry it was given first is
+        // the one the kitchen reaches first, even after a VIP round trip. VIPs get no entry.
+        rank = tracked.rank || order.isVip ? tracked.rank : nextRank_++;
+        next.value = rank;
+    } else {
+        switch (order.status) {
+            case OrderStatus::Prepping: at = order.startedAt; break;
+            case OrderStatus::Ready: at = order.readyAt; break;
+            case OrderStatus::Served: at = order.servedAt; break;
+            default: break;
+        }
+        next.value = TimeUtils::toNanos(at);
+    }
+    // The order's previous record is superseded, so it need not be carried forward.
+    tracked.sequence = 0;
+
+    for (size_t tries = 0;; ++tries) {
+        TicketRecord& slot = slots_[head_];
+        head_ = (head_ + 1) % capacity_;
+        if (tries < capacity_ && keeps(slot)) {
+            // Still the latest record of its order: re-stamp it in place and keep looking.
+            uint64_t sequence = nextSequence_++;
+            latest_[slot.orderId].sequence = sequence;
+            write(slot, slot, sequence);
+            continue;
+        }
+        if (tries >= capacity_) {
+            // More live orders than slots: drop the oldest one's record.
+            ++header_->overflows;
+            latest_.erase(slot.orderId);
+        }
+        uint64_t sequence = nextSequence_++;
+        write(slot, next, sequence);
+        latest_[order.id] = Tracked{sequence, rank, next.isLive()};
+        return;
+    }
+}
+
+void TicketJournal::checkpoint(uint64_t sequence) {
+    if (!slots_ || sequence <= header_->checkpoint) return;
+    header_->checkpoint = sequence;
+    for (auto it = latest_.begin(); it != latest_.end();) {
+        if (!it->second.live && it->second.sequence <= sequence) {
+            it = latest_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TicketJournal::writeBaseline(OrderManager& manager) {
+    auto waiting = [](const Order& o) { return o.status == OrderStatus::Placed || o.status == OrderStatus::Queued; };
+    auto at = manager.now();
+    // Normal orders go first, in queue order, so their ranks reproduce the queue.
+    std::vector<bool> done;
+    for (int id : manager.normalQueue().snapshot()) {
+        const Order* o = manager.getOrder(id);
+        if (!o || o->isVip || !waiting(*o)) continue;
+        if (done.size() <= static_cast<size_t>(id)) done.resize(static_cast<size_t>(id) + 1, false);
+        if (done[static_cast<size_t>(id)]) continue;
+        done[static_cast<size_t>(id)] = true;
+        record(*o, at);
+    }
+    manager.registry().forEach([&](const Order& o) {
+        bool recorded = static_cast<size_t>(o.id) < done.size() && done[static_cast<size_t>(o.id)];
+        if (!recorded && o.status != OrderStatus::Served && o.status != OrderStatus::Cancelled) record(o, at);
+    });
+}
+
+void TicketJournal::attach(OrderManager& manager) {
+    writeBaseline(manager);
+    flush();
+    manager.setTicketJournal(this);
+}
+
+void TicketJournal::rebase(OrderManager& manager) {
+    if (!slots_) return;
+    std::memset(static_cast<void*>(slots_), 0, capacity_ * sizeof(TicketRecord));
+    header_->checkpoint = 0;
+    header_->overflows = 0;
+    latest_.clear();
+    head_ = 0;
+    writeBaseline(manager);
+    flush();
+}
+
+bool TicketJournal::flush() {
+    sinceSync_ = 0;
+    return map_ && msync(map_, mapSize_, MS_SYNC) == 0;
+}
+
+uint64_t TicketJournal::overflows() const {
+    return header_ ? header_->overflows : 0;
+}
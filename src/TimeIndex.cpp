@@ -0,0 +1,47 @@
+#include "TimeIndex.h"
+
+#include <algorithm>
+
+void TimeIndex::insert(long long seconds, int id) {
+    Entry e{seconds, id};
+    if (sorted_ && !entries_.empty() && before(e, entries_.back())) {
+        sorted_ = false;
+    }
+    entries_.push_back(e);
+}
+
+bool TimeIndex::erase(long long seconds, int id) {
+    ensureSorted();
+    Entry key{seconds, id};
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), key, before);
+    if (it == entries_.end() || it->seconds != seconds || it->id != id) {
+        return false;
+    }
+    entries_.erase(it);
+    return true;
+}
+
+void TimeIndex::clear() {
+    entries_.clear();
+    sorted_ = true;
+}
+
+void TimeIndex::ensureSorted() const {
+    if (sorted_) return;
+    std::sort(entries_.begin(), entries_.end(), before);
+    sorted_ = true;
+}
+
+size_t TimeIndex::lowerBound(long long value) const {
+    size_t lo = 0;
+    size_t hi = entries_.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entries_[mid].seconds < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
@@ -0,0 +1,192 @@
+#include "WorkflowEngine.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+WorkflowEngine::WorkflowEngine() {
+    resetToStandard();
+}
+
+void WorkflowEngine::resetToStandard() {
+    // Same BFS as compile(), already run at compile time (and checked by WorkflowGraph.cpp's
+    // static_asserts), so the standard graph is a copy of the constexpr tables.
+    constexpr size_t n = WorkflowGraph::kStates;
+    const auto& tables = WorkflowGraph::tables();
+    states_.clear();
+    adjacency_.clear();
+    for (size_t s = 0; s < n; ++s) {
+        OrderStatus status = static_cast<OrderStatus>(s);
+        addState(OrderStatusStrings::toString(status), status);
+    }
+    nextHop_.assign(n * n, -1);
+    for (size_t from = 0; from < n; ++from) {
+        for (size_t to = 0; to < n; ++to) {
+            adjacency_[from].set(to, tables.allowed[from][to]);
+            nextHop_[from * n + to] = tables.nextHop[from][to];
+        }
+    }
+    hooks_.assign(n, {});
+}
+
+int WorkflowEngine::addState(const std::string& name, OrderStatus base) {
+    states_.push_back(StateInfo{name, base});
+    adjacency_.emplace_back();
+    return static_cast<int>(states_.size()) - 1;
+}
+
+int WorkflowEngine::stateId(const std::string& name) const {
+    for (size_t i = 0; i < states_.size(); ++i) {
+        if (states_[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool WorkflowEngine::loadConfig(const std::string& path, std::string& error) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return parseConfig(buffer.str(), error);
+}
+
+bool WorkflowEngine::parseConfig(const std::string& text, std::string& error) {
+    WorkflowEngine next;
+    std::istringstream lines(text);
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(lines, line)) {
+        ++lineNo;
+        auto hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream words(line);
+        std::string directive, a, b;
+        if (!(words >> directive)) continue;
+        words >> a >> b;
+        auto fail = [&](const std::string& why) {
+            error = "line " + std::to_string(lineNo) + ": " + why;
+            return false;
+        };
+        if (a.empty() || b.empty()) return fail("expected '" + directive + " <A> <B>'");
+        if (directive == "state") {
+            OrderStatus base;
+            if (next.stateId(a) >= 0) return fail("duplicate state " + a);
+            if (!OrderStatusStrings::fromString(b, base)) return fail("unknown base status " + b);
+            if (next.states_.size() >= kMaxStates) return fail("too many states");
+            next.addState(a, base);
+        } else if (directive == "edge" || directive == "remove") {
+            int from = next.stateId(a);
+            int to = next.stateId(b);
+            if (from < 0 || to < 0) return fail("unknown state in " + a + " -> " + b);
+            next.adjacency_[static_cast<size_t>(from)].set(static_cast<size_t>(to), directive == "edge");
+        } else {
+            return fail("unknown directive " + directive);
+        }
+    }
+    next.compile();
+    *this = std::move(next);
+    return true;
+}
+
+void WorkflowEngine::compile() {
+    const size_t n = states_.size();
+    nextHop_.assign(n * n, -1);
+    hooks_.assign(n, {});
+    std::vector<int> prev(n);
+    std::vector<size_t> queue(n);
+    for (size_t src = 0; src < n; ++src) {
+        std::fill(prev.begin(), prev.end(), -1);
+        StateSet visited;
+        visited.set(src);
+        size_t head = 0;
+        size_t tail = 0;
+        queue[tail++] = src;
+        while (head < tail) {
+            size_t u = queue[head++];
+            StateSet fresh = adjacency_[u] & ~visited;
+            for (size_t v = 0; v < n; ++v) {
+                if (!fresh.test(v)) continue;
+                visited.set(v);
+                prev[v] = static_cast<int>(u);
+                queue[tail++] = v;
+            }
+        }
+        nextHop_[src * n + src] = static_cast<int>(src);
+        for (size_t dst = 0; dst < n; ++dst) {
+            if (dst == src || !visited.test(dst)) continue;
+            size_t hop = dst;
+            while (prev[hop] != static_cast<int>(src)) {
+                hop = static_cast<size_t>(prev[hop]);
+            }
+            nextHop_[src * n + dst] = static_cast<int>(hop);
+        }
+    }
+}
+
+WorkflowEngine::Path WorkflowEngine::shortestPath(int from, int to) const {
+    Path path;
+    const size_t n = states_.size();
+    if (from < 0 || to < 0 || static_cast<size_t>(from) >= n || static_cast<size_t>(to) >= n) {
+        return path;
+    }
+    size_t at = static_cast<size_t>(from);
+    size_t goal = static_cast<size_t>(to);
+    if (nextHop_[at * n + goal] < 0) {
+        return path;
+    }
+    path.push(from);
+    while (at != goal) {
+        at = static_cast<size_t>(nextHop_[at * n + goal]);
+        path.push(static_cast<int>(at));
+    }
+    return path;
+}
+
+bool WorkflowEngine::apply(Order& order, int to) const {
+    int from = stageOf(order);
+    if (!canTransition(from, to)) {
+        return false;
+    }
+    order.stage = to < static_cast<int>(OrderWorkflowSpec::kStateCount) ? -1 : to;
+    order.status = baseStatus(to);
+    for (const HookEntry& h : hooks_[static_cast<size_t>(to)]) {
+        if (h.from.test(static_cast<size_t>(from))) {
+            h.fn(h.context, order, from, to);
+        }
+    }
+    return true;
+}
+
+void WorkflowEngine::addHook(int from, int to, Hook fn, void* context) {
+    if (to < 0 || static_cast<size_t>(to) >= states_.size() || !fn) return;
+    HookEntry entry;
+    if (from == kAnyState) {
+        entry.from.set();
+    } else if (from >= 0 && static_cast<size_t>(from) < states_.size()) {
+        entry.from.set(static_cast<size_t>(from));
+    } else {
+        return;
+    }
+    entry.fn = fn;
+    entry.context = context;
+    hooks_[static_cast<size_t>(to)].push_back(entry);
+}
+
+void WorkflowEngine::addStatusEntryHook(OrderStatus base, Hook fn, void* context) {
+    StateSet others;
+    for (size_t i = 0; i < states_.size(); ++i) {
+        if (states_[i].base != base) others.set(i);
+    }
+    for (size_t i = 0; i < states_.size(); ++i) {
+        if (states_[i].base == base) {
+            hooks_[i].push_back(HookEntry{others, fn, context});
+        }
+    }
+}
+
+void WorkflowEngine::clearHooks() {
+    hooks_.assign(states_.size(), {});
+}
@@ -1,74 +1,43 @@
 #include "WorkflowGraph.h"
 
-#include <algorithm>
-#include <queue>
-
-WorkflowGraph::WorkflowGraph() {
-    // Initialize all to false
-    for (auto& row : allowed_) {
-        row.fill(false);
+#include <initializer_list>
+
+// The workflow tables are built during compilation; these checks fail the build if the
+// declarative transition lists stop producing the expected graph.
+namespace {
+constexpr bool samePath(const WorkflowGraph::Path& path, std::initializer_list<OrderStatus> expected) {
+    if (path.size() != expected.size()) return false;
+    size_t i = 0;
+    for (OrderStatus s : expected) {
+        if (path[i++] != s) return false;
     }
-    // Define valid transitions
-    allowed_[static_cast<int>(OrderStatus::Placed)][static_cast<int>(OrderStatus::Queued)] = true;
-    allowed_[static_cast<int>(OrderStatus::Queued)][static_cast<int>(OrderStatus::Prepping)] = true;
-    allowed_[static_cast<int>(OrderStatus::Prepping)][static_cast<int>(OrderStatus::Ready)] = true;
-    allowed_[static_cast<int>(OrderStatus::Ready)][static_cast<int>(OrderStatus::Served)] = true;
-
-    // Cancellation is allowed from any active state
-    allowed_[static_cast<int>(OrderStatus::Placed)][static_cast<int>(OrderStatus::Cancelled)] = true;
-    allowed_[static_cast<int>(OrderStatus::Queued)][static_cast<int>(OrderStatus::Cancelled)] = true;
-    allowed_[static_cast<int>(OrderStatus::Prepping)][static_cast<int>(OrderStatus::Cancelled)] = true;
-    allowed_[static_cast<int>(OrderStatus::Ready)][static_cast<int>(OrderStatus::Cancelled)] = true;
+    return true;
 }
 
-bool WorkflowGraph::canTransition(OrderStatus from, OrderStatus to) const {
-    int f = static_cast<int>(from);
-    int t = static_cast<int>(to);
-    if (f < 0 || f >= 6 || t < 0 || t >= 6) {
-        return false;
-    }
-    return allowed_[f][t];
-}
-
-std::vector<OrderStatus> WorkflowGraph::shortestPath(OrderStatus from, OrderStatus to) const {
-    int start = static_cast<int>(from);
-    int goal = static_cast<int>(to);
-    if (start == goal) {
-        return {from};
-    }
-
-    const int n = static_cast<int>(allowed_.size());
-    std::vector<int> prev(n, -1);
-    std::vector<bool> visited(n, false);
-    std::queue<int> q;
-
-    q.push(start);
-    visited[start] = true;
-
-    while (!q.empty()) {
-        int u = q.front();
-        q.pop();
-        for (int v = 0; v < n; ++v) {
-            if (!allowed_[u][v] || visited[v]) {
-                continue;
-            }
-            visited[v] = true;
-            prev[v] = u;
-            if (v == goal) {
-                break;
-            }
-            q.push(v);
-        }
-    }
-
-    if (!visited[goal]) {
-        return {};
-    }
-
-    std::vector<OrderStatus> path;
-    for (int at = goal; at != -1; at = prev[at]) {
-        path.push_back(static_cast<OrderStatus>(at));
-    }
-    std::reverse(path.begin(), path.end());
-    return path;
+static_assert(WorkflowGraph::canTransition(OrderStatus::Placed, OrderStatus::Queued), "placed orders queue");
+static_assert(!WorkflowGraph::canTransition(OrderStatus::Served, OrderStatus::Cancelled), "served is terminal");
+static_assert(samePath(WorkflowGraph::shortestPath(OrderStatus::Placed, OrderStatus::Served),
+                       {OrderStatus::Placed, OrderStatus::Queued, OrderStatus::Prepping, OrderStatus::Ready, OrderStatus::Served}),
+              "full lifecycle path");
+static_assert(WorkflowGraph::shortestPath(OrderStatus::Cancelled, OrderStatus::Queued).empty(), "cancelled is terminal");
+
+// A site workflow with an extra plating step between PREPPING and READY.
+enum class PlatedStatus { Placed, Queued, Prepping, Plated, Ready, Served, Cancelled };
+
+struct PlatedWorkflowSpec {
+    using State = PlatedStatus;
+    static constexpr size_t kStateCount = 7;
+    static constexpr std::array<WorkflowEdge<PlatedStatus>, 6> kTransitions{{
+        {PlatedStatus::Placed, PlatedStatus::Queued},
+        {PlatedStatus::Queued, PlatedStatus::Prepping},
+        {PlatedStatus::Prepping, PlatedStatus::Plated},
+        {PlatedStatus::Plated, PlatedStatus::Ready},
+        {PlatedStatus::Ready, PlatedStatus::Served},
+        {PlatedStatus::Queued, PlatedStatus::Cancelled},
+    }};
+};
+
+using PlatedWorkflow = BasicWorkflowGraph<PlatedWorkflowSpec>;
+static_assert(!PlatedWorkflow::canTransition(PlatedStatus::Prepping, PlatedStatus::Ready), "plating is mandatory");
+static_assert(PlatedWorkflow::shortestPath(PlatedStatus::Queued, PlatedStatus::Ready).size() == 4, "queued -> ready via plated");
 }
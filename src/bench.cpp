@@ -0,0 +1,1064 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Order.h"
+#include "OrderArchive.h"
+#include "OrderExport.h"
+#include "LinkedList.h"
+#include "OrderManager.h"
+#include "OrderRegistry.h"
+#include "Persistence.h"
+#include "PrepEstimator.h"
+#include "Replication.h"
+#include "ShardedManager.h"
+#include "Sorts.h"
+#include "TableRenderer.h"
+#include "TicketJournal.h"
+
+/**
+ * Micro benchmarks for the hot paths. Usage: restaurant_bench [name] [size]
+ * Every benchmark prints one line per configuration so runs can be diffed.
+ */
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+size_t sizeArg(int argc, char** argv, size_t fallback) {
+    if (argc > 2) {
+        long long v = std::atoll(argv[2]);
+        if (v > 0) return static_cast<size_t>(v);
+    }
+    return fallback;
+}
+
+std::vector<Order> makeOrders(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<long long> secs(1700000000LL, 1700000000LL + 365LL * 86400);
+    std::vector<Order> orders(n);
+    for (size_t i = 0; i < n; ++i) {
+        orders[i].id = static_cast<int>(i + 1);
+        orders[i].customerName = "Customer " + std::to_string(i % 997);
+        orders[i].estimatedPrepMinutes = static_cast<int>(i % 45) + 1;
+        orders[i].placedAt = TimeUtils::fromSeconds(secs(rng));
+    }
+    return orders;
+}
+
+void benchSort(size_t n) {
+    std::mt19937_64 rng(42);
+    std::vector<long long> keys(n);
+    for (auto& k : keys) k = static_cast<long long>(rng() >> 1);
+    auto less = [](long long a, long long b) { return a < b; };
+
+    std::cout << "sort: " << n << " keys, hardware threads " << std::thread::hardware_concurrency() << "\n";
+    double base = 0.0;
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        auto copy = keys;
+        auto start = Clock::now();
+        Sorts::parallelMergeSort(copy, less, threads);
+        double ms = msSince(start);
+        if (threads == 1) base = ms;
+        bool ok = std::is_sorted(copy.begin(), copy.end());
+        std::cout << "  parallelMergeSort threads=" << threads << ": " << ms << " ms"
+                  << " speedup " << (ms > 0 ? base / ms : 0.0) << "x" << (ok ? "" : " UNSORTED") << "\n";
+    }
+    {
+        auto copy = keys;
+        auto start = Clock::now();
+        std::sort(copy.begin(), copy.end());
+        std::cout << "  std::sort reference: " << msSince(start) << " ms\n";
+    }
+
+    size_t orderCount = std::min<size_t>(n, 200000);
+    auto orders = makeOrders(orderCount, 7);
+    auto byPlaced = [](const Order& a, const Order& b) { return a.placedAt < b.placedAt; };
+    {
+        auto copy = orders;
+        auto start = Clock::now();
+        Sorts::mergeSort(copy, byPlaced);
+        std::cout << "  mergeSort " << orderCount << " orders: " << msSince(start) << " ms\n";
+    }
+    {
+        auto copy = orders;
+        auto start = Clock::now();
+        Sorts::parallelMergeSort(copy, byPlaced);
+        std::cout << "  parallelMergeSort " << orderCount << " orders: " << msSince(start) << " ms\n";
+    }
+}
+
+void benchList(size_t n) {
+    OrderManager manager;
+    for (size_t i = 0; i < n; ++i) {
+        manager.createOrder("Customer " + std::to_string(i % 997), i % 10 == 0, {}, static_cast<int>(i % 45) + 1);
+    }
+    std::cout << "list: " << n << " orders\n";
+    for (size_t limit : {size_t{20}, size_t{0}}) {
+        ListQuery query;
+        query.limit = limit;
+        query.newestFirst = true;
+        auto start = Clock::now();
+        auto page = manager.listPage(query);
+        std::cout << "  listPage limit=" << limit << ": " << page.size() << " rows in " << msSince(start) << " ms\n";
+    }
+}
+
+std::string slowTimestamp(long long seconds) {
+    std::time_t tt = static_cast<std::time_t>(seconds);
+    std::ostringstream ss;
+    ss << std::put_time(std::localtime(&tt), "%d/%m/%Y %I:%M %p");
+    std::string out = ss.str();
+    for (char& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+void benchRender(size_t n) {
+    auto orders = makeOrders(n, 11);
+    for (size_t i = 0; i < orders.size(); ++i) {
+        orders[i].startedAt = orders[i].placedAt + std::chrono::minutes(3);
+        if (i % 2 == 0) orders[i].readyAt = orders[i].placedAt + std::chrono::minutes(12);
+    }
+    TableRenderer renderer;
+    std::string out;
+    auto start = Clock::now();
+    renderer.renderOrders(orders, out);
+    double ms = msSince(start);
+    out.clear();
+    start = Clock::now();
+    renderer.renderOrders(orders, out);
+    std::cout << "render: " << n << " rows, " << out.size() << " bytes: first " << ms << " ms, warm " << msSince(start) << " ms\n";
+
+    size_t mismatches = 0;
+    TimestampCache cache;
+    char buf[TimestampCache::kWidth];
+    for (size_t i = 0; i < std::min<size_t>(n, 20000); ++i) {
+        long long s = TimeUtils::toSeconds(orders[i].placedAt);
+        if (std::string(buf, cache.format(s, buf)) != slowTimestamp(s)) ++mismatches;
+    }
+    std::cout << "  timestamp mismatches vs put_time: " << mismatches << "\n";
+}
+
+void benchPersistItems(size_t n) {
+    OrderManager manager;
+    const int menuSize = 40;
+    for (int i = 1; i <= menuSize; ++i) {
+        manager.addMenuItem("Dish " + std::to_string(i), 1 + i % 20);
+    }
+    std::mt19937 rng(5);
+    size_t totalItems = 0;
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<OrderItem> items(1 + rng() % 30);
+        for (auto& it : items) {
+            it.itemId = 1 + static_cast<int>(rng() % menuSize);
+            it.name = "Dish " + std::to_string(it.itemId);
+            it.quantity = 1 + static_cast<int>(rng() % 4);
+        }
+        if (i % 50 == 0) items.push_back(OrderItem{0, "Off-menu special", 1});
+        totalItems += items.size();
+        manager.createOrder("Customer " + std::to_string(i), i % 7 == 0, items, 10);
+    }
+    const std::string path = "/tmp/restaurant_bench_items.json";
+    auto start = Clock::now();
+    Persistence::saveState(manager, path);
+    double saveMs = msSince(start);
+    OrderManager loaded;
+    start = Clock::now();
+    Persistence::loadState(loaded, path);
+    double loadMs = msSince(start);
+
+    auto before = manager.snapshotAll();
+    auto after = loaded.snapshotAll();
+    size_t mismatches = before.size() == after.size() ? 0 : 1;
+    for (size_t i = 0; mismatches == 0 && i < before.size(); ++i) {
+        const auto& a = before[i].items;
+        const auto& b = after[i].items;
+        if (a.size() != b.size()) { ++mismatches; break; }
+        for (size_t k = 0; k < a.size(); ++k) {
+            if (a[k].itemId != b[k].itemId || a[k].name != b[k].name || a[k].quantity != b[k].quantity) ++mismatches;
+        }
+    }
+    std::cout << "persist-items: " << n << " orders, " << totalItems << " items: save " << saveMs
+              << " ms, load " << loadMs << " ms, mismatched orders " << mismatches << "\n";
+    std::remove(path.c_str());
+}
+
+void benchSegments(size_t n) {
+    OrderManager manager;
+    for (size_t i = 0; i < n; ++i) {
+        // Spread history over a year of service days, placed through the clock so every index agrees.
+        auto day = TimeUtils::fromSeconds(1700000000LL + static_cast<long long>(i * 365 / n) * 86400);
+        manager.runAt(day, [&] { return manager.createOrder("Customer " + std::to_string(i), false, {OrderItem{0, "Plate", 2}}, 10); });
+    }
+    const std::string dir = "/tmp/restaurant_bench_segments";
+    const std::string file = "/tmp/restaurant_bench_full.json";
+    size_t written = 0;
+    auto start = Clock::now();
+    Persistence::saveSegments(manager, dir, &written);
+    std::cout << "segments: " << n << " orders: initial save " << msSince(start) << " ms (" << written << " files)\n";
+    start = Clock::now();
+    Persistence::saveState(manager, file);
+    std::cout << "  full saveState: " << msSince(start) << " ms\n";
+    for (int id = 1; id <= 10; ++id) {
+        manager.startOrder(id * static_cast<int>(n / 10 > 0 ? n / 10 : 1));
+    }
+    start = Clock::now();
+    Persistence::saveSegments(manager, dir, &written);
+    std::cout << "  incremental save after 10 changes: " << msSince(start) << " ms (" << written << " files)\n";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::remove(file.c_str());
+}
+
+void benchBulk(size_t n) {
+    auto makeBatch = [&]() {
+        std::vector<NewOrder> batch(n);
+        for (size_t i = 0; i < n; ++i) {
+            batch[i].customerName = "Delivery platform customer " + std::to_string(i);
+            batch[i].isVip = i % 10 == 0;
+            batch[i].items = {OrderItem{1, "Burger", 2}, OrderItem{2, "Fries", 1}};
+            batch[i].estimatedPrepMinutes = 12;
+        }
+        return batch;
+    };
+    {
+        auto batch = makeBatch();
+        OrderManager manager;
+        auto start = Clock::now();
+        for (const auto& o : batch) {
+            manager.createOrder(o.customerName, o.isVip, o.items, o.estimatedPrepMinutes);
+        }
+        std::cout << "bulk: " << n << " orders: per-order createOrder " << msSince(start) << " ms\n";
+    }
+    {
+        auto batch = makeBatch();
+        OrderManager manager;
+        auto start = Clock::now();
+        manager.createOrders(std::move(batch));
+        std::cout << "  createOrders " << msSince(start) << " ms\n";
+
+        std::vector<int> ids;
+        for (size_t i = 0; i < n; i += 2) ids.push_back(static_cast<int>(i + 1));
+        start = Clock::now();
+        size_t moved = manager.transitionMany(ids, OrderStatus::Prepping);
+        std::cout << "  transitionMany " << moved << " orders " << msSince(start) << " ms\n";
+    }
+}
+
+void benchRange(size_t n) {
+    OrderManager manager;
+    std::vector<NewOrder> batch(n);
+    for (size_t i = 0; i < n; ++i) {
+        batch[i].customerName = "Customer " + std::to_string(i);
+        batch[i].estimatedPrepMinutes = 10;
+    }
+    manager.createOrders(std::move(batch));
+    // Spread placements one second apart through the restore path, as a loaded history would be.
+    OrderManager history;
+    for (const auto& o : manager.snapshotAll()) {
+        Order copy = o;
+        copy.placedAt = TimeUtils::fromSeconds(1700000000LL + copy.id);
+        history.restoreOrder(std::move(copy));
+    }
+    long long from = 1700000000LL + static_cast<long long>(n / 2);
+    long long to = from + 3600;
+    auto start = Clock::now();
+    auto hour = history.placedBetween(from, to);
+    double indexed = msSince(start);
+    start = Clock::now();
+    auto all = history.snapshotAll();
+    std::vector<Order> scanned;
+    for (const auto& o : all) {
+        long long s = TimeUtils::toSeconds(o.placedAt);
+        if (s >= from && s < to) scanned.push_back(o);
+    }
+    Sorts::parallelMergeSort(scanned, [](const Order& a, const Order& b) { return a.placedAt < b.placedAt; });
+    std::cout << "range: " << n << " orders, one-hour window (" << hour.size() << " rows): index "
+              << indexed << " ms, snapshot+filter+sort " << msSince(start) << " ms\n";
+}
+
+void benchCustomers(size_t n) {
+    static const char* const first[] = {"John", "Maria", "Wei", "Aisha", "Carlos", "Yuki", "Olga", "Sam"};
+    static const char* const last[] = {"Smith", "Garcia", "Chen", "Khan", "Silva", "Tanaka", "Ivanova", "Lee"};
+    OrderManager manager;
+    std::vector<NewOrder> batch(n);
+    std::mt19937 rng(42);
+    for (size_t i = 0; i < n; ++i) {
+        batch[i].customerName = std::string(first[rng() % 8]) + " " + last[rng() % 8] + " " + std::to_string(rng() % 1000);
+        batch[i].estimatedPrepMinutes = 10;
+    }
+    auto start = Clock::now();
+    manager.createOrders(std::move(batch));
+    std::cout << "customers: " << n << " orders indexed in " << msSince(start) << " ms\n";
+    start = Clock::now();
+    auto prefix = manager.findByCustomer("maria garcia 42", 50);
+    std::cout << "  prefix 'maria garcia 42': " << prefix.size() << " rows " << msSince(start) << " ms\n";
+    start = Clock::now();
+    bool fuzzy = false;
+    auto close = manager.findByCustomer("mria garcai 427", 10, &fuzzy);
+    std::cout << "  fuzzy 'mria garcai 427': " << close.size() << " rows" << (fuzzy ? "" : " (prefix)") << " "
+              << msSince(start) << " ms\n";
+}
+
+/** ETA lookups over a deep backlog versus re-simulating the queue order for each lookup. */
+void benchEta(size_t n) {
+    OrderManager manager;
+    std::vector<NewOrder> batch(n);
+    for (size_t i = 0; i < n; ++i) {
+        batch[i].customerName = "Customer " + std::to_string(i);
+        batch[i].isVip = i % 10 == 0;
+        batch[i].estimatedPrepMinutes = 5 + static_cast<int>(i % 20);
+    }
+    manager.createOrders(std::move(batch));
+    const size_t lookups = 1000;
+    std::mt19937 rng(3);
+    std::vector<int> ids(lookups);
+    for (auto& id : ids) id = static_cast<int>(1 + rng() % n);
+
+    auto start = Clock::now();
+    long long checksum = 0;
+    std::chrono::system_clock::time_point eta;
+    for (int id : ids) {
+        if (manager.projectedReadyAt(id, eta)) checksum += TimeUtils::toSeconds(eta) % 7;
+    }
+    double indexed = msSince(start);
+
+    // Baseline: walk VIP heap order then the FIFO, summing estimates until the order is reached.
+    start = Clock::now();
+    size_t simulated = std::min<size_t>(lookups, 50);
+    for (size_t i = 0; i < simulated; ++i) {
+        auto vips = manager.vipHeap().snapshotIds();
+        auto normal = manager.normalQueue().snapshot();
+        long long ahead = 0;
+        bool found = false;
+        for (int id : vips) {
+            if (id == ids[i]) { found = true; break; }
+            ahead += manager.getOrder(id)->estimatedPrepMinutes;
+        }
+        for (size_t j = 0; !found && j < normal.size(); ++j) {
+            if (normal[j] == ids[i]) break;
+            ahead += manager.getOrder(normal[j])->estimatedPrepMinutes;
+        }
+        checksum += ahead % 7;
+    }
+    double naive = msSince(start) * static_cast<double>(lookups) / static_cast<double>(simulated);
+
+    start = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) {
+        int id = ids[i];
+        Order* o = manager.getOrder(id);
+        manager.editOrder(id, std::string(o->customerName), o->isVip, std::vector<OrderItem>(o->items), o->estimatedPrepMinutes + 1);
+    }
+    double edits = msSince(start);
+    std::cout << "eta: " << n << " queued, " << lookups << " lookups: fenwick " << indexed << " ms, re-simulation ~"
+              << naive << " ms; " << lookups << " estimate edits " << edits << " ms (checksum " << checksum << ")\n";
+}
+
+/**
+ * Prep-time model accuracy: menu defaults are off from the (hidden) true per-item times and a busy
+ * kitchen is slower. Compares mean absolute error of the static default sum with the learned
+ * estimate over the second half of a synthetic stream, and times observe().
+ */
+void benchPrep(size_t n) {
+    const std::vector<int> defaults = {0, 10, 4, 8, 3, 12};
+    const double trueMinutes[] = {0, 7.0, 5.5, 11.0, 2.0, 9.0};
+    PrepEstimator model;
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(1.0, 0.1);
+    double staticError = 0.0;
+    double learnedError = 0.0;
+    size_t scored = 0;
+    double observeMs = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        Order order;
+        size_t lines = 1 + rng() % 3;
+        for (size_t l = 0; l < lines; ++l) {
+            order.items.push_back(OrderItem{static_cast<int>(1 + rng() % 5), "", static_cast<int>(1 + rng() % 2)});
+        }
+        int load = static_cast<int>(rng() % 13);
+        double actual = 0.0;
+        int staticEstimate = 0;
+        for (const auto& item : order.items) {
+            actual += trueMinutes[item.itemId] * item.quantity;
+            staticEstimate += defaults[static_cast<size_t>(item.itemId)] * item.quantity;
+        }
+        actual *= (1.0 + 0.04 * load) * noise(rng);
+        if (i >= n / 2) {
+            staticError += std::abs(staticEstimate - actual);
+            learnedError += std::abs(model.estimateMinutes(order.items, defaults, load) - actual);
+            ++scored;
+        }
+        order.startedAt = TimeUtils::fromSeconds(1700000000LL);
+        order.readyAt = TimeUtils::fromSeconds(1700000000LL + static_cast<long long>(actual * 60.0));
+        auto start = Clock::now();
+        model.observe(order, defaults, load);
+        observeMs += msSince(start);
+    }
+    std::cout << "prep: " << n << " orders, mean abs error (min) menu defaults " << staticError / static_cast<double>(scored)
+              << ", learned " << learnedError / static_cast<double>(scored) << "; observe " << observeMs * 1000.0 / static_cast<double>(n)
+              << " us/order\n";
+}
+
+/**
+ * Event stream latency: the main thread creates and advances orders while a consumer thread
+ * drains its ring, measuring publish-to-consume time from the event's steady_clock stamp.
+ */
+void benchEvents(size_t n) {
+    OrderManager manager;
+    OrderEventRing* ring = manager.subscribe(4096);
+    std::atomic<bool> done{false};
+    std::vector<long long> latencies;
+    latencies.reserve(n * 3);
+    std::thread consumer([&] {
+        OrderEvent e;
+        while (true) {
+            if (ring->tryPop(e)) {
+                long long nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                latencies.push_back(nowNs - e.publishedNanos);
+            } else if (done.load(std::memory_order_acquire) && ring->size() == 0) {
+                break;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    auto start = Clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        manager.startOrder(manager.createOrder("Customer " + std::to_string(i), i % 10 == 0, {}, 10));
+    }
+    double produceMs = msSince(start);
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    std::sort(latencies.begin(), latencies.end());
+    auto pct = [&](double p) {
+        return latencies.empty() ? 0.0 : static_cast<double>(latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))]) / 1000.0;
+    };
+    std::cout << "events: " << ring->published() << " published, " << ring->dropped() << " dropped (ring "
+              << ring->capacity() << "), producer " << produceMs << " ms; latency us p50 " << pct(0.5)
+              << " p99 " << pct(0.99) << " max " << pct(1.0) << "\n";
+}
+
+/**
+ * Read snapshots over n orders: a deep copy against the first and an incremental snapshot, then
+ * writer latency while another thread renders a full save from a held snapshot.
+ */
+void benchSnapshot(size_t n) {
+    OrderManager manager;
+    std::vector<NewOrder> batch(n);
+    for (size_t i = 0; i < n; ++i) {
+        batch[i].customerName = "Customer with a longer name " + std::to_string(i);
+        batch[i].items = {OrderItem{1, "Margherita", 1}, OrderItem{2, "Espresso", 2}};
+        batch[i].estimatedPrepMinutes = 10;
+    }
+    manager.createOrders(std::move(batch));
+
+    auto start = Clock::now();
+    auto deep = manager.snapshotAll();
+    double copyMs = msSince(start);
+    start = Clock::now();
+    OrderSnapshot first = manager.snapshot();
+    double firstMs = msSince(start);
+
+    // Steady state: a few hundred changes between snapshots while older snapshots are still held.
+    const size_t edits = 500;
+    std::mt19937 rng(11);
+    for (size_t i = 0; i < edits; ++i) manager.cancelOrder(static_cast<int>(1 + rng() % n));
+    start = Clock::now();
+    OrderSnapshot second = manager.snapshot();
+    double incrementalMs = msSince(start);
+
+    // Writer latency while a reader renders a full save from the snapshot on another thread.
+    std::atomic<bool> rendering{true};
+    size_t rendered = 0;
+    std::thread reader([&] {
+        rendered = Persistence::renderState(second).size();
+        rendering = false;
+    });
+    start = Clock::now();
+    size_t created = 0;
+    while (rendering.load()) {
+        manager.createOrder("Walk-in", false, {}, 5);
+        ++created;
+    }
+    double writeMs = msSince(start);
+    reader.join();
+
+    std::cout << "snapshot: " << n << " orders: deep copy " << copyMs << " ms, first snapshot " << firstMs
+              << " ms, after " << edits << " changes " << incrementalMs << " ms (epochs " << first.epoch() << " -> "
+              << second.epoch() << "); " << created << " orders created while rendering " << rendered / 1024
+              << " KiB from the snapshot (" << (created ? writeMs * 1000.0 / static_cast<double>(created) : 0.0)
+              << " us/order); " << deep.size() << " copied\n";
+}
+
+/**
+ * Replication lag: a forked standby applies the stream while this process runs the primary at
+ * 1000 orders/second, every other order also pulled into the kitchen and marked ready.
+ */
+void benchReplication(size_t n) {
+    std::string socketPath = (std::filesystem::temp_directory_path() / ("restaurant_bench_" + std::to_string(::getpid()) + ".sock")).string();
+    int results[2];
+    if (::pipe(results) != 0) return;
+    pid_t child = ::fork();
+    if (child < 0) return;
+    if (child == 0) {
+        ::close(results[0]);
+        OrderManager standby;
+        ReplicaStats stats;
+        std::vector<long long> lags;
+        stats.lagSamples = &lags;
+        bool ok = Replication::runStandby(standby, socketPath, stats);
+        std::sort(lags.begin(), lags.end());
+        auto pct = [&](double q) { return lags.empty() ? 0LL : lags[static_cast<size_t>(q * static_cast<double>(lags.size() - 1))]; };
+        std::ostringstream out;
+        out << stats.records << " records, lag p50 " << pct(0.5) / 1000 << " us, p99 " << pct(0.99) / 1000 << " us, max "
+            << stats.lagMaxNanos / 1000 << " us; standby holds " << standby.activeCount() << " orders (" << stats.failed
+            << " not applied)" << (ok ? "" : " STREAM ERROR");
+        std::string text = out.str();
+        ssize_t written = ::write(results[1], text.data(), text.size());
+        ::_exit(written == static_cast<ssize_t>(text.size()) ? 0 : 1);
+    }
+    ::close(results[1]);
+
+    OrderManager primary;
+    ReplicationLog log;
+    primary.setReplicationLog(&log);
+    std::atomic<bool> resync{false};
+    {
+        ReplicationSender sender(log, socketPath, [&] { resync = true; });
+        while (!resync.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        log.fullState(Persistence::renderState(primary.snapshot()));
+
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(1000 * i));
+            primary.createOrder("Customer " + std::to_string(i), i % 10 == 0, {OrderItem{1, "Margherita", 1}}, 10);
+            int id = 0;
+            if (i % 2 == 1 && primary.nextForKitchen(id)) primary.readyOrder(id);
+        }
+    }
+
+    std::string summary;
+    char buffer[512];
+    ssize_t got = 0;
+    while ((got = ::read(results[0], buffer, sizeof(buffer))) > 0) summary.append(buffer, static_cast<size_t>(got));
+    ::close(results[0]);
+    int status = 0;
+    ::waitpid(child, &status, 0);
+    std::cout << "replication: " << n << " orders at 1000/s, " << log.recordCount() << " records logged; " << summary << "\n";
+}
+
+/**
+ * Four branches behind a ShardedManager against one manager holding the same orders: routed
+ * creates, a scatter/gather top-50 completed report, per-branch stats and saveAll.
+ */
+void benchShards(size_t n) {
+    const size_t shardCount = 4;
+    ShardedManager sharded;
+    sharded.open({"north", "south", "east", "west"});
+    OrderManager single;
+    auto start = Clock::now();
+    std::vector<int> ids;
+    ids.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        ids.push_back(sharded.createOrder(i % shardCount, "Customer " + std::to_string(i), i % 10 == 0, {}, 10));
+    }
+    double routed = msSince(start);
+    for (size_t i = 0; i < n; ++i) single.createOrder("Customer " + std::to_string(i), i % 10 == 0, {}, 10);
+
+    // Served orders give "report completed" something to merge.
+    for (size_t i = 0; i < n; i += 2) {
+        sharded.startOrder(ids[i]);
+        sharded.readyOrder(ids[i]);
+        sharded.serveOrder(ids[i]);
+        int id = static_cast<int>(i + 1);
+        single.startOrder(id);
+        single.readyOrder(id);
+        single.serveOrder(id);
+    }
+
+    ListQuery query;
+    query.statusMask = ListQuery::maskOf(OrderStatus::Served);
+    query.byServed = true;
+    query.newestFirst = true;
+    query.limit = 50;
+    const int rounds = 20;
+    start = Clock::now();
+    size_t rows = 0;
+    for (int r = 0; r < rounds; ++r) rows += sharded.listAll(query).size();
+    double scatter = msSince(start) / rounds;
+    start = Clock::now();
+    for (int r = 0; r < rounds; ++r) rows += single.listPage(query).size();
+    double local = msSince(start) / rounds;
+
+    start = Clock::now();
+    auto branches = sharded.stats();
+    double statsMs = msSince(start);
+    size_t served = 0;
+    for (const auto& b : branches) served += b.byStatus[static_cast<size_t>(OrderStatus::Served)];
+
+    std::string dir = (std::filesystem::temp_directory_path() / "restaurant_bench_shards").string();
+    start = Clock::now();
+    bool saved = sharded.saveAll(dir);
+    double saveMs = msSince(start);
+    std::filesystem::remove_all(dir);
+
+    std::cout << "shards: " << n << " orders over " << shardCount << " branches, routed create " << routed << " ms; "
+              << "top-50 completed: scatter/gather " << scatter << " ms vs one manager " << local << " ms; "
+              << "stats " << statsMs << " ms (" << served << " served); saveAll " << saveMs << " ms"
+              << (saved ? "" : " FAILED") << " (rows " << rows << ")\n";
+}
+
+/**
+ * Time-warp simulation: n orders arrive over a 12-hour service on a VirtualClock and a kitchen
+ * of K stations pulls them VIP-first, for K below, at and above the load. Each configuration
+ * runs twice and must stamp identical timelines (digest), which only holds if nothing reads the
+ * system clock.
+ */
+void benchService(size_t n) {
+    using namespace std::chrono;
+    const auto open = TimeUtils::fromSeconds(1717236000LL);
+    const double serviceSeconds = 12 * 3600.0;
+    struct Arrival {
+        nanoseconds at;
+        bool vip;
+        int prepMinutes;
+        double slowdown;
+    };
+    std::vector<Arrival> arrivals;
+    std::mt19937 rng(11);
+    std::exponential_distribution<double> gap(static_cast<double>(n) / serviceSeconds);
+    std::uniform_int_distribution<int> prep(5, 25);
+    std::lognormal_distribution<double> jitter(0.0, 0.2);
+    double t = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        t += gap(rng);
+        arrivals.push_back(Arrival{duration_cast<nanoseconds>(duration<double>(t)), rng() % 10 == 0, prep(rng), jitter(rng)});
+    }
+    double needed = static_cast<double>(n) * 15.0 / (serviceSeconds / 60.0);
+
+    struct Result {
+        double normalWait{0.0};
+        double vipWait{0.0};
+        double p95Wait{0.0};
+        size_t served{0};
+        uint64_t digest{0};
+        double ms{0.0};
+    };
+    auto run = [&](int stations) {
+        Result result;
+        auto start = Clock::now();
+        VirtualClock clock(open);
+        OrderManager manager;
+        manager.setClock(&clock);
+        manager.setKitchenStations(stations);
+        struct Station {
+            int orderId{0};
+            system_clock::time_point doneAt{};
+        };
+        std::vector<Station> kitchen(static_cast<size_t>(stations));
+        std::vector<double> slowdownOf(n + 1, 1.0);
+        size_t next = 0;
+        while (true) {
+            // Next event: an arrival or the earliest station to finish, arrivals first on ties.
+            Station* finishing = nullptr;
+            for (auto& s : kitchen) {
+                if (s.orderId && (!finishing || s.doneAt < finishing->doneAt)) finishing = &s;
+            }
+            bool arrival = next < arrivals.size() && (!finishing || open + arrivals[next].at <= finishing->doneAt);
+            if (!arrival && !finishing) break;
+            if (arrival) {
+                const Arrival& a = arrivals[next++];
+                clock.advanceTo(open + a.at);
+                int id = manager.createOrder("Guest", a.vip, {}, a.prepMinutes);
+                slowdownOf[static_cast<size_t>(id)] = a.slowdown;
+            } else {
+                clock.advanceTo(finishing->doneAt);
+                manager.readyOrder(finishing->orderId);
+                manager.serveOrder(finishing->orderId);
+                finishing->orderId = 0;
+            }
+            for (auto& s : kitchen) {
+                if (s.orderId || !manager.nextForKitchen(s.orderId)) continue;
+                const Order* o = manager.getOrder(s.orderId);
+                auto minutes = duration<double, std::ratio<60>>(o->estimatedPrepMinutes * slowdownOf[static_cast<size_t>(o->id)]);
+                s.doneAt = clock.peek() + duration_cast<system_clock::duration>(minutes);
+            }
+        }
+        std::vector<double> waits;
+        double normalTotal = 0.0;
+        double vipTotal = 0.0;
+        size_t vips = 0;
+        manager.snapshot().forEach([&](const Order& o) {
+            double wait = duration<double, std::ratio<60>>(o.startedAt - o.placedAt).count();
+            waits.push_back(wait);
+            (o.isVip ? vipTotal : normalTotal) += wait;
+            if (o.isVip) ++vips;
+            if (o.status == OrderStatus::Served) ++result.served;
+            for (long long stamp : {TimeUtils::toNanos(o.startedAt), TimeUtils::toNanos(o.servedAt)}) {
+                result.digest = (result.digest ^ static_cast<uint64_t>(stamp)) * 1099511628211ULL;
+            }
+        });
+        std::sort(waits.begin(), waits.end());
+        result.normalWait = normalTotal / static_cast<double>(std::max<size_t>(1, waits.size() - vips));
+        result.vipWait = vipTotal / static_cast<double>(std::max<size_t>(1, vips));
+        result.p95Wait = waits.empty() ? 0.0 : waits[waits.size() * 95 / 100];
+        result.ms = msSince(start);
+        return result;
+    };
+
+    for (double share : {0.9, 1.0, 1.2}) {
+        int stations = std::max(1, static_cast<int>(std::ceil(needed * share)));
+        Result first = run(stations);
+        Result second = run(stations);
+        std::cout << std::fixed << std::setprecision(1) << "service: " << n << " orders over 12 h, " << stations
+                  << " stations: served " << first.served << ", wait mean " << first.normalWait << " min (VIP "
+                  << first.vipWait << "), p95 " << first.p95Wait << " min; simulated in " << first.ms << " ms ("
+                  << std::setprecision(0) << serviceSeconds * 1000.0 / first.ms << "x real time), replay "
+                  << (first.digest == second.digest ? "identical" : "DIFFERENT") << "\n" << std::defaultfloat;
+    }
+}
+
+/**
+ * Kitchen journal: cost per journaled transition, then recovering the kitchen from the mapped
+ * ring next to reloading the full state file. n orders, of which about 2000 stay open.
+ */
+void benchJournal(size_t n) {
+    auto dir = std::filesystem::temp_directory_path() / "restaurant_bench_journal";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string journalPath = (dir / "tickets.journal").string();
+    const std::string statePath = (dir / "state.json").string();
+
+    // The same traffic with and without the journal; the difference is the journaling cost. A
+    // warm-up round of each comes first, then rounds alternate which side runs first, and the
+    // medians are reported, so page-cache and allocator warm-up do not land on one side.
+    auto traffic = [n](OrderManager& m) {
+        std::vector<OrderItem> items = {OrderItem{1, "Burger", 2}};
+        auto start = Clock::now();
+        int id = 0;
+        for (size_t i = 0; i < n; ++i) {
+            m.createOrder("Guest", i % 10 == 0, items, 10);
+            if (i >= 2000 && m.nextForKitchen(id)) {
+                m.readyOrder(id);
+                m.serveOrder(id);
+            }
+        }
+        return msSince(start);
+    };
+    auto median = [](std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return values.empty() ? 0.0 : values[values.size() / 2];
+    };
+    const int rounds = 5;
+    std::vector<double> plainRuns;
+    std::vector<double> journaledRuns;
+    std::vector<double> perRecord;
+    uint64_t records = 0;
+    TicketJournal journal;
+    std::unique_ptr<OrderManager> journaled;
+    for (int round = -1; round < rounds; ++round) {
+        OrderManager plain;
+        journaled = std::make_unique<OrderManager>();
+        journal.close();
+        std::filesystem::remove(journalPath);
+        if (!journal.open(journalPath)) {
+            std::cout << "journal: cannot open " << journalPath << "\n";
+            return;
+        }
+        journal.attach(*journaled);
+        double plainMs = 0;
+        double journaledMs = 0;
+        if (round % 2 == 0) {
+            plainMs = traffic(plain);
+            journaledMs = traffic(*journaled);
+        } else {
+            journaledMs = traffic(*journaled);
+            plainMs = traffic(plain);
+        }
+        records = journal.sequence();
+        if (round < 0) continue;
+        plainRuns.push_back(plainMs);
+        journaledRuns.push_back(journaledMs);
+        perRecord.push_back((journaledMs - plainMs) * 1e6 / static_cast<double>(records));
+    }
+    OrderManager& manager = *journaled;
+    Persistence::saveState(manager, statePath);
+
+    auto start = Clock::now();
+    TicketJournal reopened;
+    reopened.open(journalPath);
+    KitchenState state;
+    reopened.recover(state);
+    double recoverMs = msSince(start);
+
+    start = Clock::now();
+    OrderManager loaded;
+    Persistence::loadState(loaded, statePath);
+    double loadMs = msSince(start);
+
+    std::cout << "journal: " << n << " orders, " << records << " records; median of " << rounds << " rounds: plain "
+              << median(plainRuns) << " ms, journaled " << median(journaledRuns) << " ms, " << median(perRecord)
+              << " ns per record over plain traffic; recover "
+              << state.queue.size() + state.waitingVips << " waiting + " << state.inFlight << " in-kitchen tickets from "
+              << reopened.capacity() << " slots in " << recoverMs * 1000.0 << " us vs full state load " << loadMs * 1000.0 << " us\n";
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * Archive: a service history of n orders (one every 20 s, most served) saved as JSON next to the
+ * same orders archived, then id lookups and a one-hour report that only read matching blocks.
+ */
+void benchArchive(size_t n) {
+    auto dir = std::filesystem::temp_directory_path() / "restaurant_bench_archive";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string statePath = (dir / "state.json").string();
+    const std::string archivePath = (dir / "orders.archive").string();
+
+    VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::seconds(5));
+    OrderManager manager;
+    manager.setClock(&clock);
+    const char* dishes[] = {"Margherita", "Carbonara", "Caesar salad", "Tiramisu", "Espresso", "Lemonade"};
+    for (const char* dish : dishes) manager.addMenuItem(dish, 8);
+    std::mt19937 rng(17);
+    int id = 0;
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<OrderItem> items;
+        for (size_t l = 1 + rng() % 3; l > 0; --l) {
+            const char* dish = dishes[rng() % 6];
+            items.push_back(OrderItem{manager.findMenuItem(dish)->itemId, dish, 1 + static_cast<int>(rng() % 2)});
+        }
+        manager.createOrder("Guest " + std::to_string(rng() % 5000), i % 10 == 0, std::move(items), 10);
+        if (manager.nextForKitchen(id)) {
+            manager.readyOrder(id);
+            if (i % 25 == 0) {
+                manager.cancelOrder(id);
+            } else {
+                manager.serveOrder(id);
+            }
+        }
+    }
+    Persistence::saveState(manager, statePath);
+    auto jsonBytes = std::filesystem::file_size(statePath);
+
+    auto start = Clock::now();
+    std::vector<Order> finished;
+    manager.takeFinished(TimeUtils::toSeconds(manager.now()) + 1, finished);
+    size_t archived = finished.size();
+    OrderArchive archive;
+    archive.open(archivePath);
+    archive.append(finished);
+    double writeMs = msSince(start);
+    uint64_t archiveBytes = archive.fileBytes();
+
+    const int lookups = 200;
+    start = Clock::now();
+    Order found;
+    size_t hits = 0;
+    for (int i = 0; i < lookups; ++i) hits += archive.find(1 + static_cast<int>(rng() % n), found);
+    double findUs = msSince(start) * 1000.0 / lookups;
+
+    long long first = archive.blocks().front().minPlaced;
+    long long last = archive.blocks().back().maxPlaced;
+    long long from = first + (last - first) / 2;
+    size_t rows = 0;
+    start = Clock::now();
+    size_t blocksRead = archive.forEachInRange(from, from + 3600, false, [&](const Order&) { ++rows; });
+    double reportMs = msSince(start);
+    size_t all = 0;
+    start = Clock::now();
+    archive.forEach([&](const Order&) { ++all; });
+    double scanMs = msSince(start);
+
+    std::cout << std::fixed << std::setprecision(1) << "archive: " << archived << " finished orders, JSON " << jsonBytes << " bytes ("
+              << static_cast<double>(jsonBytes) / static_cast<double>(n) << " per order) vs archive " << archiveBytes << " bytes ("
+              << static_cast<double>(archiveBytes) / static_cast<double>(archived) << " per order, "
+              << static_cast<double>(jsonBytes) / static_cast<double>(archiveBytes) << "x smaller), written in " << writeMs << " ms\n"
+              << "archive: find by id " << findUs << " us (" << hits << "/" << lookups << " hits); 1 h report " << rows
+              << " rows from " << blocksRead << " of " << archive.blocks().size() << " blocks in " << reportMs * 1000.0
+              << " us vs decoding all " << all << " in " << scanMs << " ms\n" << std::defaultfloat;
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * Export: n orders, half of them archived, streamed as CSV and as columnar files on one thread
+ * and on every core, with throughput and the peak buffer against the file size.
+ */
+void benchExport(size_t n) {
+    auto dir = std::filesystem::temp_directory_path() / "restaurant_bench_export";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::seconds(5));
+    OrderManager manager;
+    manager.setClock(&clock);
+    const char* dishes[] = {"Margherita", "Carbonara", "Caesar salad", "Tiramisu", "Espresso", "Lemonade"};
+    for (const char* dish : dishes) manager.addMenuItem(dish, 8);
+    std::mt19937 rng(19);
+    int id = 0;
+    for (size_t i = 0; i < n; ++i) {
+        std::vector<OrderItem> items;
+        for (size_t l = 1 + rng() % 3; l > 0; --l) {
+            const char* dish = dishes[rng() % 6];
+            items.push_back(OrderItem{manager.findMenuItem(dish)->itemId, dish, 1 + static_cast<int>(rng() % 2)});
+        }
+        manager.createOrder("Guest, table " + std::to_string(rng() % 5000), i % 10 == 0, std::move(items), 10);
+        if (i % 4 != 0 && manager.nextForKitchen(id)) {
+            manager.readyOrder(id);
+            manager.serveOrder(id);
+        }
+    }
+    // Half of the history lives in the archive, as it would after a few archive runs.
+    std::vector<Order> finished;
+    manager.takeFinished(TimeUtils::toSeconds(manager.now()) - static_cast<long long>(n) * 5 / 2, finished);
+    OrderArchive archive;
+    archive.open((dir / "orders.archive").string());
+    archive.append(finished);
+    OrderSnapshot snapshot = manager.snapshot();
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (auto format : {OrderExport::Format::Csv, OrderExport::Format::Columnar}) {
+        const char* name = format == OrderExport::Format::Csv ? "csv" : "columnar";
+        for (unsigned threads : {1u, cores}) {
+            OrderExport::Options options;
+            options.format = format;
+            options.threads = threads;
+            OrderExport::Stats stats;
+            auto start = Clock::now();
+            OrderExport::write(snapshot, &archive, (dir / name).string(), options, &stats);
+            double ms = msSince(start);
+            std::cout << std::fixed << std::setprecision(1) << "export " << name << ": " << stats.rows << " rows (" << stats.archivedRows
+                      << " archived), " << threads << " thread(s): " << ms << " ms, " << static_cast<double>(stats.rows) / ms / 1000.0
+                      << " M rows/s, " << stats.bytes << " bytes, peak buffer " << stats.peakBufferBytes << " bytes ("
+                      << 100.0 * static_cast<double>(stats.peakBufferBytes) / static_cast<double>(stats.bytes) << "% of file)\n"
+                      << std::defaultfloat;
+            if (cores == 1) break;
+        }
+    }
+    std::filesystem::remove_all(dir);
+}
+
+/**
+ * Full scans of n orders in the linked OrderList against the flat OrderRegistry (count, copy out,
+ * VIP heap rebuild), plus the cost of a generation-checked handle lookup.
+ */
+void benchRegistry(size_t n) {
+    // Orders arrive with their names and items, and some finish and leave, as in service, so the
+    // list's nodes end up scattered between other allocations.
+    OrderList list;
+    OrderRegistry registry;
+    std::vector<OrderNode*> nodes;
+    std::vector<OrderHandle> handles;
+    std::mt19937 rng(23);
+    const char* dishes[] = {"Margherita", "Carbonara", "Caesar salad", "Tiramisu"};
+    for (size_t i = 0; nodes.size() < n; ++i) {
+        Order o;
+        o.id = static_cast<int>(i + 1);
+        o.customerName = "Customer " + std::to_string(rng() % 5000);
+        o.isVip = i % 10 == 0;
+        o.status = static_cast<OrderStatus>(rng() % 6);
+        o.placedAt = TimeUtils::fromSeconds(1717236000LL + static_cast<long long>(i));
+        for (size_t l = 1 + rng() % 3; l > 0; --l) o.items.push_back(OrderItem{1, dishes[rng() % 4], 1});
+        nodes.push_back(list.pushBack(o));
+        handles.push_back(registry.insert(std::move(o)));
+        if (rng() % 4 == 0) {
+            size_t pick = rng() % nodes.size();
+            list.remove(nodes[pick]);
+            registry.erase(handles[pick]);
+            nodes[pick] = nodes.back();
+            handles[pick] = handles.back();
+            nodes.pop_back();
+            handles.pop_back();
+        }
+    }
+
+    const int rounds = 20;
+    auto time = [&](auto scan) {
+        scan();
+        auto start = Clock::now();
+        for (int r = 0; r < rounds; ++r) scan();
+        return msSince(start) / rounds;
+    };
+    size_t sink = 0;
+    double listCount = time([&] { list.forEach([&](OrderNode* node) { sink += node->data.status == OrderStatus::Queued; }); });
+    double flatCount = time([&] { registry.forEach([&](const Order& o) { sink += o.status == OrderStatus::Queued; }); });
+    // listByStatus and snapshotAll copy out the orders they visit.
+    double listCopy = time([&] {
+        std::vector<Order> out;
+        list.forEach([&](OrderNode* node) { if (node->data.status == OrderStatus::Served) out.push_back(node->data); });
+        sink += out.size();
+    });
+    double flatCopy = time([&] {
+        std::vector<Order> out;
+        registry.forEach([&](const Order& o) { if (o.status == OrderStatus::Served) out.push_back(o); });
+        sink += out.size();
+    });
+    // rebuildSchedules after a load: collect waiting VIPs for the heap.
+    auto waitingVip = [](const Order& o) { return o.isVip && (o.status == OrderStatus::Queued || o.status == OrderStatus::Placed); };
+    double listVip = time([&] {
+        std::vector<VipEntry> vips;
+        list.forEach([&](OrderNode* node) { if (waitingVip(node->data)) vips.push_back(VipEntry{node->data.id, TimeUtils::toNanos(node->data.placedAt)}); });
+        sink += vips.size();
+    });
+    double flatVip = time([&] {
+        std::vector<VipEntry> vips;
+        registry.forEach([&](const Order& o) { if (waitingVip(o)) vips.push_back(VipEntry{o.id, TimeUtils::toNanos(o.placedAt)}); });
+        sink += vips.size();
+    });
+    const size_t lookups = 1000000;
+    std::vector<size_t> picks(lookups);
+    for (size_t& p : picks) p = rng() % handles.size();
+    auto start = Clock::now();
+    for (size_t p : picks) sink += static_cast<size_t>(registry.get(handles[p])->id);
+    double getNs = msSince(start) * 1e6 / static_cast<double>(lookups);
+
+    std::cout << std::fixed << std::setprecision(2) << "registry: " << registry.size() << " orders, full scan (linked list vs flat): count by status "
+              << listCount << " vs " << flatCount << " ms (" << listCount / flatCount << "x), listByStatus copy " << listCopy << " vs "
+              << flatCopy << " ms (" << listCopy / flatCopy << "x), VIP heap rebuild scan " << listVip << " vs " << flatVip << " ms ("
+              << listVip / flatVip << "x); handle lookup " << getNs << " ns (checksum " << sink % 10 << ")\n" << std::defaultfloat;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string which = argc > 1 ? argv[1] : "all";
+    bool all = which == "all";
+    if (all || which == "sort") benchSort(sizeArg(argc, argv, 10000000));
+    if (all || which == "list") benchList(sizeArg(argc, argv, 200000));
+    if (all || which == "persist-items") benchPersistItems(sizeArg(argc, argv, 5000));
+    if (all || which == "segments") benchSegments(sizeArg(argc, argv, 100000));
+    if (all || which == "bulk") benchBulk(sizeArg(argc, argv, 100000));
+    if (all || which == "range") benchRange(sizeArg(argc, argv, 200000));
+    if (all || which == "customers") benchCustomers(sizeArg(argc, argv, 200000));
+    if (all || which == "eta") benchEta(sizeArg(argc, argv, 200000));
+    if (all || which == "prep") benchPrep(sizeArg(argc, argv, 20000));
+    if (all || which == "events") benchEvents(sizeArg(argc, argv, 100000));
+    if (all || which == "snapshot") benchSnapshot(sizeArg(argc, argv, 200000));
+    if (all || which == "replication") benchReplication(sizeArg(argc, argv, 3000));
+    if (all || which == "shards") benchShards(sizeArg(argc, argv, 100000));
+    if (all || which == "render") benchRender(sizeArg(argc, argv, 100000));
+    if (all || which == "service") benchService(sizeArg(argc, argv, 2000));
+    if (all || which == "journal") benchJournal(sizeArg(argc, argv, 100000));
+    if (all || which == "archive") benchArchive(sizeArg(argc, argv, 200000));
+    if (all || which == "export") benchExport(sizeArg(argc, argv, 300000));
+    if (all || which == "registry") benchRegistry(sizeArg(argc, argv, 500000));
+    return 0;
+}
@@ -1,243 +1,789 @@
+#include <algorithm>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <utility>
 #include <vector>
 
+#include "OrderArchive.h"
+#include "OrderExport.h"
 #include "OrderManager.h"
 #include "Persistence.h"
+#include "Replication.h"
+#include "TicketJournal.h"
+#include "TableRenderer.h"
 #include "CliUtils.h"
 
 namespace {
-void printPathSuggestion(OrderManager& manager, OrderStatus from, OrderStatus to) {
-    auto path = manager.shortestPath(from, to);
+void printPathSuggestion(OrderManager& manager, const Order& order, int toStage) {
+    const WorkflowEngine& wf = manager.workflow();
+    int from = WorkflowEngine::stageOf(order);
+    auto path = manager.shortestPath(from, toStage);
     if (path.empty()) {
-        std::cout << "No allowed path from " << OrderStatusStrings::toString(from)
-                  << " to " << OrderStatusStrings::toString(to) << ".\n";
+        std::cout << "No allowed path from " << wf.stateName(from)
+                  << " to " << wf.stateName(toStage) << ".\n";
         return;
     }
     std::cout << "Allowed path: ";
     for (size_t i = 0; i < path.size(); ++i) {
-        std::cout << OrderStatusStrings::toString(path[i]);
+        std::cout << wf.stateName(path[i]);
         if (i + 1 < path.size()) std::cout << " -> ";
     }
     std::cout << "\n";
 }
+
+int stageOf(OrderStatus status) {
+    return static_cast<int>(status);
 }
 
-int main() {
+/**
+ * Command pipeline state. Sources feed lines to sessions on the event loop, commands run against
+ * the manager on the loop thread, and file I/O is awaited on the worker pool, serialized through
+ * ioLane so saves and loads land in the order they were issued.
+ */
+struct App {
+    /** Clock chosen with --clock (declared first: the manager reads it until destroyed); nullptr = system clock. */
+    std::unique_ptr<ServiceClock> clock;
+    /** The same clock when it is virtual, for the clock command to advance. */
+    VirtualClock* virtualClock{nullptr};
     OrderManager manager;
+    EventLoop loop;
+    AsyncMutex ioLane{loop};
+    OrderEventRing* display{nullptr};
     const std::string defaultPath = "db.json";
+    const std::string defaultSegmentsDir = "db.segments";
+    size_t backgroundJobs{0};
+    bool quitting{false};
+    /** Mutation log streamed to a standby (--replicate), or nullptr. */
+    ReplicationLog* replication{nullptr};
+    /** Kitchen crash journal (--journal), or nullptr. */
+    TicketJournal* journal{nullptr};
+    /** Finished orders moved out of the live state (--archive); opened on first use. */
+    OrderArchive archive;
+    std::string archivePath = "orders.archive";
+    /** Orders table renderer and its output buffer, plus a cache for single times; reused by every command. */
+    TableRenderer renderer;
+    std::string tableText;
+    TimestampCache timestamps;
+    /**
+     * Background I/O threads. Declared last so it is destroyed, and its threads joined, before the
+     * archive, renderer, manager and loop that running jobs read and post back to.
+     */
+    WorkerPool io{2};
+};
 
-    // Auto-load from db.json on first run if present
-    Persistence::loadState(manager, "db.json");
+/** Sends the standby the whole state; loads replace it rather than replaying as mutations. */
+void resyncStandby(App& app) {
+    if (app.replication) app.replication->fullState(Persistence::renderState(app.manager.snapshot()));
+}
 
-    clearScreen();
-    std::cout << "Restaurant Management CLI (DSA edition)\n";
-    printHelp();
+void finishBackgroundJob(App& app) {
+    if (--app.backgroundJobs == 0 && app.quitting) app.loop.stop();
+}
+
+/**
+ * Serializes and writes a snapshot on the pool; intake continues meanwhile and later changes are
+ * not part of this save. A full save snapshots when the command runs; a segmented save once
+ * earlier saves are done, since it consumes their dirty marks.
+ */
+Task<> saveInBackground(App& app, std::string path, bool segments) {
+    OrderSnapshot snapshot;
+    // A save of the file recovery starts from covers the journal up to this point.
+    uint64_t journalCovered = 0;
+    if (!segments) {
+        snapshot = app.manager.snapshot();
+        if (app.journal && path == app.defaultPath) journalCovered = app.journal->sequence();
+    }
+    co_await app.ioLane.lock();
+    size_t dirty = app.manager.dirtyOrderCount();
+    size_t files = 0;
+    std::function<bool()> job;
+    if (segments) {
+        auto segmentJob = std::make_shared<Persistence::SegmentJob>(Persistence::beginSegments(app.manager, path));
+        job = [segmentJob, &files] {
+            Persistence::PendingWrites writes;
+            Persistence::renderSegments(*segmentJob, writes);
+            files = writes.size();
+            return Persistence::writeAll(writes);
+        };
+    } else {
+        job = [snapshot = std::move(snapshot), path, &files] {
+            files = 1;
+            return Persistence::writeAll({{path, Persistence::renderState(snapshot)}});
+        };
+    }
+    // Awaiters are named locals: GCC 12 mishandles non-trivial temporaries inside co_await.
+    Offload write(app.io, app.loop, std::move(job));
+    bool ok = co_await write;
+    if (!ok) {
+        if (segments) app.manager.setSegmentStore("");
+        std::cout << "\nSave to " << path << " failed.\n";
+    } else if (segments) {
+        std::cout << "\nSaved " << dirty << " changed orders to " << path << " (" << files - 1 << " files rewritten)\n";
+    } else {
+        if (journalCovered) app.journal->checkpoint(journalCovered);
+        std::cout << "\nSaved to " << path << "\n";
+    }
+    std::cout << std::flush;
+    app.ioLane.unlock();
+    finishBackgroundJob(app);
+}
+
+/** Reads on the pool, then replaces the manager state on the loop thread. */
+Task<bool> loadFromDisk(App& app, std::string path, bool segments) {
+    co_await app.ioLane.lock();
+    bool ok = false;
+    if (segments) {
+        Persistence::SegmentFiles files;
+        Offload read(app.io, app.loop, [&] { return Persistence::readSegmentFiles(path, files); });
+        ok = co_await read;
+        if (ok) Persistence::applySegments(app.manager, path, files);
+    } else {
+        std::string content;
+        Offload read(app.io, app.loop, [&] { return Persistence::readText(path, content); });
+        ok = co_await read;
+        if (ok) Persistence::applyState(app.manager, content);
+    }
+    if (ok) {
+        resyncStandby(app);
+        if (app.journal) app.journal->rebase(app.manager);
+    }
+    app.ioLane.unlock();
+    co_return ok;
+}
+
+/** Opens the archive on first use. Lookups pass create = false and skip a missing file. */
+bool openArchive(App& app, bool create) {
+    if (app.archive.isOpen()) return true;
+    if (!create && !std::filesystem::exists(app.archivePath)) return false;
+    std::string error;
+    if (app.archive.open(app.archivePath, &error)) return true;
+    std::cout << "Archive unavailable: " << error << "\n";
+    return false;
+}
 
-    while (true) {
-        std::cout << "\n> ";
-        std::string line = readLine();
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        std::string cmd;
-        ss >> cmd;
-
-        if (cmd == "help") {
-            printHelp();
-        } else if (cmd == "clear") {
-            clearScreen();
-        } else if (cmd == "new") {
-            std::string customer;
-            bool vip = false;
-            int estimate = 0;
-            std::vector<OrderItem> items;
-            if (!gatherOrderInput(manager, customer, vip, estimate, items)) {
-                std::cout << "Order creation aborted due to invalid input.\n";
-                continue;
-            }
-            OrderNode* node = manager.createOrder(customer, vip, items, estimate);
-            printOrder(node->data);
-        } else if (cmd == "edit") {
-            std::string idToken;
-            ss >> idToken;
-            int id = 0;
-            if (!parseId(idToken, id)) {
-                std::cout << "Invalid id.\n";
-                continue;
-            }
-            std::string customer;
-            bool vip = false;
-            int estimate = 0;
-            std::vector<OrderItem> items;
-            if (!gatherOrderInput(manager, customer, vip, estimate, items)) {
-                std::cout << "Edit aborted due to invalid input.\n";
-                continue;
-            }
-            if (manager.editOrder(id, customer, vip, items, estimate)) {
-                std::cout << "Order " << id << " updated.\n";
+/**
+ * Moves orders finished before `before` into the archive, written on the pool, then saves
+ * db.json without them so a restart does not bring them back. On a failed write they return
+ * to the live state.
+ */
+Task<> archiveFinished(App& app, long long before) {
+    co_await app.ioLane.lock();
+    std::vector<Order> orders;
+    size_t taken = app.manager.takeFinished(before, orders);
+    bool ok = true;
+    if (taken) {
+        std::string error;
+        size_t blocksBefore = app.archive.blocks().size();
+        uint64_t bytesBefore = app.archive.fileBytes();
+        Offload write(app.io, app.loop, [&] { return app.archive.append(orders, &error); });
+        ok = co_await write;
+        if (ok) {
+            std::cout << "Archived " << taken << " orders into " << app.archive.blocks().size() - blocksBefore << " blocks ("
+                      << app.archive.fileBytes() - bytesBefore << " bytes) in " << app.archivePath << "\n";
+        } else {
+            for (Order& o : orders) app.manager.restoreOrder(std::move(o));
+            std::cout << "Archive failed: " << error << "\n";
+        }
+    } else {
+        std::cout << "No finished orders to archive.\n";
+    }
+    app.ioLane.unlock();
+    if (!taken || !ok) co_return;
+    resyncStandby(app);
+    if (app.journal) app.journal->rebase(app.manager);
+    ++app.backgroundJobs;
+    spawn(saveInBackground(app, app.defaultPath, false));
+}
+
+/**
+ * --clock: real (default), monotonic (never steps back), warp:<rate> (monotonic, rate times real
+ * speed) or virtual[:<epoch seconds>] (stands still until `clock +<N>m`; starts at launch time).
+ */
+bool selectClock(App& app, const std::string& spec) {
+    auto colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+    std::string value = colon == std::string::npos ? "" : spec.substr(colon + 1);
+    try {
+        if (kind == "real" && value.empty()) {
+            app.clock.reset();
+        } else if (kind == "monotonic" && value.empty()) {
+            app.clock = std::make_unique<MonotonicClock>();
+        } else if (kind == "warp" && std::stod(value) > 0) {
+            app.clock = std::make_unique<MonotonicClock>(std::stod(value));
+        } else if (kind == "virtual") {
+            auto start = value.empty() ? std::chrono::system_clock::now() : TimeUtils::fromSeconds(std::stoll(value));
+            auto clock = std::make_unique<VirtualClock>(start);
+            app.virtualClock = clock.get();
+            app.clock = std::move(clock);
+        } else {
+            return false;
+        }
+    } catch (...) {
+        return false;
+    }
+    app.manager.setClock(app.clock.get());
+    return true;
+}
+
+/** Parses and runs one command line; prompts read follow-up lines from in. False ends the session. */
+Task<bool> execute(App& app, CommandSource& in, const std::string& line) {
+    OrderManager& manager = app.manager;
+    std::stringstream ss(line);
+    std::string cmd;
+    ss >> cmd;
+
+    if (cmd == "help") {
+        printHelp();
+    } else if (cmd == "clear") {
+        clearScreen();
+    } else if (cmd == "new") {
+        std::string customer;
+        bool vip = false;
+        int estimate = 0;
+        std::vector<OrderItem> items;
+        if (!co_await gatherOrderInput(in, manager, customer, vip, estimate, items)) {
+            std::cout << "Order creation aborted due to invalid input.\n";
+            co_return true;
+        }
+        printOrder(*manager.getOrder(manager.createOrder(std::move(customer), vip, std::move(items), estimate)));
+    } else if (cmd == "edit") {
+        std::string idToken;
+        ss >> idToken;
+        int id = 0;
+        if (!parseId(idToken, id)) {
+            std::cout << "Invalid id.\n";
+            co_return true;
+        }
+        std::string customer;
+        bool vip = false;
+        int estimate = 0;
+        std::vector<OrderItem> items;
+        if (!co_await gatherOrderInput(in, manager, customer, vip, estimate, items)) {
+            std::cout << "Edit aborted due to invalid input.\n";
+            co_return true;
+        }
+        if (manager.editOrder(id, std::move(customer), vip, std::move(items), estimate)) {
+            std::cout << "Order " << id << " updated.\n";
+        } else {
+            std::cout << "Unable to edit order.\n";
+        }
+    } else if (cmd == "advance") {
+        std::string idToken, stageName;
+        ss >> idToken >> stageName;
+        int id = 0;
+        if (!parseId(idToken, id)) {
+            std::cout << "Usage: advance <id> <STAGE>\n";
+            co_return true;
+        }
+        Order* o = manager.getOrder(id);
+        int stage = manager.workflow().stateId(stageName);
+        if (!o || stage < 0) {
+            std::cout << (o ? "Unknown stage.\n" : "Not found.\n");
+            co_return true;
+        }
+        if (manager.advanceOrder(id, stage)) {
+            std::cout << "Order " << id << " " << stageName << ".\n";
+        } else {
+            std::cout << "Unable to move order to " << stageName << ".\n";
+            printPathSuggestion(manager, *o, stage);
+        }
+    } else if (cmd == "events") {
+        printEvents(manager.workflow(), *app.display);
+    } else if (cmd == "workflow") {
+        printWorkflow(manager.workflow());
+    } else if (cmd == "next") {
+        int nextId = 0;
+        if (manager.nextForKitchen(nextId)) {
+            std::cout << "Next order: " << nextId << " now PREPPING\n";
+        } else {
+            std::cout << "No orders pending.\n";
+        }
+    } else if (cmd == "start" || cmd == "ready" || cmd == "serve" || cmd == "cancel" || cmd == "show") {
+        std::string idToken;
+        ss >> idToken;
+        int id = 0;
+        if (!parseId(idToken, id)) {
+            std::cout << "Invalid id.\n";
+            co_return true;
+        }
+        Order* o = manager.getOrder(id);
+        if (!o) {
+            std::cout << "Not found.\n";
+            co_return true;
+        }
+        if (cmd == "start") {
+            if (manager.startOrder(id)) {
+                std::cout << "Order " << id << " PREPPING.\n";
             } else {
-                std::cout << "Unable to edit order.\n";
+                std::cout << "Unable to start order.\n";
+                printPathSuggestion(manager, *o, stageOf(OrderStatus::Prepping));
             }
-        } else if (cmd == "next") {
-            int nextId = 0;
-            if (manager.nextForKitchen(nextId)) {
-                std::cout << "Next order: " << nextId << " now PREPPING\n";
+        } else if (cmd == "ready") {
+            if (manager.readyOrder(id)) {
+                std::cout << "Order " << id << " READY.\n";
             } else {
-                std::cout << "No orders pending.\n";
-            }
-        } else if (cmd == "start" || cmd == "ready" || cmd == "serve" || cmd == "cancel" || cmd == "show") {
-            std::string idToken;
-            ss >> idToken;
-            int id = 0;
-            if (!parseId(idToken, id)) {
-                std::cout << "Invalid id.\n";
-                continue;
-            }
-            Order* o = manager.getOrder(id);
-            if (!o) {
-                std::cout << "Not found.\n";
-                continue;
-            }
-            if (cmd == "start") {
-                if (manager.startOrder(id)) {
-                    std::cout << "Order " << id << " PREPPING.\n";
-                } else {
-                    std::cout << "Unable to start order.\n";
-                    printPathSuggestion(manager, o->status, OrderStatus::Prepping);
-                }
-            } else if (cmd == "ready") {
-                if (manager.readyOrder(id)) {
-                    std::cout << "Order " << id << " READY.\n";
-                } else {
-                    std::cout << "Unable to mark ready.\n";
-                    printPathSuggestion(manager, o->status, OrderStatus::Ready);
-                }
-            } else if (cmd == "serve") {
-                if (manager.serveOrder(id)) {
-                    std::cout << "Order " << id << " SERVED.\n";
-                } else {
-                    std::cout << "Unable to serve.\n";
-                    printPathSuggestion(manager, o->status, OrderStatus::Served);
-                }
-            } else if (cmd == "cancel") {
-                if (manager.cancelOrder(id)) {
-                    std::cout << "Order " << id << " cancelled.\n";
-                } else {
-                    std::cout << "Unable to cancel.\n";
-                    printPathSuggestion(manager, o->status, OrderStatus::Cancelled);
-                }
-            } else if (cmd == "show") {
-                printOrder(*o);
-            }
-        } else if (cmd == "list") {
-            std::string statusToken;
-            ss >> statusToken;
-            if (statusToken.empty()) {
-                auto all = manager.snapshotAll();
-                sortOrders(all, "placed");
-                printOrdersTable(all);
+                std::cout << "Unable to mark ready.\n";
+                printPathSuggestion(manager, *o, stageOf(OrderStatus::Ready));
+            }
+        } else if (cmd == "serve") {
+            if (manager.serveOrder(id)) {
+                std::cout << "Order " << id << " SERVED.\n";
             } else {
+                std::cout << "Unable to serve.\n";
+                printPathSuggestion(manager, *o, stageOf(OrderStatus::Served));
+            }
+        } else if (cmd == "cancel") {
+            if (manager.cancelOrder(id)) {
+                std::cout << "Order " << id << " cancelled.\n";
+            } else {
+                std::cout << "Unable to cancel.\n";
+                printPathSuggestion(manager, *o, stageOf(OrderStatus::Cancelled));
+            }
+        } else if (cmd == "show") {
+            printOrder(*o);
+            if (o->stage >= 0) {
+                std::cout << "  Stage: " << manager.workflow().stateName(o->stage) << "\n";
+            }
+            std::chrono::system_clock::time_point eta;
+            bool pending = o->status == OrderStatus::Placed || o->status == OrderStatus::Queued || o->status == OrderStatus::Prepping;
+            if (pending && manager.projectedReadyAt(id, eta)) {
+                char text[TimestampCache::kWidth];
+                size_t len = app.timestamps.format(TimeUtils::toSeconds(eta), text);
+                auto minutes = std::chrono::duration_cast<std::chrono::minutes>(eta - manager.now()).count();
+                std::cout << "  ETA: " << std::string(text, len) << " (in ~" << (minutes > 0 ? minutes : 0) << " min)\n";
+            }
+        }
+    } else if (cmd == "list" || cmd == "report") {
+        std::vector<std::string> args;
+        std::string token;
+        while (ss >> token) args.push_back(token);
+        ListQuery query;
+        std::string which;
+        if (!parseListOptions(manager, args, query, which)) {
+            co_return true;
+        }
+        if (cmd == "list") {
+            if (!which.empty()) {
                 OrderStatus status;
-                if (!OrderStatusStrings::fromString(statusToken, status)) {
+                if (!OrderStatusStrings::fromString(which, status)) {
                     std::cout << "Unknown status token.\n";
-                    continue;
+                    co_return true;
                 }
-                auto orders = manager.listByStatus(status);
-                sortOrders(orders, "placed");
-                printOrdersTable(orders);
-            }
-        } else if (cmd == "report") {
-            std::string which;
-            ss >> which;
-            if (which == "active") {
-                auto active = manager.listByStatus(OrderStatus::Placed);
-                auto queued = manager.listByStatus(OrderStatus::Queued);
-                auto prepping = manager.listByStatus(OrderStatus::Prepping);
-                auto ready = manager.listByStatus(OrderStatus::Ready);
-                active.insert(active.end(), queued.begin(), queued.end());
-                active.insert(active.end(), prepping.begin(), prepping.end());
-                active.insert(active.end(), ready.begin(), ready.end());
-                sortOrders(active, "placed");
-                printOrdersTable(active);
-            } else if (which == "completed") {
-                auto done = manager.listByStatus(OrderStatus::Served);
-                sortOrders(done, "served");
-                printOrdersTable(done);
-            } else {
-                std::cout << "Usage: report active|completed\n";
-            }
-        } else if (cmd == "find") {
-            std::string idToken;
-            ss >> idToken;
-            int id = 0;
-            if (!parseId(idToken, id)) {
-                std::cout << "Invalid id.\n";
-                continue;
-            }
-            Order* o = manager.getOrder(id);
-            if (o) printOrder(*o); else std::cout << "Not found.\n";
-        } else if (cmd == "menu") {
-            std::string sub;
-            ss >> sub;
-            if (sub == "add") {
-                std::string name;
-                std::cout << "Menu name: ";
-                name = readLine();
-                if (name.empty()) {
-                    std::cout << "Name required.\n";
-                    continue;
-                }
-                int prep = 0;
-                if (!readPositiveInt("Default prep minutes: ", prep)) {
-                    std::cout << "Menu add aborted.\n";
-                    continue;
-                }
-                int assigned = manager.addMenuItem(name, prep);
-                if (assigned > 0) std::cout << "Menu item added with id " << assigned << ".\n"; else std::cout << "Duplicate item name or invalid data.\n";
-            } else if (sub == "remove") {
-                std::string name;
-                std::cout << "Menu name: ";
-                name = readLine();
-                if (manager.removeMenuItem(name)) std::cout << "Removed.\n"; else std::cout << "Not found.\n";
-            } else if (sub == "find") {
-                std::string name;
-                std::cout << "Menu name: ";
-                name = readLine();
-                MenuItem* item = manager.findMenuItem(name);
-                if (item) {
-                    std::cout << "Item " << item->itemId << " | " << item->name << " | prep: " << item->defaultPrepMinutes << " min\n";
-                } else {
-                    std::cout << "Not found.\n";
-                }
-            } else if (sub == "list") {
-                auto items = manager.listMenuItems();
-                printMenuTable(items);
+                query.statusMask = ListQuery::maskOf(status);
+            }
+        } else if (which == "active") {
+            query.statusMask = ListQuery::maskOf(OrderStatus::Placed) | ListQuery::maskOf(OrderStatus::Queued)
+                             | ListQuery::maskOf(OrderStatus::Prepping) | ListQuery::maskOf(OrderStatus::Ready);
+        } else if (which == "completed") {
+            query.statusMask = ListQuery::maskOf(OrderStatus::Served);
+            query.byServed = true;
+        } else {
+            std::cout << "Usage: report active|completed [--limit N] [--newest] [--after <id>]\n";
+            co_return true;
+        }
+        // Read on the pool from a snapshot, so a long report never stalls other sources. A time
+        // window is resolved here from the live time index, so only its slice is read.
+        int nextAfterId = 0;
+        std::vector<Order> orders;
+        bool windowed = query.since != 0 || query.until != 0;
+        Offload scan(app.io, app.loop, [snapshot = manager.snapshot(), window = manager.windowIds(query), windowed, &query, &orders, &nextAfterId] {
+            orders = OrderManager::listPage(snapshot, query, &nextAfterId, windowed ? &window : nullptr);
+            return true;
+        });
+        co_await scan;
+        printOrdersTable(app.renderer, app.tableText, orders);
+        if (nextAfterId != 0) {
+            std::cout << "More orders: repeat with --after " << nextAfterId << "\n";
+        }
+    } else if (cmd == "find") {
+        std::string idToken;
+        ss >> idToken;
+        if (idToken == "name") {
+            std::string prefix;
+            std::getline(ss >> std::ws, prefix);
+            if (prefix.empty()) {
+                std::cout << "Usage: find name <prefix>\n";
+                co_return true;
+            }
+            bool fuzzy = false;
+            auto matches = manager.findByCustomer(prefix, 50, &fuzzy);
+            // Historical orders: the archive keeps its own name index. Closest names are only
+            // shown when neither side has a prefix match.
+            std::vector<Order> archived;
+            bool archivedFuzzy = false;
+            if (openArchive(app, false)) {
+                co_await app.ioLane.lock();
+                Offload lookup(app.io, app.loop, [&] {
+                    archived = app.archive.findByCustomer(prefix, 50, fuzzy, &archivedFuzzy);
+                    return true;
+                });
+                co_await lookup;
+                app.ioLane.unlock();
+            }
+            if (fuzzy && !archived.empty() && !archivedFuzzy) {
+                matches.clear();
+                fuzzy = false;
+            }
+            if (matches.empty() && archived.empty()) {
+                std::cout << "No customer matches.\n";
+                co_return true;
+            }
+            if (fuzzy) std::cout << "No exact prefix match; closest names:\n";
+            if (!matches.empty()) printOrdersTable(app.renderer, app.tableText, matches);
+            if (!archived.empty()) {
+                std::cout << "Archived:\n";
+                printOrdersTable(app.renderer, app.tableText, archived);
+            }
+            co_return true;
+        }
+        int id = 0;
+        if (!parseId(idToken, id)) {
+            std::cout << "Invalid id.\n";
+            co_return true;
+        }
+        Order* o = manager.getOrder(id);
+        if (o) {
+            printOrder(*o);
+            co_return true;
+        }
+        // Historical orders: only archive blocks whose id range holds id are read.
+        Order archived;
+        bool found = false;
+        if (openArchive(app, false)) {
+            co_await app.ioLane.lock();
+            Offload lookup(app.io, app.loop, [&] { return app.archive.find(id, archived); });
+            found = co_await lookup;
+            app.ioLane.unlock();
+        }
+        if (found) {
+            printOrder(archived);
+            std::cout << "  (archived)\n";
+        } else {
+            std::cout << "Not found.\n";
+        }
+    } else if (cmd == "menu") {
+        std::string sub;
+        ss >> sub;
+        if (sub == "add") {
+            std::string name;
+            std::cout << "Menu name: ";
+            name = co_await readLine(in);
+            if (name.empty()) {
+                std::cout << "Name required.\n";
+                co_return true;
+            }
+            int prep = 0;
+            if (!co_await readPositiveInt(in, "Default prep minutes: ", prep)) {
+                std::cout << "Menu add aborted.\n";
+                co_return true;
+            }
+            int assigned = manager.addMenuItem(name, prep);
+            if (assigned > 0) std::cout << "Menu item added with id " << assigned << ".\n"; else std::cout << "Duplicate item name or invalid data.\n";
+        } else if (sub == "remove") {
+            std::string name;
+            std::cout << "Menu name: ";
+            name = co_await readLine(in);
+            if (manager.removeMenuItem(name)) std::cout << "Removed.\n"; else std::cout << "Not found.\n";
+        } else if (sub == "find") {
+            std::string name;
+            std::cout << "Menu name: ";
+            name = co_await readLine(in);
+            MenuItem* item = manager.findMenuItem(name);
+            if (item) {
+                std::cout << "Item " << item->itemId << " | " << item->name << " | prep: " << item->defaultPrepMinutes << " min\n";
             } else {
-                std::cout << "Usage: menu add|remove|find|list\n";
+                std::cout << "Not found.\n";
             }
-        } else if (cmd == "save" || cmd == "load") {
-            std::string path;
+        } else if (sub == "list") {
+            auto items = manager.listMenuItems();
+            printMenuTable(items);
+        } else {
+            std::cout << "Usage: menu add|remove|find|list\n";
+        }
+    } else if (cmd == "save" || cmd == "load") {
+        std::string path;
+        ss >> path;
+        bool segments = path == "--segments";
+        if (segments) {
+            path.clear();
             ss >> path;
-            if (path.empty()) path = defaultPath;
-            if (cmd == "save") {
-                if (Persistence::saveState(manager, path)) {
-                    std::cout << "Saved to " << path << "\n";
-                } else {
-                    std::cout << "Save failed.\n";
-                }
+            if (path.empty()) path = app.defaultSegmentsDir;
+        } else if (path.empty()) {
+            path = app.defaultPath;
+        }
+        if (cmd == "save") {
+            // Saves run in the background; a later load waits for them through the I/O lane
+            ++app.backgroundJobs;
+            spawn(saveInBackground(app, path, segments));
+            std::cout << "Saving to " << path << " in the background.\n";
+        } else if (co_await loadFromDisk(app, path, segments)) {
+            std::cout << "Loaded from " << path << "\n";
+        } else {
+            std::cout << "Load failed.\n";
+        }
+    } else if (cmd == "archive") {
+        std::string sub;
+        ss >> sub;
+        std::vector<std::string> args;
+        std::string token;
+        while (ss >> token) args.push_back(token);
+        if (sub.empty() || sub == "--before") {
+            long long before = TimeUtils::toSeconds(manager.now()) + 1;
+            if (sub == "--before" && (args.size() != 1 || !parseTimeToken(args[0], before - 1, before))) {
+                std::cout << "Usage: archive [--before HH:MM|-<N>m|-<N>h|epoch]\n";
+                co_return true;
+            }
+            if (openArchive(app, true)) co_await archiveFinished(app, before);
+        } else if (sub == "report") {
+            ListQuery query;
+            std::string extra;
+            if (!parseListOptions(manager, args, query, extra)) co_return true;
+            if (!extra.empty() || query.afterId != 0) {
+                std::cout << "Usage: archive report [--since <time>] [--until <time>] [--served] [--newest] [--limit N]\n";
+                co_return true;
+            }
+            if (!openArchive(app, false)) {
+                std::cout << "No archive at " << app.archivePath << ".\n";
+                co_return true;
+            }
+            // Blocks outside the window are skipped by their index entry, never read.
+            std::vector<Order> orders;
+            size_t blocksRead = 0;
+            co_await app.ioLane.lock();
+            Offload scan(app.io, app.loop, [&] {
+                blocksRead = app.archive.forEachInRange(query.since, query.until, query.byServed, [&](const Order& o) { orders.push_back(o); });
+                sortOrders(orders, query.byServed ? "served" : "placed");
+                if (query.newestFirst) std::reverse(orders.begin(), orders.end());
+                if (query.limit && orders.size() > query.limit) orders.resize(query.limit);
+                return true;
+            });
+            co_await scan;
+            size_t blocks = app.archive.blocks().size();
+            app.ioLane.unlock();
+            printOrdersTable(app.renderer, app.tableText, orders);
+            std::cout << "Read " << blocksRead << " of " << blocks << " archive blocks.\n";
+        } else if (sub == "stats") {
+            if (!openArchive(app, false)) {
+                std::cout << "No archive at " << app.archivePath << ".\n";
+                co_return true;
+            }
+            // An archive run on the pool may be appending; read the counters under the lane.
+            co_await app.ioLane.lock();
+            uint64_t count = app.archive.orderCount();
+            size_t blocks = app.archive.blocks().size();
+            uint64_t bytes = app.archive.fileBytes();
+            app.ioLane.unlock();
+            std::cout << "Archive " << app.archivePath << ": " << count << " orders in " << blocks << " blocks, " << bytes << " bytes";
+            if (count) std::cout << " (" << bytes / count << " bytes per order)";
+            std::cout << "\n";
+        } else {
+            std::cout << "Usage: archive [--before <time>] | archive report [options] | archive stats\n";
+        }
+    } else if (cmd == "export") {
+        std::string format;
+        ss >> format;
+        OrderExport::Options options;
+        options.format = format == "columnar" ? OrderExport::Format::Columnar : OrderExport::Format::Csv;
+        bool withArchive = true;
+        bool valid = format == "csv" || format == "columnar";
+        std::string path;
+        std::string token;
+        while (valid && ss >> token) {
+            int threads = 0;
+            if (token == "--no-archive") {
+                withArchive = false;
+            } else if (token == "--threads" && ss >> token && parseId(token, threads)) {
+                options.threads = static_cast<unsigned>(threads);
+            } else if (path.empty() && token[0] != '-') {
+                path = token;
             } else {
-                if (Persistence::loadState(manager, path)) {
-                    std::cout << "Loaded from " << path << "\n";
-                } else {
-                    std::cout << "Load failed.\n";
-                }
+                valid = false;
             }
-        } else if (cmd == "exit" || cmd == "quit") {
-            std::cout << "Goodbye.\n";
-            break;
+        }
+        if (!valid) {
+            std::cout << "Usage: export csv|columnar [path] [--no-archive] [--threads N]\n";
+            co_return true;
+        }
+        if (path.empty()) path = format == "csv" ? "orders.csv" : "orders.ocol";
+        const OrderArchive* archive = withArchive && openArchive(app, false) ? &app.archive : nullptr;
+        // Streamed from a snapshot on the pool: intake continues and memory stays at a few chunks.
+        OrderExport::Stats stats;
+        std::string error;
+        auto start = std::chrono::steady_clock::now();
+        co_await app.ioLane.lock();
+        Offload run(app.io, app.loop, [snapshot = manager.snapshot(), archive, &path, &options, &stats, &error] {
+            return OrderExport::write(snapshot, archive, path, options, &stats, &error);
+        });
+        bool ok = co_await run;
+        app.ioLane.unlock();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        if (ok) {
+            std::cout << "Exported " << stats.rows << " orders (" << stats.archivedRows << " archived) to " << path << ": "
+                      << stats.bytes << " bytes in " << stats.chunks << " chunks, " << ms << " ms\n";
         } else {
-            std::cout << "Unknown command. Type 'help'.\n";
+            std::cout << "Export failed: " << error << "\n";
+        }
+    } else if (cmd == "clock") {
+        std::string step;
+        ss >> step;
+        if (!step.empty()) {
+            long long seconds = 0;
+            if (!app.virtualClock || !parseDuration(step, seconds)) {
+                std::cout << (app.virtualClock ? "Usage: clock +<N>s|m|h\n" : "Only a virtual clock (--clock virtual) can be advanced.\n");
+                co_return true;
+            }
+            app.virtualClock->advance(std::chrono::seconds(seconds));
         }
+        char text[TimestampCache::kWidth];
+        size_t len = app.timestamps.format(TimeUtils::toSeconds(manager.now()), text);
+        std::cout << "Clock: " << std::string(text, len) << "\n";
+    } else if (cmd == "exit" || cmd == "quit") {
+        co_return false;
+    } else {
+        std::cout << "Unknown command. Type 'help'.\n";
     }
+    co_return true;
+}
+
+/**
+ * One session per source. The console prompts and quits the program on exit or end of input;
+ * feeds echo their commands with the source name and simply end.
+ */
+Task<> runSession(App& app, CommandSource& in, bool console) {
+    while (!app.quitting) {
+        if (console) std::cout << "\n> " << std::flush;
+        auto line = co_await in.nextLine();
+        if (!line) break;
+        if (line->empty()) continue;
+        if (!console) std::cout << "\n[" << in.name() << "] " << *line << "\n";
+        bool keepGoing = co_await execute(app, in, *line);
+        std::cout << std::flush;
+        if (!keepGoing) break;
+    }
+    if (console) {
+        std::cout << "Goodbye.\n" << std::flush;
+        app.quitting = true;
+        // Pending saves finish before the loop stops
+        if (app.backgroundJobs == 0) app.loop.stop();
+    }
+}
+}
+
+int main(int argc, char** argv) {
+    App app;
+    const std::string defaultWorkflowPath = "workflow.cfg";
+
+    // Site-specific workflow, if present, must be in place before orders with custom stages load
+    std::string workflowError;
+    if (!app.manager.loadWorkflow(defaultWorkflowPath, workflowError) && workflowError.rfind("cannot open", 0) != 0) {
+        std::cout << "Ignoring " << defaultWorkflowPath << ": " << workflowError << "\n";
+    }
+
+    std::vector<std::string> feedPaths;
+    std::string replicateTo;
+    std::string standbyOn;
+    std::string journalPath;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--feed" && i + 1 < argc) {
+            feedPaths.push_back(argv[++i]);
+        } else if (arg == "--replicate" && i + 1 < argc) {
+            replicateTo = argv[++i];
+        } else if (arg == "--standby" && i + 1 < argc) {
+            standbyOn = argv[++i];
+        } else if (arg == "--clock" && i + 1 < argc && selectClock(app, argv[i + 1])) {
+            ++i;
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journalPath = argv[++i];
+        } else if (arg == "--archive" && i + 1 < argc) {
+            app.archivePath = argv[++i];
+        } else {
+            std::cout << "Usage: restaurant [--feed <path>]... [--standby <socket>] [--replicate <socket>] [--journal <path>]\n"
+                      << "                  [--archive <path>] [--clock real|monotonic|warp:<rate>|virtual[:<epoch seconds>]]\n";
+            return 1;
+        }
+    }
+
+    if (!standbyOn.empty()) {
+        // Hot standby: mirror the primary until it goes away, then take over with the warm state.
+        std::cout << "Standby: waiting for the primary on " << standbyOn << "...\n" << std::flush;
+        ReplicaStats stats;
+        if (!Replication::runStandby(app.manager, standbyOn, stats)) {
+            std::cout << "Replication stream failed; taking over with the state received so far.\n";
+        }
+        double meanMicros = stats.records ? static_cast<double>(stats.lagTotalNanos) / 1000.0 / static_cast<double>(stats.records) : 0.0;
+        std::cout << "Primary gone after " << stats.records << " records (" << stats.failed << " not applied, lag mean "
+                  << meanMicros << " us, max " << stats.lagMaxNanos / 1000 << " us); taking over with "
+                  << app.manager.activeCount() << " orders.\n";
+    } else {
+        // Auto-load from db.json on first run if present
+        Persistence::loadState(app.manager, app.defaultPath);
+    }
+    TicketJournal journal;
+    if (!journalPath.empty()) {
+        std::string error;
+        if (!journal.open(journalPath, TicketJournal::kDefaultCapacity, &error)) {
+            std::cout << "Journal disabled: " << error << "\n";
+        } else if (!standbyOn.empty()) {
+            // The replicated state is newer than anything journaled before the takeover.
+            journal.rebase(app.manager);
+            app.manager.setTicketJournal(&journal);
+            app.journal = &journal;
+        } else {
+            // Replays the kitchen since the last save of db.json (loaded above).
+            auto start = std::chrono::steady_clock::now();
+            KitchenState kitchen;
+            journal.recover(kitchen);
+            size_t unknown = kitchen.tickets.empty() ? 0 : app.manager.recoverKitchen(kitchen);
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+            if (!kitchen.tickets.empty()) {
+                std::cout << "Journal: recovered " << kitchen.queue.size() + kitchen.waitingVips << " waiting and " << kitchen.inFlight
+                          << " in-kitchen tickets in " << micros << " us";
+                if (unknown) std::cout << "; " << unknown << " open orders from the save have no ticket";
+                if (kitchen.overflows) std::cout << "; the journal overflowed " << kitchen.overflows << " times";
+                std::cout << "\n";
+            }
+            journal.attach(app.manager);
+            app.journal = &journal;
+        }
+    }
+
+    // Feed for the `events` command; other displays subscribe their own rings
+    app.display = app.manager.subscribe(256);
+
+    ReplicationLog replicationLog;
+    std::unique_ptr<ReplicationSender> sender;
+    if (!replicateTo.empty()) {
+        app.replication = &replicationLog;
+        app.manager.setReplicationLog(&replicationLog);
+        // Each (re)connected standby starts from a full state rendered on the loop thread.
+        sender = std::make_unique<ReplicationSender>(replicationLog, replicateTo, [&app] {
+            app.loop.post([&app] { resyncStandby(app); });
+        });
+    }
+
+    if (standbyOn.empty()) clearScreen();
+    std::cout << "Restaurant Management CLI (DSA edition)\n";
+    printHelp();
+
+    // Extra command sources (files or FIFOs, e.g. an online ordering bridge) run alongside the console
+    std::vector<std::unique_ptr<CommandSource>> feeds;
+    for (const auto& path : feedPaths) {
+        auto feed = std::make_unique<CommandSource>(app.loop, path);
+        if (!feed->open(path)) {
+            std::cout << "Cannot open feed " << path << "\n";
+            continue;
+        }
+        spawn(runSession(app, *feed, false));
+        feeds.push_back(std::move(feed));
+    }
+
+    CommandSource console(app.loop, "console");
+    spawn(runSession(app, console, true));
+    console.start(std::cin);
+    app.loop.run();
     return 0;
 }
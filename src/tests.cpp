@@ -0,0 +1,1557 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <set>
+#include <source_location>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Clock.h"
+#include "CustomerIndex.h"
+#include "Heap.h"
+#include "LinkedList.h"
+#include "MenuBST.h"
+#include "Order.h"
+#include "OrderArchive.h"
+#include "OrderExport.h"
+#include "OrderManager.h"
+#include "OrderRegistry.h"
+#include "Persistence.h"
+#include "Queue.h"
+#include "Replication.h"
+#include "ShardedManager.h"
+#include "Sorts.h"
+#include "TableRenderer.h"
+#include "TicketJournal.h"
+
+// Global allocation counter for the allocation budget suite. Sanitizer builds keep their own
+// operator new (its nothrow and array forms would not pair with these), and skip that suite.
+#ifndef __SANITIZE_ADDRESS__
+namespace {
+std::atomic<size_t> gAllocations{0};
+}
+
+void* operator new(std::size_t size) {
+    ++gAllocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+// GCC flags malloc/free inside replaced global operators once they are inlined into std::allocator.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+// Property tests: every structure runs long random operation sequences next to a reference STL
+// model and must agree with it after each step.
+// Usage: restaurant_tests [scale] [seed] [suite]. scale multiplies the operation counts (default 1
+// = a few million operations in total); a suite name runs only that suite.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+size_t gChecks = 0;
+size_t gFailures = 0;
+
+/** Records one assertion; prints the first failures with their location. */
+bool check(bool ok, const char* what, std::source_location where = std::source_location::current()) {
+    ++gChecks;
+    if (!ok) {
+        if (++gFailures <= 20) {
+            std::cout << "  FAILED: " << what << " (" << where.file_name() << ":" << where.line() << ")\n";
+        }
+    }
+    return ok;
+}
+
+struct Options {
+    size_t scale{1};
+    unsigned seed{20240601};
+};
+
+std::string randomName(std::mt19937& rng, size_t keySpace) {
+    return "item-" + std::to_string(rng() % keySpace);
+}
+
+void testIntQueue(const Options& opt) {
+    std::mt19937 rng(opt.seed);
+    const size_t ops = 2000000 * opt.scale;
+    // Small initial capacities exercise wrap-around and growth; 0 is the degenerate case.
+    for (size_t capacity : {size_t{0}, size_t{1}, size_t{3}, size_t{128}}) {
+        IntQueue queue(capacity);
+        std::deque<int> model;
+        bool ok = true;
+        for (size_t i = 0; i < ops / 4 && ok; ++i) {
+            // Bias toward growth in the first half and draining in the second.
+            unsigned pushPercent = i < ops / 8 ? 60 : 40;
+            unsigned roll = rng() % 100;
+            if (roll < pushPercent) {
+                int value = static_cast<int>(rng());
+                if (roll % 8 == 0) {
+                    ok = check(queue.pushFront(value), "pushFront succeeds");
+                    model.push_front(value);
+                } else {
+                    ok = check(queue.enqueue(value), "enqueue succeeds");
+                    model.push_back(value);
+                }
+            } else {
+                int out = 0;
+                bool got = queue.dequeue(out);
+                ok = check(got == !model.empty(), "dequeue succeeds iff non-empty");
+                if (got && !model.empty()) {
+                    ok = check(out == model.front(), "dequeue returns FIFO head") && ok;
+                    model.pop_front();
+                }
+            }
+            ok = check(queue.size() == model.size(), "size matches model") && ok;
+            if (i % 4096 == 0) {
+                auto snap = queue.snapshot();
+                ok = check(std::equal(snap.begin(), snap.end(), model.begin(), model.end()), "snapshot matches model") && ok;
+            }
+        }
+        // reserve keeps contents and order.
+        queue.reserve(queue.size() * 3 + 17);
+        auto snap = queue.snapshot();
+        check(std::equal(snap.begin(), snap.end(), model.begin(), model.end()), "reserve preserves contents");
+    }
+}
+
+void testVipHeap(const Options& opt) {
+    std::mt19937 rng(opt.seed + 1);
+    const size_t ops = 1000000 * opt.scale;
+    VipHeap heap;
+    // Ordered by (placedAtNanos, orderId): the model's begin() is what pop must return.
+    std::set<std::pair<long long, int>> model;
+    int nextId = 1;
+    auto entry = [&]() {
+        // Few distinct times, so ties (broken by id) are common.
+        return VipEntry{nextId++, static_cast<long long>(rng() % 64)};
+    };
+    bool ok = true;
+    for (size_t i = 0; i < ops && ok; ++i) {
+        // Grow during the first half, drain during the second.
+        unsigned op = rng() % 100;
+        unsigned pushPercent = i < ops / 2 ? 50 : 25;
+        if (op < pushPercent) {
+            VipEntry e = entry();
+            heap.push(e);
+            model.emplace(e.placedAtNanos, e.orderId);
+        } else if (op < pushPercent + 3) {
+            std::vector<VipEntry> batch(rng() % 32);
+            for (auto& e : batch) {
+                e = entry();
+                model.emplace(e.placedAtNanos, e.orderId);
+            }
+            heap.pushMany(batch);
+        } else {
+            VipEntry out{};
+            bool got = heap.pop(out);
+            ok = check(got == !model.empty(), "pop succeeds iff non-empty");
+            if (got && !model.empty()) {
+                ok = check(std::make_pair(out.placedAtNanos, out.orderId) == *model.begin(), "pop returns earliest, lowest id on ties") && ok;
+                model.erase(model.begin());
+            }
+        }
+        ok = check(heap.size() == model.size(), "size matches model") && ok;
+    }
+    auto ids = heap.snapshotIds();
+    std::vector<int> expected;
+    for (const auto& e : model) expected.push_back(e.second);
+    std::sort(ids.begin(), ids.end());
+    std::sort(expected.begin(), expected.end());
+    check(ids == expected, "snapshotIds holds exactly the remaining entries");
+}
+
+void testOrderList(const Options& opt) {
+    std::mt19937 rng(opt.seed + 2);
+    const size_t ops = 400000 * opt.scale;
+    OrderList list;
+    std::vector<int> model;
+    std::map<int, OrderNode*> nodes;
+    int nextId = 1;
+    bool ok = true;
+    for (size_t i = 0; i < ops && ok; ++i) {
+        unsigned op = rng() % 100;
+        // findById is a linear scan, so the live set stays in the hundreds.
+        if (op < 40 && model.size() < 600) {
+            Order o;
+            o.id = nextId++;
+            o.customerName = "C" + std::to_string(o.id);
+            OrderNode* node = (op % 3 == 0) ? list.pushBack(o) : (op % 3 == 1) ? list.pushBack(std::move(o)) : list.emplaceBack();
+            if (op % 3 == 2) node->data.id = nextId - 1;
+            model.push_back(nextId - 1);
+            nodes[nextId - 1] = node;
+        } else if (op < 60 && !model.empty()) {
+            size_t pick = rng() % model.size();
+            int id = model[pick];
+            ok = check(list.remove(nodes[id]), "remove by node");
+            model.erase(model.begin() + static_cast<std::ptrdiff_t>(pick));
+            nodes.erase(id);
+        } else if (op < 75) {
+            int id = 1 + static_cast<int>(rng() % static_cast<unsigned>(nextId));
+            bool present = nodes.count(id) != 0;
+            ok = check(list.removeById(id) == present, "removeById succeeds iff present");
+            if (present) {
+                model.erase(std::find(model.begin(), model.end(), id));
+                nodes.erase(id);
+            }
+        } else {
+            int id = 1 + static_cast<int>(rng() % static_cast<unsigned>(nextId));
+            OrderNode* found = list.findById(id);
+            auto it = nodes.find(id);
+            ok = check(found == (it == nodes.end() ? nullptr : it->second), "findById returns the node iff present");
+        }
+        ok = check(list.size() == model.size(), "size matches model") && ok;
+        if (i % 1024 == 0) {
+            std::vector<int> seen;
+            const OrderNode* prev = nullptr;
+            bool linked = true;
+            list.forEach([&](OrderNode* node) {
+                seen.push_back(node->data.id);
+                if (node->prev != prev) linked = false;
+                prev = node;
+            });
+            ok = check(seen == model, "forEach visits in insertion order") && ok;
+            ok = check(linked, "prev links mirror next links") && ok;
+        }
+    }
+    list.clearAll();
+    check(list.size() == 0 && list.findById(1) == nullptr, "clearAll empties the list");
+}
+
+void testOrderRegistry(const Options& opt) {
+    std::mt19937 rng(opt.seed + 14);
+    const size_t ops = 400000 * opt.scale;
+    OrderRegistry registry;
+    std::map<int, OrderHandle> live;
+    std::vector<OrderHandle> dead;
+    int nextId = 1;
+    bool ok = true;
+    auto scanIds = [&registry] {
+        std::vector<int> ids;
+        registry.forEach([&](const Order& o) { ids.push_back(o.id); });
+        return ids;
+    };
+    auto pickLive = [&]() -> std::map<int, OrderHandle>::iterator {
+        auto it = live.lower_bound(1 + static_cast<int>(rng() % static_cast<unsigned>(nextId)));
+        return it == live.end() ? live.begin() : it;
+    };
+    for (size_t i = 0; i < ops && ok; ++i) {
+        unsigned op = rng() % 100;
+        if (op < 45 && live.size() < 5000) {
+            Order o;
+            o.id = nextId++;
+            o.customerName = "C" + std::to_string(o.id);
+            live[o.id] = registry.insert(std::move(o));
+        } else if (op < 70 && !live.empty()) {
+            auto it = pickLive();
+            ok = check(registry.erase(it->second), "erase of a live handle succeeds");
+            ok = check(registry.get(it->second) == nullptr, "an erased handle stops resolving") && ok;
+            dead.push_back(it->second);
+            live.erase(it);
+        } else if (op < 75 && !dead.empty()) {
+            // Its slot may hold a newer order by now; the old generation must still miss.
+            OrderHandle stale = dead[rng() % dead.size()];
+            ok = check(!registry.erase(stale) && registry.get(stale) == nullptr, "stale handles never alias");
+        } else if (op < 76) {
+            int modulus = 2 + static_cast<int>(rng() % 5);
+            std::vector<int> expected;
+            for (int id : scanIds()) {
+                if (id % modulus != 0) expected.push_back(id);
+            }
+            size_t taken = 0;
+            size_t removed = registry.eraseIf([&](const Order& o) { return o.id % modulus == 0; }, [&](Order&& o) {
+                ok = check(o.id % modulus == 0 && o.customerName == "C" + std::to_string(o.id), "eraseIf hands over the whole order") && ok;
+                ++taken;
+                dead.push_back(live[o.id]);
+                live.erase(o.id);
+            });
+            ok = check(removed == taken && scanIds() == expected, "eraseIf keeps the survivors in order") && ok;
+        } else if (!live.empty()) {
+            auto it = pickLive();
+            const Order* found = registry.get(it->second);
+            ok = check(found && found->id == it->first, "live handles resolve to their order");
+        }
+        ok = check(registry.size() == live.size(), "size matches model") && ok;
+        if (i % 1024 == 0) {
+            std::vector<int> ids = scanIds();
+            std::sort(ids.begin(), ids.end());
+            std::vector<int> expected;
+            for (const auto& entry : live) expected.push_back(entry.first);
+            ok = check(ids == expected, "forEach visits every live order once") && ok;
+            for (const auto& entry : live) {
+                const Order* o = registry.get(entry.second);
+                if (!(ok = check(o && o->id == entry.first, "every live handle survives moves"))) break;
+            }
+        }
+    }
+    std::vector<OrderHandle> before;
+    for (const auto& entry : live) before.push_back(entry.second);
+    registry.clear();
+    bool cleared = registry.empty();
+    Order fresh;
+    fresh.id = nextId;
+    registry.insert(std::move(fresh));
+    for (OrderHandle h : before) cleared = cleared && registry.get(h) == nullptr;
+    check(cleared && registry.size() == 1, "clear retires every handle");
+}
+
+/** A name as CustomerIndex sees it: lowercased, plus its trigrams (padded with "  " and " "). */
+struct IndexedName {
+    std::string key;
+    std::set<std::string> grams;
+
+    explicit IndexedName(const std::string& name) {
+        for (char c : name) key.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        std::string padded = "  " + key + " ";
+        for (size_t i = 0; i + 3 <= padded.size(); ++i) grams.insert(padded.substr(i, 3));
+    }
+
+    /** Jaccard similarity of the trigram sets, as CustomerIndex::fuzzy defines it. */
+    double score(const IndexedName& other) const {
+        size_t common = 0;
+        for (const auto& g : grams) common += other.grams.count(g);
+        return static_cast<double>(common) / static_cast<double>(grams.size() + other.grams.size() - common);
+    }
+};
+
+void testCustomerIndex(const Options& opt) {
+    std::mt19937 rng(opt.seed + 16);
+    const size_t ops = 20000 * opt.scale;
+    static const char* const parts[] = {"Ann", "anna", "Bob", "Bo", "Chen", "Maria", "Garcia", "Lee", "Li", "O'Neil", "van", "Smith"};
+    auto randomCustomer = [&rng] {
+        std::string name = parts[rng() % 12];
+        for (size_t w = rng() % 3; w > 0; --w) name += std::string(" ") + parts[rng() % 12];
+        return name;
+    };
+    CustomerIndex index;
+    std::map<int, std::pair<std::string, IndexedName>> model;
+    int nextId = 1;
+    bool ok = true;
+    for (size_t i = 0; i < ops && ok; ++i) {
+        unsigned op = rng() % 100;
+        // The model stays in the hundreds: fuzzy checks score every name from scratch.
+        if ((op < 35 && model.size() < 300) || model.empty()) {
+            std::string name = randomCustomer();
+            index.add(nextId, name);
+            model.emplace(nextId++, std::make_pair(name, IndexedName(name)));
+        } else if (op < 65) {
+            // Renames churn the postings; removed ids must never come back from a query.
+            auto it = model.lower_bound(1 + static_cast<int>(rng() % static_cast<unsigned>(nextId)));
+            if (it == model.end()) it = model.begin();
+            if (op < 55) {
+                std::string name = randomCustomer();
+                index.rename(it->first, it->second.first, name);
+                it->second = std::make_pair(name, IndexedName(name));
+            } else {
+                index.remove(it->first);
+                model.erase(it);
+            }
+        } else if (op < 95) {
+            std::string query = IndexedName(randomCustomer()).key.substr(0, 1 + rng() % 6);
+            std::vector<int> got = index.prefix(query);
+            std::vector<int> expected;
+            for (const auto& entry : model) {
+                if (entry.second.second.key.compare(0, query.size(), query) == 0) expected.push_back(entry.first);
+            }
+            bool sorted = true;
+            for (size_t k = 1; k < got.size(); ++k) sorted = sorted && model.at(got[k - 1]).second.key <= model.at(got[k]).second.key;
+            std::sort(got.begin(), got.end());
+            ok = check(got == expected && sorted, "prefix returns exactly the matching ids in name order");
+        } else {
+            IndexedName query(randomCustomer());
+            std::vector<int> got = index.fuzzy(query.key, 0, 0.4);
+            std::vector<std::pair<double, int>> expected;
+            for (const auto& entry : model) {
+                double score = query.score(entry.second.second);
+                if (score >= 0.4) expected.emplace_back(-score, entry.first);
+            }
+            std::sort(expected.begin(), expected.end());
+            bool same = got.size() == expected.size();
+            for (size_t k = 0; same && k < got.size(); ++k) same = got[k] == expected[k].second;
+            ok = check(same, "fuzzy scores every live name exactly, best first");
+        }
+    }
+
+    // A name sharing more than 65535 trigrams with the query must not wrap the hit counts.
+    std::string huge;
+    for (int i = 0; i < 100000; ++i) huge.push_back(static_cast<char>('!' + rng() % 94));
+    index.add(nextId, huge);
+    std::vector<int> got = index.fuzzy(huge, 1, 0.9);
+    check(got.size() == 1 && got[0] == nextId, "fuzzy counts hits past 16 bits");
+}
+
+void testMenuBST(const Options& opt) {
+    std::mt19937 rng(opt.seed + 3);
+    const size_t ops = 1000000 * opt.scale;
+    MenuBST tree;
+    std::map<std::string, int> model;
+    bool ok = true;
+    for (size_t i = 0; i < ops && ok; ++i) {
+        std::string name = randomName(rng, 4096);
+        unsigned op = rng() % 100;
+        if (op < 45) {
+            MenuItem item;
+            item.itemId = static_cast<int>(i + 1);
+            item.name = name;
+            item.defaultPrepMinutes = 1 + static_cast<int>(rng() % 30);
+            bool fresh = model.count(name) == 0;
+            ok = check(tree.insert(item) == fresh, "insert succeeds iff the name is new");
+            if (fresh) model[name] = item.itemId;
+        } else if (op < 75) {
+            bool present = model.erase(name) != 0;
+            ok = check(tree.remove(name) == present, "remove succeeds iff present");
+        } else {
+            MenuItem* found = tree.find(name);
+            auto it = model.find(name);
+            ok = check((found != nullptr) == (it != model.end()), "find succeeds iff present");
+            if (found && it != model.end()) ok = check(found->itemId == it->second, "find returns the stored item") && ok;
+        }
+        if (i % 8192 == 0) {
+            std::vector<std::string> names;
+            tree.inOrder([&](const MenuItem& m) { names.push_back(m.name); });
+            std::vector<std::string> expected;
+            for (const auto& entry : model) expected.push_back(entry.first);
+            ok = check(names == expected, "inOrder visits names sorted") && ok;
+        }
+    }
+
+    // Assignment and clear hand the nodes over or free them (checked under make debug).
+    MenuBST other;
+    MenuItem extra;
+    extra.itemId = 1;
+    extra.name = "extra";
+    extra.defaultPrepMinutes = 5;
+    other.insert(extra);
+    other = std::move(tree);
+    size_t count = 0;
+    other.inOrder([&](const MenuItem&) { ++count; });
+    check(count == model.size() && other.find("extra") == nullptr, "move assignment replaces the tree");
+    other.clear();
+    count = 0;
+    other.inOrder([&](const MenuItem&) { ++count; });
+    check(count == 0, "clear empties the tree");
+}
+
+/** Sort key with its original position, to check stability. */
+struct Keyed {
+    int key;
+    size_t position;
+};
+
+void testSorts(const Options& opt) {
+    std::mt19937 rng(opt.seed + 4);
+    auto byKey = [](const Order& a, const Order& b) { return a.estimatedPrepMinutes < b.estimatedPrepMinutes; };
+    auto makeOrders = [&](size_t n, unsigned keys) {
+        std::vector<Order> items(n);
+        for (size_t i = 0; i < n; ++i) {
+            items[i].id = static_cast<int>(i + 1);
+            items[i].estimatedPrepMinutes = static_cast<int>(rng() % keys);
+        }
+        return items;
+    };
+    auto sameOrder = [](const std::vector<Order>& a, const std::vector<Order>& b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Order& x, const Order& y) { return x.id == y.id; });
+    };
+
+    // Quadratic sorts: many short inputs. Selection sort is not stable, so it is checked by key.
+    const size_t smallRounds = 3000 * opt.scale;
+    for (size_t r = 0; r < smallRounds; ++r) {
+        auto input = makeOrders(rng() % 64, 1 + rng() % 16);
+        auto expected = input;
+        std::stable_sort(expected.begin(), expected.end(), byKey);
+        auto keysMatch = [&](const std::vector<Order>& got) {
+            return std::equal(got.begin(), got.end(), expected.begin(), expected.end(),
+                              [](const Order& x, const Order& y) { return x.estimatedPrepMinutes == y.estimatedPrepMinutes; });
+        };
+        auto a = input;
+        Sorts::selectionSort(a, byKey);
+        check(keysMatch(a), "selectionSort sorts");
+        auto b = input;
+        Sorts::insertionSort(b, byKey);
+        check(sameOrder(b, expected), "insertionSort matches stable_sort");
+        auto c = input;
+        Sorts::bubbleSort(c, byKey);
+        check(sameOrder(c, expected), "bubbleSort matches stable_sort");
+        auto d = input;
+        Sorts::mergeSort(d, byKey);
+        check(sameOrder(d, expected), "mergeSort matches stable_sort");
+    }
+
+    // Parallel merge sort: thread counts and a small cutoff force the chunked and merge-path paths.
+    const size_t bigRounds = 40 * opt.scale;
+    for (size_t r = 0; r < bigRounds; ++r) {
+        size_t n = rng() % 200000;
+        std::vector<Keyed> items(n);
+        for (size_t i = 0; i < n; ++i) items[i] = Keyed{static_cast<int>(rng() % 1000), i};
+        auto expected = items;
+        auto less = [](const Keyed& a, const Keyed& b) { return a.key < b.key; };
+        std::stable_sort(expected.begin(), expected.end(), less);
+        unsigned threads = 1 + static_cast<unsigned>(rng() % 5);
+        size_t cutoff = 1 + rng() % 5000;
+        Sorts::parallelMergeSort(items, less, threads, cutoff);
+        check(std::equal(items.begin(), items.end(), expected.begin(), expected.end(),
+                         [](const Keyed& x, const Keyed& y) { return x.key == y.key && x.position == y.position; }),
+              "parallelMergeSort matches stable_sort");
+    }
+    auto orders = makeOrders(100000, 50);
+    auto expected = orders;
+    std::stable_sort(expected.begin(), expected.end(), byKey);
+    Sorts::parallelMergeSort(orders, byKey, 3);
+    check(sameOrder(orders, expected), "Order overload of parallelMergeSort matches stable_sort");
+}
+
+void testClock(const Options& opt) {
+    using namespace std::chrono;
+    std::mt19937 rng(opt.seed + 6);
+    const auto open = TimeUtils::fromSeconds(1717236000LL);
+
+    // VirtualClock only moves forward, by exactly what it is told.
+    VirtualClock clock(open);
+    auto expected = open;
+    bool ok = true;
+    for (size_t i = 0; i < 100000 * opt.scale && ok; ++i) {
+        auto step = nanoseconds(static_cast<long long>(rng() % 5000000));
+        if (rng() % 2) {
+            clock.advance(step);
+            expected += duration_cast<system_clock::duration>(step);
+        } else {
+            // Backward targets are ignored.
+            auto target = rng() % 4 == 0 ? expected - duration_cast<system_clock::duration>(step) : expected + duration_cast<system_clock::duration>(step);
+            clock.advanceTo(target);
+            expected = std::max(expected, target);
+        }
+        ok = check(clock.now() == expected && clock.peek() == expected, "virtual clock follows advance/advanceTo");
+    }
+    VirtualClock ticking(open, microseconds(250));
+    check(ticking.now() == open && ticking.now() == open + microseconds(250) && ticking.peek() == open + microseconds(500),
+          "tick advances after every read");
+
+    MonotonicClock monotonic(1000.0);
+    auto last = monotonic.now();
+    for (int i = 0; i < 10000; ++i) {
+        auto now = monotonic.now();
+        ok = check(now >= last, "monotonic clock never steps back") && ok;
+        last = now;
+    }
+
+    // Orders are stamped from the injected clock, and VIPs rank by sub-second placed time: the
+    // later id placed 300 ms earlier within the same second goes first.
+    OrderManager manager;
+    VirtualClock service(open);
+    manager.setClock(&service);
+    service.advance(milliseconds(1500));
+    int late = manager.createOrder("Late", true, {}, 5);
+    int early = manager.runAt(open + milliseconds(1200), [&] { return manager.createOrder("Early", true, {}, 5); });
+    check(manager.getOrder(late)->placedAt == open + milliseconds(1500), "placedAt comes from the injected clock");
+    int first = 0;
+    check(manager.nextForKitchen(first) && first == early, "VIP order uses sub-second placed time");
+    check(manager.getOrder(first)->startedAt == open + milliseconds(1500), "startedAt comes from the injected clock");
+    service.advance(minutes(7));
+    check(manager.readyOrder(first) && manager.getOrder(first)->readyAt == open + milliseconds(1500) + minutes(7), "readyAt comes from the injected clock");
+    manager.setClock(nullptr);
+    check(&manager.clock() == &RealClock::instance(), "setClock(nullptr) restores the system clock");
+
+    // TimestampCache renders what strftime does in zones with hourly, half-hour and no DST shifts;
+    // Lord Howe moves from +10:30 to +11 at 2025-10-04 15:30 UTC, checked minute by minute.
+    const char* savedZone = std::getenv("TZ");
+    std::string restoreZone = savedZone ? savedZone : "";
+    for (const char* zone : {"UTC", "America/New_York", "Australia/Lord_Howe", "Asia/Kolkata"}) {
+        setenv("TZ", zone, 1);
+        tzset();
+        TimestampCache cache;
+        auto matches = [&](long long at) {
+            std::time_t tt = static_cast<std::time_t>(at);
+            char expected[32];
+            size_t len = std::strftime(expected, sizeof(expected), "%d/%m/%Y %I:%M %p", std::localtime(&tt));
+            expected[len - 2] = static_cast<char>(std::tolower(expected[len - 2]));
+            expected[len - 1] = static_cast<char>(std::tolower(expected[len - 1]));
+            char text[TimestampCache::kWidth];
+            return cache.format(at, text) == len && std::string(text, len) == std::string(expected, len);
+        };
+        const long long shift = 1759591800LL;
+        for (long long at = shift - 3 * 3600; at < shift + 3 * 3600; at += 60) ok = check(matches(at), "times render as localtime does around a shift") && ok;
+        for (int probe = 0; probe < 20000; ++probe) {
+            long long at = 1735689600LL + static_cast<long long>(rng() % (3u * 365 * 86400));
+            ok = check(matches(at), "times render as localtime does") && ok;
+        }
+    }
+    if (savedZone) {
+        setenv("TZ", restoreZone.c_str(), 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+
+    // Windowed listings over a snapshot read only the ids resolved from the time index, and
+    // must page exactly like the live listing and a full snapshot scan.
+    OrderManager traffic;
+    VirtualClock busy(open, seconds(11));
+    traffic.setClock(&busy);
+    for (size_t i = 0; i < 2000 * opt.scale; ++i) {
+        traffic.createOrder("Guest " + std::to_string(i), rng() % 4 == 0, {}, 5);
+        int id = 0;
+        if (rng() % 2 && traffic.nextForKitchen(id)) {
+            traffic.readyOrder(id);
+            if (rng() % 3) traffic.serveOrder(id);
+        }
+    }
+    OrderSnapshot snapshot = traffic.snapshot();
+    long long start = TimeUtils::toSeconds(open);
+    long long span = TimeUtils::toSeconds(traffic.now()) - start;
+    for (int probe = 0; probe < 300; ++probe) {
+        ListQuery query;
+        query.byServed = rng() % 2;
+        if (query.byServed) query.statusMask = ListQuery::maskOf(OrderStatus::Served);
+        query.newestFirst = rng() % 2;
+        query.limit = rng() % 3 ? rng() % 40 : 0;
+        long long from = start + static_cast<long long>(rng() % static_cast<unsigned>(span));
+        long long to = from + 1 + static_cast<long long>(rng() % 3000);
+        // At least one side is set, or there is no window to resolve.
+        int sides = 1 + static_cast<int>(rng() % 3);
+        query.since = sides & 1 ? from : 0;
+        query.until = sides & 2 ? to : 0;
+        int liveNext = 0;
+        int windowNext = 0;
+        int scanNext = 0;
+        std::vector<int> window = traffic.windowIds(query);
+        for (int page = 0; page < 3; ++page) {
+            auto live = traffic.listPage(query, &liveNext);
+            auto windowed = OrderManager::listPage(snapshot, query, &windowNext, &window);
+            auto scanned = OrderManager::listPage(snapshot, query, &scanNext);
+            bool same = live.size() == windowed.size() && live.size() == scanned.size() && liveNext == windowNext && liveNext == scanNext;
+            for (size_t r = 0; same && r < live.size(); ++r) same = live[r].id == windowed[r].id && live[r].id == scanned[r].id;
+            ok = check(same, "snapshot window pages like the live listing") && ok;
+            if (liveNext == 0) break;
+            query.afterId = liveNext;
+        }
+    }
+}
+
+/** Builds a manager with random menu, orders in every status, edits and kitchen pulls. */
+void populate(OrderManager& manager, std::mt19937& rng, size_t orders) {
+    const char* names[] = {"Margherita", "Quote \"special\"", "Back\\slash", "Crème brûlée", "Espresso", "Tea, hot"};
+    for (const char* name : names) manager.addMenuItem(name, 1 + static_cast<int>(rng() % 20));
+    manager.removeMenuItem("Espresso");
+    auto menu = manager.listMenuItems();
+    for (size_t i = 0; i < orders; ++i) {
+        std::vector<OrderItem> items;
+        size_t lines = rng() % 4;
+        for (size_t l = 0; l < lines; ++l) {
+            if (rng() % 5 == 0) {
+                items.push_back(OrderItem{0, "Off-menu \"" + std::to_string(l) + "\"", 1 + static_cast<int>(rng() % 3)});
+            } else {
+                const MenuItem& m = menu[rng() % menu.size()];
+                items.push_back(OrderItem{m.itemId, m.name, 1 + static_cast<int>(rng() % 3)});
+            }
+        }
+        std::string customer = "Guest " + std::to_string(i) + (i % 7 == 0 ? " \"VIP\" \\ table" : "");
+        manager.createOrder(std::move(customer), rng() % 4 == 0, std::move(items), 5 + static_cast<int>(rng() % 20));
+    }
+    int id = 0;
+    for (size_t i = 0; i < orders / 4 && manager.nextForKitchen(id); ++i) {
+        if (i % 2 == 0) manager.readyOrder(id);
+        if (i % 4 == 0) manager.serveOrder(id);
+    }
+    for (size_t i = 0; i < orders / 10; ++i) {
+        int target = 1 + static_cast<int>(rng() % orders);
+        if (rng() % 2) {
+            manager.cancelOrder(target);
+        } else if (Order* o = manager.getOrder(target)) {
+            manager.editOrder(target, o->customerName + " (edited)", !o->isVip, o->items, o->estimatedPrepMinutes + 1);
+        }
+    }
+}
+
+/** Field-by-field equality at the resolution saves keep (whole seconds). */
+bool sameOrder(const Order& x, const Order& y) {
+    bool fields = x.id == y.id && x.customerName == y.customerName && x.isVip == y.isVip
+               && x.estimatedPrepMinutes == y.estimatedPrepMinutes && x.status == y.status && x.stage == y.stage
+               && TimeUtils::toSeconds(x.placedAt) == TimeUtils::toSeconds(y.placedAt)
+               && TimeUtils::toSeconds(x.startedAt) == TimeUtils::toSeconds(y.startedAt)
+               && TimeUtils::toSeconds(x.readyAt) == TimeUtils::toSeconds(y.readyAt)
+               && TimeUtils::toSeconds(x.servedAt) == TimeUtils::toSeconds(y.servedAt)
+               && x.items.size() == y.items.size();
+    for (size_t i = 0; fields && i < x.items.size(); ++i) {
+        fields = x.items[i].itemId == y.items[i].itemId && x.items[i].name == y.items[i].name && x.items[i].quantity == y.items[i].quantity;
+    }
+    return fields;
+}
+
+/** Compares everything a save is supposed to carry; times are compared at second resolution. */
+bool sameState(const OrderManager& a, const OrderManager& b) {
+    auto ta = a.snapshot();
+    auto tb = b.snapshot();
+    bool ok = check(ta.size() == tb.size(), "same order count");
+    ok = check(a.nextIdValue() == b.nextIdValue() && a.nextMenuIdValue() == b.nextMenuIdValue(), "same id counters") && ok;
+    ta.forEach([&](const Order& x) {
+        const Order* y = tb.find(x.id);
+        if (!check(y != nullptr, "order survives the round trip")) return;
+        ok = check(sameOrder(x, *y), "order fields survive the round trip") && ok;
+    });
+    auto menuA = a.listMenuItems();
+    auto menuB = b.listMenuItems();
+    ok = check(std::equal(menuA.begin(), menuA.end(), menuB.begin(), menuB.end(), [](const MenuItem& x, const MenuItem& y) {
+        return x.itemId == y.itemId && x.name == y.name && x.defaultPrepMinutes == y.defaultPrepMinutes;
+    }), "menu survives the round trip") && ok;
+
+    // Waiting orders come back in the same kitchen order: the queue without stale entries, and
+    // the VIP heap in pop order.
+    auto waitingQueue = [](const OrderManager& m) {
+        std::vector<int> ids;
+        for (int id : m.normalQueue().snapshot()) {
+            const Order* o = m.getOrder(id);
+            if (o && !o->isVip && (o->status == OrderStatus::Queued || o->status == OrderStatus::Placed)) ids.push_back(id);
+        }
+        return ids;
+    };
+    ok = check(waitingQueue(a) == waitingQueue(b), "normal queue order survives the round trip") && ok;
+    auto vipOrder = [](const OrderManager& m) {
+        VipHeap heap = m.vipHeap();
+        std::vector<int> ids;
+        VipEntry e{};
+        while (heap.pop(e)) {
+            const Order* o = m.getOrder(e.orderId);
+            if (o && o->isVip && (o->status == OrderStatus::Queued || o->status == OrderStatus::Placed)) ids.push_back(e.orderId);
+        }
+        return ids;
+    };
+    ok = check(vipOrder(a) == vipOrder(b), "VIP heap order survives the round trip") && ok;
+    return ok;
+}
+
+void testWorkflowPull(const Options& opt) {
+    std::mt19937 rng(opt.seed + 15);
+    auto cfg = std::filesystem::temp_directory_path() / ("restaurant_workflow_" + std::to_string(opt.seed) + ".cfg");
+    {
+        std::ofstream out(cfg);
+        // Orders must be fired before the kitchen may start them, and the kitchen may send a
+        // started order back to the queue (a refire).
+        out << "state FIRE QUEUED\nedge QUEUED FIRE\nedge FIRE PREPPING\nremove QUEUED PREPPING\nedge PREPPING QUEUED\n";
+    }
+    {
+        // The default engine is copied from the compile-time tables; an empty config rebuilds
+        // the same graph through compile(), and the two must agree on every path.
+        WorkflowEngine seeded;
+        WorkflowEngine compiled;
+        std::string error;
+        check(compiled.parseConfig("", error) && compiled.stateCount() == seeded.stateCount(), "an empty config gives the standard graph");
+        bool same = true;
+        for (int from = 0; from < static_cast<int>(seeded.stateCount()); ++from) {
+            for (int to = 0; to < static_cast<int>(seeded.stateCount()); ++to) {
+                auto a = seeded.shortestPath(from, to);
+                auto b = compiled.shortestPath(from, to);
+                same = same && seeded.canTransition(from, to) == compiled.canTransition(from, to)
+                       && std::equal(a.begin(), a.end(), b.begin(), b.end());
+            }
+        }
+        check(same, "the seeded standard graph matches a compiled one");
+    }
+    for (size_t round = 0; round < 20 * opt.scale; ++round) {
+        VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::milliseconds(7));
+        OrderManager manager;
+        manager.setClock(&clock);
+        std::string error;
+        if (!check(manager.loadWorkflow(cfg.string(), error), "workflow config loads")) break;
+        const int fire = manager.workflow().stateId("FIRE");
+        const int queued = manager.workflow().stateId("QUEUED");
+        // Model: waiting ids in pull order per lane (VIPs by placement, normal FIFO), and the
+        // orders in the kitchen.
+        std::vector<int> vips;
+        std::vector<int> normal;
+        std::set<int> fired;
+        std::vector<int> prepping;
+        bool ok = true;
+        for (size_t step = 0; step < 400 && ok; ++step) {
+            unsigned op = rng() % 11;
+            if (op == 10) {
+                // Refire: back in its lane, VIPs by placement (ids follow placement here) and
+                // normal orders at the back, and it must be fired again.
+                if (prepping.empty()) continue;
+                size_t pick = rng() % prepping.size();
+                int id = prepping[pick];
+                prepping.erase(prepping.begin() + static_cast<std::ptrdiff_t>(pick));
+                ok = check(manager.advanceOrder(id, queued), "a started order can be refired");
+                if (manager.getOrder(id)->isVip) {
+                    vips.insert(std::lower_bound(vips.begin(), vips.end(), id), id);
+                } else {
+                    normal.push_back(id);
+                }
+            } else if (op < 4) {
+                bool vip = rng() % 3 == 0;
+                int id = manager.createOrder("Guest", vip, {}, 5);
+                (vip ? vips : normal).push_back(id);
+            } else if (op < 7) {
+                std::vector<int>& lane = rng() % 2 ? vips : normal;
+                if (lane.empty()) continue;
+                int id = lane[rng() % lane.size()];
+                fired.insert(id);
+                ok = check(manager.advanceOrder(id, fire), "waiting orders can be fired");
+            } else {
+                auto firstFired = [&](const std::vector<int>& lane) {
+                    for (int id : lane) {
+                        if (fired.count(id)) return id;
+                    }
+                    return 0;
+                };
+                int expected = firstFired(vips);
+                if (expected == 0) expected = firstFired(normal);
+                int pulled = 0;
+                bool got = manager.nextForKitchen(pulled);
+                ok = check(got == (expected != 0) && (!got || pulled == expected), "the kitchen pulls the first fired order, by lane");
+                if (got) {
+                    const Order* o = manager.getOrder(pulled);
+                    ok = check(o && o->status == OrderStatus::Prepping, "a pulled order is PREPPING") && ok;
+                    for (auto* lane : {&vips, &normal}) lane->erase(std::remove(lane->begin(), lane->end(), pulled), lane->end());
+                    fired.erase(pulled);
+                    prepping.push_back(pulled);
+                }
+                // Unfired orders stay queued however often the kitchen asks.
+                ok = check(manager.normalQueue().size() + manager.vipHeap().size() >= vips.size() + normal.size(), "no waiting order is dropped") && ok;
+            }
+        }
+        // Once everything is fired, every waiting order comes out exactly once.
+        for (int id : vips) manager.advanceOrder(id, fire);
+        for (int id : normal) manager.advanceOrder(id, fire);
+        std::vector<int> expected = vips;
+        expected.insert(expected.end(), normal.begin(), normal.end());
+        std::vector<int> drained;
+        int pulled = 0;
+        while (manager.nextForKitchen(pulled)) drained.push_back(pulled);
+        check(drained == expected, "fired orders drain VIPs first, then FIFO");
+    }
+    std::filesystem::remove(cfg);
+}
+
+void testPersistence(const Options& opt) {
+    std::mt19937 rng(opt.seed + 5);
+    auto dir = std::filesystem::temp_directory_path() / ("restaurant_tests_" + std::to_string(opt.seed));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string file = (dir / "state.json").string();
+    const std::string segments = (dir / "segments").string();
+
+    const size_t rounds = 6 * opt.scale;
+    for (size_t r = 0; r < rounds; ++r) {
+        OrderManager original;
+        populate(original, rng, 200 + r * 400);
+
+        // Single file: load restores the state. The primary's queue may still hold lazily dropped
+        // ids that a load skips, so the document is a fixed point from the first reload on.
+        check(Persistence::saveState(original, file), "saveState succeeds");
+        OrderManager loaded;
+        check(Persistence::loadState(loaded, file), "loadState succeeds");
+        sameState(original, loaded);
+        std::string document = Persistence::renderState(loaded);
+        OrderManager reloaded;
+        Persistence::applyState(reloaded, document);
+        check(Persistence::renderState(reloaded) == document, "load -> save is a fixed point");
+
+        // Loading twice into the same manager replaces its state rather than appending to it.
+        check(Persistence::loadState(loaded, file), "reload succeeds");
+        sameState(original, loaded);
+
+        // Segments: a full save, then incremental saves after more changes.
+        std::filesystem::remove_all(segments);
+        check(Persistence::saveSegments(original, segments), "saveSegments succeeds");
+        for (int step = 0; step < 3; ++step) {
+            populate(original, rng, 50);
+            size_t written = 0;
+            check(Persistence::saveSegments(original, segments, &written), "incremental saveSegments succeeds");
+            OrderManager fromSegments;
+            check(Persistence::loadSegments(fromSegments, segments), "loadSegments succeeds");
+            sameState(original, fromSegments);
+        }
+    }
+
+    // Orders over several days: an incremental save rewrites exactly the days holding changes.
+    VirtualClock clock(TimeUtils::fromSeconds(1717236000LL));
+    OrderManager history;
+    history.setClock(&clock);
+    std::vector<std::vector<int>> byDay(12);
+    for (size_t day = 0; day < byDay.size(); ++day) {
+        for (int i = 0; i < 20; ++i) {
+            clock.advance(std::chrono::minutes(10 + rng() % 10));
+            byDay[day].push_back(history.createOrder("Guest " + std::to_string(day), rng() % 4 == 0, {}, 5));
+        }
+        // Service opens at 10:00 UTC and the 20 orders end before midnight, so each day is one segment.
+        clock.advanceTo(TimeUtils::fromSeconds(1717236000LL + static_cast<long long>(day + 1) * 86400));
+    }
+    std::filesystem::remove_all(segments);
+    size_t written = 0;
+    check(Persistence::saveSegments(history, segments, &written) && written == byDay.size() + 1, "a full save writes every day and the menu");
+    for (int step = 0; step < 20; ++step) {
+        std::set<size_t> touched;
+        for (size_t edits = rng() % 4; edits > 0; --edits) {
+            size_t day = rng() % byDay.size();
+            int id = byDay[day][rng() % byDay[day].size()];
+            const Order* o = history.getOrder(id);
+            if (history.editOrder(id, o->customerName + "+", o->isVip, o->items, o->estimatedPrepMinutes)) touched.insert(day);
+        }
+        check(Persistence::saveSegments(history, segments, &written) && written == touched.size(), "an incremental save rewrites only the changed days");
+        OrderManager fromSegments;
+        check(Persistence::loadSegments(fromSegments, segments), "loadSegments succeeds");
+        sameState(history, fromSegments);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+/** Live orders' (id, stage, VIP) and the order the kitchen would pull them in. */
+struct KitchenView {
+    std::vector<std::tuple<int, int, bool>> live;
+    std::vector<int> pulls;
+    bool operator==(const KitchenView&) const = default;
+};
+
+/** Drains the kitchen of a throwaway copy: save/load keeps the queue exactly. */
+KitchenView kitchenOf(OrderManager& manager, const std::string& scratch) {
+    KitchenView view;
+    manager.registry().forEach([&](const Order& o) {
+        if (o.status != OrderStatus::Served && o.status != OrderStatus::Cancelled) view.live.emplace_back(o.id, WorkflowEngine::stageOf(o), o.isVip);
+    });
+    std::sort(view.live.begin(), view.live.end());
+    OrderManager copy;
+    Persistence::saveState(manager, scratch);
+    Persistence::loadState(copy, scratch);
+    int id = 0;
+    while (copy.nextForKitchen(id)) view.pulls.push_back(id);
+    return view;
+}
+
+void testReplication(const Options& opt) {
+    std::mt19937 rng(opt.seed + 17);
+    // A standby fed the primary's log in arbitrary chunks ends in the primary's state.
+    VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::seconds(3));
+    OrderManager primary;
+    primary.setClock(&clock);
+    ReplicationLog log;
+    primary.setReplicationLog(&log);
+    OrderManager standby;
+    ReplicaStats stats;
+    ReplicaApplier applier(standby, stats);
+    log.beginResync();
+    log.fullState(Persistence::renderState(primary.snapshot()));
+    std::string chunk;
+    auto ship = [&] {
+        if (!log.take(chunk, std::chrono::milliseconds(0))) return;
+        for (size_t pos = 0; pos < chunk.size();) {
+            size_t piece = std::min<size_t>(1 + rng() % 200, chunk.size() - pos);
+            check(applier.feed(chunk.data() + pos, piece), "standby parses the stream");
+            pos += piece;
+        }
+    };
+    primary.addMenuItem("Margherita", 12);
+    for (size_t i = 0; i < 5000 * opt.scale; ++i) {
+        unsigned roll = rng() % 10;
+        int target = 1 + static_cast<int>(rng() % static_cast<unsigned>(primary.nextIdValue()));
+        int id = 0;
+        if (roll < 4) {
+            primary.createOrder("Guest " + std::to_string(i), rng() % 4 == 0, {OrderItem{1, "Margherita", 1}}, 5 + static_cast<int>(rng() % 10));
+        } else if (roll < 6) {
+            primary.nextForKitchen(id);
+        } else if (roll == 6) {
+            primary.readyOrder(target);
+        } else if (roll == 7) {
+            primary.serveOrder(target);
+        } else if (roll == 8) {
+            primary.cancelOrder(target);
+        } else if (const Order* o = primary.getOrder(target)) {
+            primary.editOrder(target, o->customerName, !o->isVip, o->items, o->estimatedPrepMinutes);
+        }
+        if (rng() % 50 == 0) ship();
+    }
+    ship();
+    check(stats.failed == 0, "every record applies");
+    sameState(primary, standby);
+
+    // A standby whose queue drifted (here a local VIP promotion) still starts the order the
+    // primary logged, not its own next pick.
+    OrderManager first;
+    first.setReplicationLog(&log);
+    OrderManager drifted;
+    ReplicaApplier second(drifted, stats);
+    log.beginResync();
+    log.fullState(Persistence::renderState(first.snapshot()));
+    int a = first.createOrder("Ada", false, {}, 5);
+    int b = first.createOrder("Bo", false, {}, 5);
+    log.take(chunk, std::chrono::milliseconds(0));
+    second.feed(chunk.data(), chunk.size());
+    const Order* promoted = drifted.getOrder(b);
+    check(promoted && drifted.editOrder(b, promoted->customerName, true, promoted->items, promoted->estimatedPrepMinutes), "standby edits locally");
+    int pulled = 0;
+    check(first.nextForKitchen(pulled) && pulled == a, "primary pulls the queue head");
+    log.take(chunk, std::chrono::milliseconds(0));
+    uint64_t failedBefore = stats.failed;
+    check(second.feed(chunk.data(), chunk.size()) && stats.failed == failedBefore, "logged pull applies");
+    check(drifted.getOrder(a)->status == OrderStatus::Prepping, "standby starts the logged order");
+    check(drifted.getOrder(b)->status == OrderStatus::Queued, "standby leaves its own pick waiting");
+    int next = 0;
+    check(drifted.nextForKitchen(next) && next == b, "the skipped order is still queued");
+}
+
+void testSharded(const Options& opt) {
+    std::mt19937 rng(opt.seed + 18);
+    {
+        ShardedManager tooMany;
+        std::vector<std::string> names;
+        for (size_t i = 0; i <= ShardedManager::kMaxShards; ++i) names.push_back("branch" + std::to_string(i));
+        std::string error;
+        check(!tooMany.open(names, &error) && !error.empty() && tooMany.shardCount() == 0, "more branches than id bits are rejected");
+        ShardedManager duplicate;
+        check(!duplicate.open({"north", "north"}) && duplicate.shardCount() == 0, "duplicate branch names are rejected");
+        check(!duplicate.open({}), "an empty branch list is rejected");
+        check(duplicate.open({"north"}) && !duplicate.open({"south"}), "branches open once");
+    }
+
+    auto dir = std::filesystem::temp_directory_path() / ("restaurant_sharded_" + std::to_string(opt.seed));
+    std::filesystem::remove_all(dir);
+    for (size_t round = 0; round < 4 * opt.scale; ++round) {
+        // Every branch and the reference manager read one clock that only moves between steps,
+        // and every step moves it, so no two orders share a sort key and ties cannot differ.
+        VirtualClock clock(TimeUtils::fromSeconds(1717236000LL));
+        std::vector<std::string> names;
+        for (size_t i = 1 + rng() % 5; i > 0; --i) names.push_back("branch" + std::to_string(names.size()));
+        ShardedManager sharded(&clock);
+        if (!check(sharded.open(names), "branches open")) return;
+        OrderManager single;
+        single.setClock(&clock);
+        std::map<int, int> toSingle;
+        std::map<int, int> toGlobal;
+        std::vector<int> globals;
+        bool ok = true;
+        for (size_t step = 0; step < 1500; ++step) {
+            clock.advance(std::chrono::seconds(1 + rng() % 90));
+            unsigned op = rng() % 10;
+            if (op < 4 || globals.empty()) {
+                size_t shard = rng() % names.size();
+                std::string name = "Guest " + std::to_string(step);
+                bool vip = rng() % 4 == 0;
+                int estimate = 5 + static_cast<int>(rng() % 20);
+                int global = sharded.createOrder(shard, name, vip, {}, estimate);
+                int local = single.createOrder(name, vip, {}, estimate);
+                ok = check(global > 0 && ShardedManager::shardOfId(global) == shard, "global ids carry their branch") && ok;
+                toSingle[global] = local;
+                toGlobal[local] = global;
+                globals.push_back(global);
+                continue;
+            }
+            int global = globals[rng() % globals.size()];
+            int local = toSingle[global];
+            bool a = false;
+            bool b = false;
+            if (op < 6) {
+                a = sharded.startOrder(global);
+                b = single.startOrder(local);
+            } else if (op < 8) {
+                a = sharded.readyOrder(global);
+                b = single.readyOrder(local);
+            } else if (op < 9) {
+                a = sharded.serveOrder(global);
+                b = single.serveOrder(local);
+            } else {
+                a = sharded.cancelOrder(global);
+                b = single.cancelOrder(local);
+            }
+            ok = check(a == b, "routed transitions succeed as on one manager") && ok;
+        }
+
+        auto sameListing = [&](const std::vector<Order>& merged, const std::vector<Order>& reference) {
+            if (merged.size() != reference.size()) return false;
+            for (size_t r = 0; r < merged.size(); ++r) {
+                if (toSingle[merged[r].id] != reference[r].id || merged[r].customerName != reference[r].customerName) return false;
+            }
+            return true;
+        };
+        long long start = 1717236000LL;
+        long long span = TimeUtils::toSeconds(clock.peek()) - start + 1;
+        for (int probe = 0; probe < 200; ++probe) {
+            ListQuery query;
+            query.byServed = rng() % 3 == 0;
+            query.statusMask = query.byServed ? ListQuery::maskOf(OrderStatus::Served) : (rng() % 2 ? 0 : 1u << (rng() % 6));
+            query.newestFirst = rng() % 2;
+            query.limit = rng() % 3 ? rng() % 60 : 0;
+            if (rng() % 2) {
+                query.since = start + static_cast<long long>(rng() % static_cast<unsigned long long>(span));
+                query.until = rng() % 2 ? query.since + static_cast<long long>(rng() % 20000) : 0;
+            }
+            ok = check(sameListing(sharded.listAll(query), single.listPage(query)), "listAll merges like one manager's listPage") && ok;
+        }
+        for (int probe = 0; probe < 100; ++probe) {
+            int global = globals[rng() % globals.size()];
+            Order o;
+            const Order* reference = single.getOrder(toSingle[global]);
+            ok = check(sharded.getOrder(global, o) && o.id == global && reference && o.customerName == reference->customerName
+                           && o.status == reference->status,
+                       "getOrder routes to the owning branch")
+                 && ok;
+        }
+        Order missing;
+        check(!sharded.getOrder(ShardedManager::globalId(names.size(), 1), missing) || names.size() == ShardedManager::kMaxShards,
+              "ids of unknown branches are rejected");
+
+        // Per-branch stats from the reference manager's orders, split by the branch in each id.
+        auto expectedStats = [&] {
+            std::vector<BranchStats> expected(names.size());
+            std::vector<long long> servedSeconds(names.size(), 0);
+            single.registry().forEach([&](const Order& o) {
+                size_t shard = ShardedManager::shardOfId(toGlobal[o.id]);
+                ++expected[shard].byStatus[static_cast<size_t>(o.status)];
+                if (o.status == OrderStatus::Served && o.servedAt > o.placedAt) {
+                    servedSeconds[shard] += TimeUtils::toSeconds(o.servedAt) - TimeUtils::toSeconds(o.placedAt);
+                    ++expected[shard].servedCount;
+                }
+            });
+            for (size_t i = 0; i < names.size(); ++i) {
+                if (expected[i].servedCount) expected[i].avgServeMinutes = static_cast<double>(servedSeconds[i]) / 60.0 / static_cast<double>(expected[i].servedCount);
+            }
+            return expected;
+        };
+        auto sameStats = [&](const std::vector<BranchStats>& got) {
+            std::vector<BranchStats> expected = expectedStats();
+            if (got.size() != names.size()) return false;
+            long long backlog = 0;
+            for (size_t i = 0; i < got.size(); ++i) {
+                backlog += got[i].backlogMinutes;
+                if (got[i].branch != names[i] || got[i].servedCount != expected[i].servedCount
+                    || std::abs(got[i].avgServeMinutes - expected[i].avgServeMinutes) > 1e-9
+                    || !std::equal(std::begin(got[i].byStatus), std::end(got[i].byStatus), std::begin(expected[i].byStatus))) {
+                    return false;
+                }
+            }
+            return backlog == single.backlogMinutes();
+        };
+        check(sameStats(sharded.stats()), "stats match one manager split by branch");
+
+        // Saved branches load back into a fresh set with the same orders, ids and stats.
+        ListQuery everything;
+        check(sharded.saveAll(dir.string()), "saveAll succeeds");
+        ShardedManager reloaded(&clock);
+        reloaded.open(names);
+        check(reloaded.loadAll(dir.string()), "loadAll succeeds");
+        check(sameListing(reloaded.listAll(everything), single.listPage(everything)), "loadAll restores every branch's orders");
+        check(sameStats(reloaded.stats()), "loadAll restores the stats");
+        std::filesystem::remove_all(dir);
+    }
+}
+
+/**
+ * Allocation budget for the create/edit path. With moved-in payloads an order costs its registry
+ * node plus one dirty-tracking entry; queue/heap/hash growth is amortized on top, as is growth of
+ * the customer index's posting pool (a renaming edit reuses the runs the old name freed).
+ */
+void testAllocations(const Options& opt) {
+#ifdef __SANITIZE_ADDRESS__
+    // Sanitizer builds (make debug) allocate on their own, so the counts say nothing there.
+    (void)opt;
+#else
+    const double createBudget = 2.2;
+    const double editBudget = 0.05;
+    const size_t n = 20000 * opt.scale;
+    OrderManager manager;
+    std::vector<std::string> names(n);
+    std::vector<std::vector<OrderItem>> items(n);
+    for (size_t i = 0; i < n; ++i) {
+        names[i] = "Customer with a long enough name " + std::to_string(i);
+        items[i] = {OrderItem{1, "Burger with extra cheese", 2}, OrderItem{2, "Sweet potato fries", 1}};
+    }
+    size_t before = gAllocations.load();
+    for (size_t i = 0; i < n; ++i) {
+        manager.createOrder(std::move(names[i]), i % 10 == 0, std::move(items[i]), 10);
+    }
+    double createPer = static_cast<double>(gAllocations.load() - before) / static_cast<double>(n);
+
+    const size_t edits = 100;
+    std::vector<std::string> newNames(edits);
+    std::vector<std::vector<OrderItem>> newItems(edits);
+    for (size_t i = 0; i < edits; ++i) {
+        newNames[i] = "Renamed customer with a long name " + std::to_string(i);
+        newItems[i] = {OrderItem{3, "Grilled salmon fillet", 1}};
+    }
+    before = gAllocations.load();
+    for (size_t i = 0; i < edits; ++i) {
+        manager.editOrder(static_cast<int>(i + 1), std::move(newNames[i]), i % 10 == 0, std::move(newItems[i]), 15);
+    }
+    double editPer = static_cast<double>(gAllocations.load() - before) / static_cast<double>(edits);
+
+    if (!check(createPer <= createBudget, "createOrder stays within its allocation budget")) {
+        std::cout << "  createOrder: " << createPer << " allocations/order (budget " << createBudget << ")\n";
+    }
+    if (!check(editPer <= editBudget, "editOrder stays within its allocation budget")) {
+        std::cout << "  editOrder: " << editPer << " allocations/edit (budget " << editBudget << ")\n";
+    }
+#endif
+}
+
+void testJournal(const Options& opt) {
+    std::mt19937 rng(opt.seed + 7);
+    auto dir = std::filesystem::temp_directory_path() / ("restaurant_journal_" + std::to_string(opt.seed));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string journalPath = (dir / "tickets.journal").string();
+    const std::string savePath = (dir / "state.json").string();
+    const std::string scratch = (dir / "scratch.json").string();
+
+    // A small ring forces wrap-around and carry-forward of live orders' records.
+    const size_t capacity = 512;
+    const size_t rounds = 20 * opt.scale;
+    VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::microseconds(1));
+    OrderManager manager;
+    manager.setClock(&clock);
+    TicketJournal journal;
+    check(journal.open(journalPath, capacity), "journal opens");
+    journal.attach(manager);
+    check(Persistence::saveState(manager, savePath), "initial save");
+    std::vector<int> ids;
+    std::vector<int> cooking;
+    std::vector<int> pickup;
+    auto takeRandom = [&](std::vector<int>& from) {
+        size_t at = rng() % from.size();
+        int id = from[at];
+        from[at] = from.back();
+        from.pop_back();
+        return id;
+    };
+    for (size_t round = 0; round < rounds; ++round) {
+        for (int op = 0; op < 300; ++op) {
+            unsigned pick = rng() % 100;
+            // The kitchen keeps up with arrivals, so the live set stays well below the ring capacity.
+            if (pick < 20 || ids.empty()) {
+                ids.push_back(manager.createOrder("Guest", rng() % 4 == 0, {}, 5 + static_cast<int>(rng() % 10)));
+            } else if (pick < 45) {
+                int pulled = 0;
+                if (cooking.size() < 40 && manager.nextForKitchen(pulled)) cooking.push_back(pulled);
+            } else if (pick < 67 && !cooking.empty()) {
+                int id = takeRandom(cooking);
+                manager.readyOrder(id);
+                pickup.push_back(id);
+            } else if (pick < 90 && !pickup.empty()) {
+                manager.serveOrder(takeRandom(pickup));
+            } else if (pick < 94) {
+                manager.cancelOrder(ids[rng() % ids.size()]);
+            } else if (const Order* o = manager.getOrder(ids[rng() % ids.size()])) {
+                manager.editOrder(o->id, o->customerName, !o->isVip, o->items, o->estimatedPrepMinutes);
+            }
+            if (ids.size() > 400) ids.erase(ids.begin(), ids.begin() + 200);
+        }
+        // Crash: a second mapping of the same file sees every record without any flush.
+        TicketJournal reopened;
+        check(reopened.open(journalPath, capacity), "journal reopens");
+        KitchenState state;
+        reopened.recover(state);
+        OrderManager recovered;
+        check(Persistence::loadState(recovered, savePath), "last save loads");
+        size_t unknown = recovered.recoverKitchen(state);
+        bool ok = check(state.overflows == 0, "ring never had to drop a record");
+        ok = check(unknown == 0, "every open order from the save has a ticket") && ok;
+        ok = check(kitchenOf(recovered, scratch) == kitchenOf(manager, scratch), "recovered kitchen matches the live one") && ok;
+        if (!ok) break;
+
+        // A save after every round lets the journal forget finished orders, so one round's
+        // outcomes fit in the ring alongside the live orders.
+        uint64_t covered = journal.sequence();
+        check(Persistence::saveState(manager, savePath), "save succeeds");
+        journal.checkpoint(covered);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+void testArchive(const Options& opt) {
+    std::mt19937 rng(opt.seed + 11);
+    // Codec: inputs with long repeats, short alphabets and none at all round-trip exactly; damaged
+    // input is rejected or decodes to the right length, never read out of bounds.
+    for (size_t round = 0; round < 300 * opt.scale; ++round) {
+        std::string raw;
+        size_t size = rng() % 6000;
+        unsigned alphabet = 1 + rng() % 256;
+        while (raw.size() < size) {
+            if (!raw.empty() && rng() % 3 == 0) {
+                size_t from = rng() % raw.size();
+                size_t length = std::min<size_t>(1 + rng() % 300, size - raw.size());
+                for (size_t k = 0; k < length; ++k) raw.push_back(raw[from + k]);
+            } else {
+                raw.push_back(static_cast<char>(rng() % alphabet));
+            }
+        }
+        std::string packed;
+        std::string unpacked;
+        BlockCodec::compress(raw, packed);
+        check(BlockCodec::decompress(packed.data(), packed.size(), raw.size(), unpacked) && unpacked == raw, "codec round-trips");
+        if (packed.empty()) continue;
+        std::string damaged = packed;
+        damaged[rng() % damaged.size()] ^= static_cast<char>(1 + rng() % 255);
+        damaged.resize(rng() % 2 ? damaged.size() : rng() % damaged.size());
+        if (BlockCodec::decompress(damaged.data(), damaged.size(), raw.size(), unpacked)) {
+            check(unpacked.size() == raw.size(), "damaged input decodes to the declared size or fails");
+        }
+    }
+
+    auto dir = std::filesystem::temp_directory_path() / ("restaurant_archive_" + std::to_string(opt.seed));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "orders.archive").string();
+
+    // Live traffic on a clock that moves 7 s per read; every batch archives what finished before
+    // a random cutoff, and the archive must then hold exactly the orders taken so far.
+    VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::seconds(7));
+    OrderManager manager;
+    manager.setClock(&clock);
+    const char* dishes[] = {"Margherita", "Crème brûlée", "Tea, hot", "Soup"};
+    for (const char* dish : dishes) manager.addMenuItem(dish, 5);
+    std::map<int, Order> model;
+    OrderArchive archive;
+    check(archive.open(path), "archive opens");
+    const size_t batches = 4 * opt.scale;
+    for (size_t batch = 0; batch < batches; ++batch) {
+        for (size_t i = 0; i < 3000; ++i) {
+            std::vector<OrderItem> items;
+            for (size_t l = rng() % 4; l > 0; --l) {
+                const char* dish = dishes[rng() % 4];
+                items.push_back(OrderItem{rng() % 5 ? manager.findMenuItem(dish)->itemId : 0, rng() % 5 ? dish : "Off-menu", 1 + static_cast<int>(rng() % 3)});
+            }
+            manager.createOrder("Guest " + std::to_string(rng() % 500), rng() % 5 == 0, std::move(items), 5 + static_cast<int>(rng() % 20));
+            int id = 0;
+            if (rng() % 3 != 0 && manager.nextForKitchen(id)) {
+                manager.readyOrder(id);
+                if (rng() % 4 != 0) manager.serveOrder(id);
+            }
+            if (rng() % 10 == 0) manager.cancelOrder(1 + static_cast<int>(rng() % static_cast<unsigned>(manager.nextIdValue() - 1)));
+        }
+        long long now = TimeUtils::toSeconds(manager.now());
+        long long before = now - static_cast<long long>(rng() % 20000);
+        std::vector<Order> taken;
+        size_t count = manager.takeFinished(before, taken);
+        bool ok = check(count == taken.size(), "takeFinished returns what it moved");
+        for (const Order& o : taken) {
+            long long finished = TimeUtils::toSeconds(o.status == OrderStatus::Served ? o.servedAt : o.placedAt);
+            ok = check((o.status == OrderStatus::Served || o.status == OrderStatus::Cancelled) && finished < before, "only orders finished before the cutoff are taken") && ok;
+            ok = check(manager.getOrder(o.id) == nullptr, "taken orders leave the registry") && ok;
+            model[o.id] = o;
+        }
+        manager.snapshot().forEach([&](const Order& o) {
+            bool finishedBefore = (o.status == OrderStatus::Served && TimeUtils::toSeconds(o.servedAt) < before)
+                               || (o.status == OrderStatus::Cancelled && TimeUtils::toSeconds(o.placedAt) < before);
+            ok = check(!finishedBefore && model.count(o.id) == 0, "snapshots drop taken orders") && ok;
+        });
+        for (const Order& o : manager.servedBetween(0, now + 1)) ok = check(model.count(o.id) == 0, "served index drops taken orders") && ok;
+        check(archive.append(taken), "append succeeds");
+        // Taken orders stay findable by name: indexed on append, and rebuilt on open below.
+        auto checkNames = [&](const char* what) {
+            for (int probe = 0; probe < 20; ++probe) {
+                std::string number = std::to_string(rng() % 60);
+                std::set<int> expected;
+                for (const auto& entry : model) {
+                    if (entry.second.customerName.rfind("Guest " + number, 0) == 0) expected.insert(entry.first);
+                }
+                std::set<int> found;
+                for (const Order& o : archive.findByCustomer("gUEST " + number, 0, false)) found.insert(o.id);
+                ok = check(found == expected, what) && ok;
+            }
+        };
+        checkNames("appended orders are found by name");
+
+        // Reopened from disk each time: the index and blocks must come back exactly.
+        archive.close();
+        check(archive.open(path), "archive reopens");
+        check(archive.orderCount() == model.size(), "archive counts every order");
+        size_t seen = 0;
+        archive.forEach([&](const Order& o) {
+            ++seen;
+            auto it = model.find(o.id);
+            ok = check(it != model.end() && sameOrder(it->second, o), "archived order matches what was taken") && ok;
+        });
+        check(seen == model.size(), "archive holds every order once");
+        checkNames("reopened archive finds orders by name");
+        for (int probe = 0; probe < 200; ++probe) {
+            int id = 1 + static_cast<int>(rng() % static_cast<unsigned>(manager.nextIdValue()));
+            Order found;
+            auto it = model.find(id);
+            bool hit = archive.find(id, found);
+            ok = check(hit == (it != model.end()) && (!hit || sameOrder(it->second, found)), "find matches the model") && ok;
+        }
+        long long first = TimeUtils::toSeconds(TimeUtils::fromSeconds(1717236000LL));
+        for (int probe = 0; probe < 50; ++probe) {
+            long long from = first + static_cast<long long>(rng() % static_cast<unsigned>(now - first + 1));
+            long long to = rng() % 4 == 0 ? 0 : from + static_cast<long long>(rng() % 30000);
+            bool byServed = rng() % 2;
+            std::set<int> expected;
+            for (const auto& entry : model) {
+                const Order& o = entry.second;
+                if (byServed && o.status != OrderStatus::Served) continue;
+                long long at = TimeUtils::toSeconds(byServed ? o.servedAt : o.placedAt);
+                if (at >= from && (to == 0 || at < to)) expected.insert(o.id);
+            }
+            std::set<int> got;
+            archive.forEachInRange(from, to, byServed, [&](const Order& o) { got.insert(o.id); });
+            ok = check(got == expected, "range reports match the model") && ok;
+        }
+        if (!ok) break;
+    }
+    archive.close();
+    std::filesystem::remove_all(dir);
+}
+
+/** Splits RFC 4180 text into records of fields (quoted fields may hold commas, quotes and newlines). */
+std::vector<std::vector<std::string>> parseCsv(const std::string& text) {
+    std::vector<std::vector<std::string>> records(1, std::vector<std::string>(1));
+    bool quoted = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < text.size() && text[i + 1] == '"') {
+                records.back().back().push_back('"');
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                records.back().back().push_back(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            records.back().emplace_back();
+        } else if (c == '\n') {
+            records.emplace_back(1);
+        } else {
+            records.back().back().push_back(c);
+        }
+    }
+    if (records.back().size() == 1 && records.back()[0].empty()) records.pop_back();
+    return records;
+}
+
+void testExport(const Options& opt) {
+    std::mt19937 rng(opt.seed + 13);
+    auto dir = std::filesystem::temp_directory_path() / ("restaurant_export_" + std::to_string(opt.seed));
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+
+    for (size_t round = 0; round < 3 * opt.scale; ++round) {
+        VirtualClock clock(TimeUtils::fromSeconds(1717236000LL), std::chrono::seconds(3));
+        OrderManager manager;
+        manager.setClock(&clock);
+        populate(manager, rng, 500 + rng() % 2500);
+        // Part of the history goes to an archive; the export must cover both, each once.
+        OrderArchive archive;
+        check(archive.open((dir / "orders.archive").string()), "archive opens");
+        std::vector<Order> taken;
+        manager.takeFinished(TimeUtils::toSeconds(manager.now()) + 1 - static_cast<long long>(rng() % 2), taken);
+        archive.append(taken);
+        std::map<int, std::pair<Order, bool>> model;
+        for (const Order& o : taken) model[o.id] = {o, true};
+        OrderSnapshot snapshot = manager.snapshot();
+        snapshot.forEach([&](const Order& o) { model[o.id] = {o, false}; });
+        auto stageOf = [&](const Order& o) { return snapshot.stageName(o.stage >= 0 ? o.stage : static_cast<int>(o.status)); };
+
+        std::string firstCsv;
+        for (auto config : {std::pair<size_t, unsigned>{97, 1}, {97, 3}, {1, 2}, {100000, 0}}) {
+            OrderExport::Options options;
+            options.chunkRows = config.first;
+            options.threads = config.second;
+
+            options.format = OrderExport::Format::Columnar;
+            const std::string columnar = (dir / "orders.ocol").string();
+            OrderExport::Stats stats;
+            bool ok = check(OrderExport::write(snapshot, &archive, columnar, options, &stats), "columnar export succeeds");
+            ok = check(stats.rows == model.size() && stats.archivedRows == taken.size(), "export counts every order once") && ok;
+            ok = check(stats.bytes == std::filesystem::file_size(columnar), "export counts its bytes") && ok;
+            size_t seen = 0;
+            check(OrderExport::readColumnar(columnar, [&](const OrderExport::ColumnarRow& row) {
+                ++seen;
+                auto it = model.find(row.order.id);
+                Order expected = it == model.end() ? Order{} : it->second.first;
+                expected.stage = -1;
+                ok = check(it != model.end() && sameOrder(expected, row.order) && row.stage == stageOf(it->second.first)
+                           && row.archived == it->second.second, "columnar rows read back as exported") && ok;
+            }), "columnar export reads back");
+            ok = check(seen == model.size(), "columnar export holds every order") && ok;
+
+            options.format = OrderExport::Format::Csv;
+            const std::string csv = (dir / "orders.csv").string();
+            ok = check(OrderExport::write(snapshot, &archive, csv, options, &stats), "csv export succeeds") && ok;
+            std::string text;
+            Persistence::readText(csv, text);
+            if (firstCsv.empty()) {
+                firstCsv = text;
+                auto records = parseCsv(text);
+                ok = check(records.size() == model.size() + 1 && records[0].size() == 12 && records[0][0] == "id", "csv has a header and a record per order") && ok;
+                for (size_t i = 1; ok && i < records.size(); ++i) {
+                    const auto& fields = records[i];
+                    auto it = fields.size() == 12 ? model.find(std::atoi(fields[0].c_str())) : model.end();
+                    ok = check(it != model.end() && fields[1] == it->second.first.customerName && fields[4] == stageOf(it->second.first)
+                               && fields[11] == (it->second.second ? "true" : "false"), "csv fields survive quoting") && ok;
+                }
+            } else {
+                ok = check(text == firstCsv, "chunk size and threads do not change the csv") && ok;
+            }
+            if (!ok) break;
+        }
+        archive.close();
+        std::filesystem::remove(dir / "orders.archive");
+    }
+    std::filesystem::remove_all(dir);
+}
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (argc > 1) opt.scale = std::max<size_t>(1, std::strtoul(argv[1], nullptr, 10));
+    if (argc > 2) opt.seed = static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10));
+    std::string only = argc > 3 ? argv[3] : "";
+    std::cout << "Property tests (scale " << opt.scale << ", seed " << opt.seed << ")\n";
+
+    struct Suite {
+        const char* name;
+        void (*run)(const Options&);
+    };
+    const Suite suites[] = {
+        {"IntQueue", testIntQueue},
+        {"VipHeap", testVipHeap},
+        {"OrderList", testOrderList},
+        {"OrderRegistry", testOrderRegistry},
+        {"MenuBST", testMenuBST},
+        {"CustomerIndex", testCustomerIndex},
+        {"Sorts", testSorts},
+        {"Workflow", testWorkflowPull},
+        {"Persistence", testPersistence},
+        {"Replication", testReplication},
+        {"Sharded", testSharded},
+        {"Clock", testClock},
+        {"Journal", testJournal},
+        {"Archive", testArchive},
+        {"Export", testExport},
+        {"Allocations", testAllocations},
+    };
+    for (const auto& suite : suites) {
+        if (!only.empty() && only != suite.name) continue;
+        size_t failuresBefore = gFailures;
+        size_t checksBefore = gChecks;
+        auto start = Clock::now();
+        suite.run(opt);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::cout << (gFailures == failuresBefore ? "PASS " : "FAIL ") << suite.name << ": " << gChecks - checksBefore
+                  << " checks, " << static_cast<long long>(ms) << " ms\n";
+    }
+    std::cout << (gFailures == 0 ? "All tests passed" : "Tests failed") << " (" << gChecks << " checks, " << gFailures << " failures)\n";
+    return gFailures == 0 ? 0 : 1;
+}